@@ -31,7 +31,7 @@ class Stmt;
 
 class Decl : public Stmt {
  public:
-  virtual ::std::string GetIdent() = 0;
+  virtual Symbol GetIdent() = 0;
 
   bool operator==(const Decl &rhs) const {
     return true;
@@ -52,15 +52,15 @@ class Initializer {
  public:
   /**
    * int-- relative location of an element in an array
-   * std::string--a member in a struct or an union
+   * Symbol--a member in a struct or an union
    */
-  using Element = std::variant<int, std::string>;
+  using Element = std::variant<int, Symbol>;
 
   explicit Initializer(Element offset) : offset_(std::move(offset)) {}
 
   explicit Initializer(int offset) : offset_(offset) {}
 
-  explicit Initializer(std::string member) : offset_(member) {}
+  explicit Initializer(Symbol member) : offset_(member) {}
 
   bool operator!=(const Initializer &rhs) const {
     return !(rhs == *this);
@@ -93,8 +93,8 @@ class BaseInitializer : public Initializer {
           : Initializer(offset),
             init_value_(init_value) {}
 
-  BaseInitializer(std::string member, Expr *init_value)
-          : Initializer(std::move(member)),
+  BaseInitializer(Symbol member, Expr *init_value)
+          : Initializer(member),
             init_value_(init_value) {}
 
   bool operator==(const BaseInitializer &rhs) const;
@@ -130,9 +130,9 @@ class InitializerList : public Initializer {
           : Initializer(offset),
             init_list_(std::move(init_list)) {}
 
-  explicit InitializerList(std::string member,
+  explicit InitializerList(Symbol member,
                            std::list<Initializer *> init_list = std::list<Initializer *>())
-          : Initializer(std::move(member)),
+          : Initializer(member),
             init_list_(std::move(init_list)) {}
 
   void AddInit(Initializer *init) {
@@ -179,7 +179,7 @@ class ObjectDecl : public Decl {
     return object_;
   }
 
-  std::string GetIdent() override;
+  Symbol GetIdent() override;
 
   bool operator==(const ObjectDecl &rhs) const;
 
@@ -218,9 +218,7 @@ class FuncDecl : public Decl {
     return func_;
   }
 
-  std::string GetIdent() override {
-    return "";
-  }
+  Symbol GetIdent() override;
 
   bool operator==(const FuncDecl &rhs) const;
 
@@ -258,7 +256,7 @@ class TypeDecl : public Decl {
     return type_;
   }
 
-  std::string GetIdent() override;
+  Symbol GetIdent() override;
 
   bool operator==(const TypeDecl &rhs) const;
 
@@ -10,6 +10,7 @@
 #include <utility>
 #include <variant>
 
+#include "lex/symbol.h"
 #include "lex/token.h"
 
 namespace CCompiler {
@@ -355,7 +356,8 @@ class FuncCall : public Expr {
 
 class Constant : public Expr {
  public:
-  using Const = std::variant<int, float, char, std::string>;
+  //!< string literals are interned without quotes
+  using Const = std::variant<int, float, char, Symbol>;
 
   explicit Constant(int constant)
           : Expr(TokenType::kEmpty),
@@ -369,7 +371,7 @@ class Constant : public Expr {
           : Expr(TokenType::kEmpty),
             const_(constant) {}
 
-  explicit Constant(std::string literal)
+  explicit Constant(Symbol literal)
           : Expr(TokenType::kEmpty),
             const_(literal) {}
 
@@ -9,6 +9,7 @@
 #include <string>
 
 #include "ast/expression.h"
+#include "lex/symbol.h"
 
 namespace CCompiler {
 class Type;
@@ -28,16 +29,16 @@ class Identifier {
   };
 
 
-  Identifier(Type *type, Linkage linkage, ::std::string ident)
+  Identifier(Type *type, Linkage linkage, Symbol ident)
           : type_(type),
             linkage_(linkage),
-            ident_(::std::move(ident)) {}
+            ident_(ident) {}
 
   [[nodiscard]] Linkage GetLinkage() const {
     return linkage_;
   }
 
-  [[nodiscard]] const ::std::string &GetIdent() const {
+  [[nodiscard]] Symbol GetIdent() const {
     return ident_;
   }
 
@@ -56,7 +57,7 @@ class Identifier {
 
  private:
   Type *type_;
-  ::std::string ident_;
+  Symbol ident_;
   Linkage linkage_;
 };
 
@@ -136,11 +137,11 @@ class Function : public Identifier, public Expr {
  public:
   using ParamList = std::list<Identifier *>;
 
-  Function(Type *type, Linkage linkage, std::string ident,
+  Function(Type *type, Linkage linkage, Symbol ident,
            ParamList params,
            CompoundStmt *body = nullptr)
           : Expr(TokenType::kIdentifier),
-            Identifier(type, linkage, std::move(ident)),
+            Identifier(type, linkage, ident),
             params_(std::move(params)),
             body_(body) {}
 
@@ -6,9 +6,9 @@
 #define CCOMPILER_SCOPE_H
 
 #include <list>
-#include <string>
 
 #include "ast/list_util.h"
+#include "lex/symbol.h"
 
 namespace CCompiler {
 class Decl;
@@ -61,24 +61,24 @@ class Scope {
   /**
    * Find an object that has the name ident from the current scope to the
    * outer scope.
-   * @param ident cannot be ""
+   * @param ident cannot be empty
    * @return The object that is declared nearest the current scope. If no
    * valid object exists across reachable scopes, return nullptr.
    */
-  Object *GetObject(const std::string &ident);
+  Object *GetObject(Symbol ident);
 
   /**
-   * It is similar to the GetObject(const std::string &) by checking the tag.
+   * It is similar to the GetObject(Symbol) by checking the tag.
    * @param ident
    * @return
    */
-  TypeDeclType *GetType(const std::string &ident);
+  TypeDeclType *GetType(Symbol ident);
 
   /**
-   * @param ident cannot be ""
+   * @param ident cannot be empty
    * @return A function that have the name ident. Otherwise return nullptr.
    */
-  Function *GetFunc(const std::string &ident);
+  Function *GetFunc(Symbol ident);
 
   [[nodiscard]] Scope *GetParent() const {
     return parent_;
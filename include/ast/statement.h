@@ -10,6 +10,8 @@
 #include <utility>
 #include <variant>
 
+#include "lex/symbol.h"
+
 namespace CCompiler {
 class Expr;
 
@@ -306,9 +308,9 @@ class JumpStmt : public Stmt {
     kReturn
   };
 
-  explicit JumpStmt(JumpType jump, std::string ident = "")
+  explicit JumpStmt(JumpType jump, Symbol ident = {})
           : jump_(jump),
-            ident_(std::move(ident)) {}
+            ident_(ident) {}
 
   virtual ~JumpStmt() = default;
 
@@ -330,7 +332,7 @@ class JumpStmt : public Stmt {
 
  private:
   JumpType jump_;
-  std::string ident_;  //!< only for goto statement
+  Symbol ident_;  //!< only for goto statement
 };
 
 bool operator==(const JumpStmt &lhs, const JumpStmt &rhs);
@@ -55,7 +55,7 @@ class TranslationUnit {
   void AddExternalDef(TypeDecl *type_decl) {
     // TODO(dxy): typedef permits multiple definitions
     // type declared with no tag doesn't have to consider redefinition
-    if (!type_decl->GetIdent().empty()) {
+    if (!type_decl->GetIdent().Empty()) {
       if (file_scope_->GetType(type_decl->GetIdent()) != nullptr) {
         exit(-1);
       }
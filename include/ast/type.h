@@ -9,6 +9,8 @@
 #include <string>
 #include <utility>
 
+#include "lex/symbol.h"
+
 namespace CCompiler {
 class Identifier;
 
@@ -202,9 +204,9 @@ class TypeDeclType : public Type {
   bool operator==(const TypeDeclType &lhs, const TypeDeclType &rhs);
 
  public:
-  explicit TypeDeclType(std::string ident) : ident_(std::move(ident)) {}
+  explicit TypeDeclType(Symbol ident) : ident_(ident) {}
 
-  [[nodiscard]] const std::string &GetIdent() const {
+  [[nodiscard]] Symbol GetIdent() const {
     return ident_;
   }
 
@@ -221,7 +223,7 @@ class TypeDeclType : public Type {
   }
 
  private:
-  std::string ident_;
+  Symbol ident_;
 };
 
 bool operator==(const TypeDeclType &lhs, const TypeDeclType &rhs);
@@ -231,8 +233,8 @@ using MemberList = std::list<Identifier *>;
 
 class StructUnionType : public TypeDeclType {
  public:
-  explicit StructUnionType(bool flag, std::string tag = "")
-          : TypeDeclType(std::move(tag)),
+  explicit StructUnionType(bool flag, Symbol tag = {})
+          : TypeDeclType(tag),
             flag_(flag) {}
 
   void AddMember(Identifier *ident) {
@@ -261,7 +263,7 @@ class StructUnionType : public TypeDeclType {
 class EnumType : public TypeDeclType {
  public:
   struct Enumerator {
-    std::string ident_;
+    Symbol ident_;
     int value_{-1};  //!< -1 represents no appointed value.
 
     bool operator==(const Enumerator &rhs) const {
@@ -273,7 +275,7 @@ class EnumType : public TypeDeclType {
     }
   };
 
-  explicit EnumType(std::string tag) : TypeDeclType(std::move(tag)) {}
+  explicit EnumType(Symbol tag) : TypeDeclType(tag) {}
 
   void AddEnumerator(const Enumerator &enumerator) {
     enumerators_.push_back(enumerator);
@@ -13,9 +13,24 @@ enum class TokenType;
 
 class Environment {
  public:
+  /**
+   * Build the lexer automaton from regex_rules_, unless the scanner
+   * generated at build time is made from the same rules.
+   */
   static void EnvironmentInit();
 
+  [[nodiscard]] static const std::map<std::string, TokenType> &
+  GetRegexRules() {
+    return regex_rules_;
+  }
+
  private:
+  /**
+   * If the full DFA of the rules needs more states, it isn't built and
+   * lexers use a LazyDfa.
+   */
+  static constexpr int kMaxDfaStates = 1 << 16;
+
   /**
    * map regex rules from string to integer
    */
@@ -0,0 +1,134 @@
+//
+// Created by dxy on 2020/12/12.
+//
+
+#ifndef CCOMPILER_BYTE_SCAN_H
+#define CCOMPILER_BYTE_SCAN_H
+
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace CCompiler {
+using StrConstIt = std::string_view::const_iterator;
+
+/**
+ * Instruction sets used by the scanners below. kAvx2 and kSse2 are only
+ * available on x86-64.
+ */
+enum class SimdLevel {
+  kScalar, kSse2, kAvx2
+};
+
+/**
+ * @return the best level supported by the running CPU. It is detected
+ * once.
+ */
+SimdLevel BestSimdLevel();
+
+/**
+ * A set of bytes made up of at most kMaxRanges ranges [lows[i], highs[i]].
+ * A few ranges are enough for runs in a lexer, like [0-9A-Z_a-z] for
+ * identifiers or [\t\n\r ] for white spaces, and each range costs two
+ * instructions per vector.
+ */
+struct ByteRanges {
+  static constexpr int kMaxRanges = 4;
+
+  int count{0};
+  unsigned char lows[kMaxRanges]{};
+  unsigned char highs[kMaxRanges]{};
+  // the same set as a bitmap for scalar code
+  std::uint64_t bits[4]{};
+
+  /**
+   * @param bytes bytes[c] is whether c is in the set
+   * @return If the set needs more than kMaxRanges ranges, it returns a set
+   * whose count is 0.
+   */
+  static ByteRanges FromBytes(const bool (&bytes)[256]);
+
+  /**
+   * @param ranges at most kMaxRanges pairs of [low, high]
+   * @return
+   */
+  static constexpr ByteRanges FromRanges(
+          std::initializer_list<std::pair<unsigned char, unsigned char>>
+          ranges) {
+    ByteRanges byte_ranges;
+    for (auto [low, high]:ranges) {
+      byte_ranges.lows[byte_ranges.count] = low;
+      byte_ranges.highs[byte_ranges.count] = high;
+      byte_ranges.count++;
+      for (int c = low; c <= high; ++c) {
+        byte_ranges.bits[c / 64] |= std::uint64_t{1} << (c % 64);
+      }
+    }
+    return byte_ranges;
+  }
+
+  [[nodiscard]] bool Contains(unsigned char c) const {
+    return (bits[c / 64] >> (c % 64)) & 1;
+  }
+};
+
+/**
+ * @param begin
+ * @param end
+ * @param ranges
+ * @param level
+ * @return the first byte in [begin, end) that isn't in ranges or end
+ */
+StrConstIt SkipRanges(StrConstIt begin, StrConstIt end,
+                      const ByteRanges &ranges, SimdLevel level);
+
+/**
+ * Most runs in source code are short, so the first kScalarPrefix bytes are
+ * checked inline before calling the vectorized scanner.
+ */
+inline StrConstIt SkipRanges(StrConstIt begin, StrConstIt end,
+                             const ByteRanges &ranges) {
+  const int kScalarPrefix = 16;
+  for (int i = 0; i < kScalarPrefix; ++i, ++begin) {
+    if (begin == end || !ranges.Contains(*begin)) {
+      return begin;
+    }
+  }
+  return SkipRanges(begin, end, ranges, BestSimdLevel());
+}
+
+/**
+ * @param begin
+ * @param end
+ * @param first
+ * @param second
+ * @param level
+ * @return the first location of the two bytes 'first' 'second' in
+ * [begin, end) or end
+ */
+StrConstIt FindPair(StrConstIt begin, StrConstIt end, char first,
+                    char second, SimdLevel level = BestSimdLevel());
+
+/**
+ * @return the first c in [begin, end) or end. It uses memchr(), which is
+ * already vectorized by the C library.
+ */
+StrConstIt FindByte(StrConstIt begin, StrConstIt end, char c);
+
+/**
+ * @param begin
+ * @param end
+ * @param c
+ * @param offsets offsets of every c in [begin, end) from begin are appended
+ * to it
+ * @param level
+ */
+void FindAll(StrConstIt begin, StrConstIt end, char c,
+             std::vector<std::uint32_t> &offsets,
+             SimdLevel level = BestSimdLevel());
+}
+
+#endif // CCOMPILER_BYTE_SCAN_H
@@ -0,0 +1,296 @@
+//
+// Created by dxy on 2020/12/2.
+//
+
+#ifndef CCOMPILER_DFA_H
+#define CCOMPILER_DFA_H
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "lex/byte_scan.h"
+#include "lex/keyword_table.h"
+#include "lex/nfa.h"
+
+namespace CCompiler {
+/**
+ * A table-driven DFA compiled from a Nfa by subset construction. Input bytes
+ * are first mapped to equivalence classes through a 256-entry table and
+ * every state owns a dense row of transitions indexed by the class, so a
+ * match only costs two loads per character and never allocates.
+ *
+ * It keeps the semantics of Nfa::NextMatch(): the longest match wins and a
+ * tie between several accept states is broken by choosing the smallest
+ * TokenType.
+ *
+ * States that loop on a few byte ranges, like the middle of an identifier
+ * or a run of white spaces, are accelerated: the run is skipped with
+ * SkipRanges() instead of one transition per byte.
+ */
+class Dfa {
+ public:
+  Dfa() = default;
+
+  /**
+   * @param nfa
+   * @param max_states Subset construction may need exponentially many
+   * states. If more than max_states states are needed, it stops and the DFA
+   * is left empty, so that a LazyDfa can be used instead.
+   */
+  explicit Dfa(const Nfa &nfa,
+               int max_states = std::numeric_limits<int>::max());
+
+  /**
+   * Get the next match in [begin, end). It works like Nfa::NextMatch() but
+   * returns the accept state by value.
+   *
+   * @param begin
+   * @param end
+   * @return If no match exists, it returns std::nullopt.
+   */
+  [[nodiscard]] std::optional<AcceptState> NextMatch(StrConstIt begin,
+                                                     StrConstIt end) const;
+
+  /**
+   * It is used to determine whether the DFA has been built.
+   *
+   * @return
+   */
+  [[nodiscard]] bool Empty() const {
+    return state_count_ <= 1;
+  }
+
+  /**
+   * Merge equivalent states with Hopcroft's algorithm. States are first
+   * partitioned by their accept TokenType and then split until every block
+   * has consistent transitions. Finally states are renumbered in BFS order
+   * from the start state so that states used together sit next to each other
+   * in the table.
+   */
+  void Minimize();
+
+  [[nodiscard]] int StateCount() const {
+    return state_count_;
+  }
+
+  /**
+   * @return number of byte equivalence classes, i.e. the width of a row
+   */
+  [[nodiscard]] int ClassCount() const {
+    return class_count_;
+  }
+
+  /**
+   * @return keywords classified after a match, see KeywordTable
+   */
+  [[nodiscard]] const KeywordTable &GetKeywords() const {
+    static const KeywordTable kEmptyKeywords;
+    return keywords_ ? *keywords_ : kEmptyKeywords;
+  }
+
+  [[nodiscard]] int GetStartState() const {
+    return start_state_;
+  }
+
+  [[nodiscard]] int GetNextState(int state, unsigned char c) const {
+    return transitions_[state * class_count_ + byte_classes_[c]];
+  }
+
+  /**
+   * @param state
+   * @return bytes on which state moves to itself, or an empty set if the
+   * state isn't accelerated
+   */
+  [[nodiscard]] const ByteRanges &GetAcceleration(int state) const {
+    return accelerations_[state];
+  }
+
+  /**
+   * @param state
+   * @return the TokenType of state or kNotAccept
+   */
+  [[nodiscard]] int GetAcceptType(int state) const {
+    return accept_types_[state];
+  }
+
+  /**
+   * @return bytes occupied by the class map, transitions and accept types
+   */
+  [[nodiscard]] std::size_t TableSize() const {
+    return (kAlphabetSize + static_cast<std::size_t>(state_count_) *
+                            (class_count_ + 1)) * sizeof(int);
+  }
+
+  /**
+   * Write the DFA to path in a versioned binary format. The file is written
+   * to a temporary file first and renamed, so a reader never sees a partial
+   * table.
+   *
+   * @param path
+   * @param fingerprint identify the rules the DFA is compiled from
+   * @return whether the file is written successfully
+   */
+  bool Save(const std::string &path, std::uint64_t fingerprint) const;
+
+  /**
+   * Map a file written by Save(). The table is used in place from the
+   * read-only mapping without being copied.
+   *
+   * @param path
+   * @param fingerprint
+   * @return If the file doesn't exist, has a different version or
+   * fingerprint, fails the checksum or holds a state or a token type out of
+   * range, it returns std::nullopt.
+   */
+  static std::optional<Dfa> Load(const std::string &path,
+                                 std::uint64_t fingerprint);
+
+  /**
+   * Split bytes into classes that no NFA state can tell apart. Two bytes are
+   * in the same class when they are in the same range of the NFA and every
+   * functional state matches both or neither of them.
+   *
+   * @param nfa
+   * @param byte_classes byte_classes[c] is set to the class of byte c
+   * @return number of classes
+   */
+  static int ByteClasses(const Nfa &nfa, std::vector<int> &byte_classes);
+
+  /**
+   * @param regex_rules
+   * @return a hash of the rules that changes whenever a rule, the file
+   * format or the engine changes
+   */
+  static std::uint64_t Fingerprint(
+          const std::map<std::string, TokenType> &regex_rules);
+
+  static constexpr int kDeadState = 0;
+  static constexpr int kNotAccept = -1;
+  static constexpr int kAlphabetSize = 256;
+  static constexpr std::uint32_t kFormatVersion = 3;
+  // changed with the way a table is built from the rules, like the byte
+  // classes or the minimization, so that older tables are rebuilt
+  static constexpr std::uint32_t kEngineVersion = 1;
+
+ private:
+  using NfaStateSet = std::set<int>;
+
+  /**
+   * A table that is being built or minimized.
+   */
+  struct Table {
+    int start_state{kDeadState};
+    int class_count{1};
+    /**
+     * byte_classes[c] is the equivalence class of byte c.
+     */
+    std::vector<int> byte_classes = std::vector<int>(kAlphabetSize, 0);
+    /**
+     * accept_types[state] is the TokenType of the state or kNotAccept.
+     */
+    std::vector<int> accept_types;
+    /**
+     * transitions[state * class_count + byte_class] is the next state of
+     * 'state' after consuming a byte in byte_class.
+     */
+    std::vector<int> transitions;
+
+    [[nodiscard]] int StateCount() const {
+      return static_cast<int>(accept_types.size());
+    }
+
+    /**
+     * Add a state whose edges all point to the dead state.
+     *
+     * @param accept_type
+     * @return the new state
+     */
+    int NewState(int accept_type);
+
+    /**
+     * Rebuild the table so that old state 'i' becomes 'new_states[i]'.
+     * States mapping to the same new state must be equivalent.
+     *
+     * @param new_states
+     * @param state_count number of states after renumbering
+     */
+    void Renumber(const std::vector<int> &new_states, int state_count);
+
+    /**
+     * @return a map from old states to new states in BFS order from the
+     * start state while the dead state is kept as state 0
+     */
+    [[nodiscard]] std::vector<int> BfsOrder() const;
+
+    /**
+     * Merge byte classes whose columns are the same in every state.
+     */
+    void MergeClasses();
+  };
+
+  /**
+   * Publish table as the immutable storage of the DFA.
+   *
+   * @param table
+   */
+  void Assign(Table table);
+
+  /**
+   * Fill accelerations_ according to the transitions.
+   */
+  void AccelerationsInit();
+
+  /**
+   * Add 'state' and all common states reachable from it through empty
+   * edges to 'states'. Functional states are added but not expanded since
+   * they must consume a character first.
+   *
+   * @param nfa
+   * @param state
+   * @param states
+   */
+  static void Closure(const Nfa &nfa, int state, NfaStateSet &states);
+
+  /**
+   * @param nfa
+   * @param states
+   * @param c
+   * @return all NFA states reachable from 'states' by consuming 'c'
+   */
+  static NfaStateSet Move(const Nfa &nfa, const NfaStateSet &states,
+                          unsigned char c);
+
+  /**
+   * @param nfa
+   * @param states
+   * @return the smallest TokenType among accept states in 'states' or
+   * kNotAccept
+   */
+  static int AcceptType(const Nfa &nfa, const NfaStateSet &states);
+
+  int start_state_{kDeadState};
+  int state_count_{0};
+  int class_count_{1};
+  // They point into storage_ and have the same layout as Table.
+  const int *byte_classes_{nullptr};
+  const int *accept_types_{nullptr};
+  const int *transitions_{nullptr};
+  /**
+   * Either a Table or a MappedFile. The storage is never modified after
+   * construction, so copies of a Dfa share it.
+   */
+  std::shared_ptr<const void> storage_;
+  std::vector<ByteRanges> accelerations_;
+  /**
+   * nullptr if the rules have no keywords
+   */
+  std::shared_ptr<const KeywordTable> keywords_;
+};
+}
+
+#endif // CCOMPILER_DFA_H
@@ -0,0 +1,34 @@
+//
+// Created by dxy on 2020/12/9.
+//
+
+#ifndef CCOMPILER_GENERATED_SCANNER_H
+#define CCOMPILER_GENERATED_SCANNER_H
+
+#include <cstdint>
+#include <optional>
+
+#include "lex/nfa.h"
+
+namespace CCompiler {
+/**
+ * The scanner is generated by ccompiler-lexgen from
+ * Environment::regex_rules_ at build time and is only linked when
+ * CCOMPILER_GENERATED_SCANNER is defined.
+ *
+ * It works like Dfa::NextMatch() for the DFA compiled from the rules.
+ *
+ * @param begin
+ * @param end
+ * @return If no match exists, it returns std::nullopt.
+ */
+std::optional<AcceptState> GeneratedNextMatch(StrConstIt begin,
+                                              StrConstIt end);
+
+/**
+ * Dfa::Fingerprint() of the rules the scanner is generated from.
+ */
+extern const std::uint64_t kGeneratedScannerFingerprint;
+}
+
+#endif // CCOMPILER_GENERATED_SCANNER_H
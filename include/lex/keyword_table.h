@@ -0,0 +1,182 @@
+//
+// Created by dxy on 2020/12/11.
+//
+
+#ifndef CCOMPILER_KEYWORD_TABLE_H
+#define CCOMPILER_KEYWORD_TABLE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace CCompiler {
+enum class TokenType;
+
+using StrConstIt = std::string_view::const_iterator;
+
+/**
+ * Keywords are literal rules, like "while", whose whole spelling is also
+ * matched by another rule with a larger TokenType, like the identifier
+ * rule. The other rule is called the host of the keyword. Instead of being
+ * compiled into the automaton, keywords are recognized by looking up the
+ * lexeme of a host match in a perfect hash table, which keeps the automaton
+ * small.
+ */
+class KeywordTable {
+ public:
+  /**
+   * A slot of the hash table. The spelling of the keyword is
+   * spellings[offset, offset + length). An empty slot has a host of -1.
+   */
+  struct Slot {
+    int offset;
+    int length;
+    int type;
+    int host;
+  };
+
+  KeywordTable() = default;
+
+  /**
+   * Move keywords out of regex_rules.
+   *
+   * @param regex_rules Keyword rules are erased and other rules are kept.
+   * @return
+   */
+  static KeywordTable Extract(std::map<std::string, TokenType> &regex_rules);
+
+  [[nodiscard]] bool Empty() const {
+    return hosts_.empty();
+  }
+
+  /**
+   * @param type TokenType of a match
+   * @param begin
+   * @param end
+   * @return the TokenType of the keyword if [begin, end) is a keyword
+   * hosted by type, otherwise type
+   */
+  [[nodiscard]] TokenType Classify(TokenType type, StrConstIt begin,
+                                   StrConstIt end) const {
+    for (auto host:hosts_) {
+      if (static_cast<int>(type) == host) {
+        return Lookup(slots_.data(), mask_, seed_, spellings_.data(), type,
+                      begin, end);
+      }
+    }
+    return type;
+  }
+
+  /**
+   * The lookup shared by the table and scanners generated from it.
+   *
+   * @param slots
+   * @param mask number of slots - 1
+   * @param seed
+   * @param spellings
+   * @param type
+   * @param begin
+   * @param end
+   * @return see Classify()
+   */
+  static TokenType Lookup(const Slot *slots, std::uint32_t mask,
+                          std::uint32_t seed, const char *spellings,
+                          TokenType type, StrConstIt begin, StrConstIt end) {
+    auto &slot = slots[Hash(seed, begin, end) & mask];
+    if (slot.host == static_cast<int>(type) && slot.length == end - begin &&
+        std::equal(begin, end, spellings + slot.offset)) {
+      return static_cast<TokenType>(slot.type);
+    }
+    return type;
+  }
+
+  /**
+   * 32-bit FNV-1a hash starting from seed.
+   *
+   * @param seed
+   * @param begin
+   * @param end
+   * @return
+   */
+  static std::uint32_t Hash(std::uint32_t seed, StrConstIt begin,
+                            StrConstIt end) {
+    std::uint32_t hash = 2166136261u ^ seed;
+    for (auto it = begin; it != end; ++it) {
+      hash ^= static_cast<unsigned char>(*it);
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+
+  /**
+   * @return the keywords in a format read by Deserialize()
+   */
+  [[nodiscard]] std::string Serialize() const;
+
+  /**
+   * @param data
+   * @param size
+   * @return If data isn't written by Serialize(), it returns std::nullopt.
+   */
+  static std::optional<KeywordTable> Deserialize(const char *data,
+                                                 std::size_t size);
+
+  [[nodiscard]] const std::vector<Slot> &GetSlots() const {
+    return slots_;
+  }
+
+  [[nodiscard]] std::uint32_t GetMask() const {
+    return mask_;
+  }
+
+  [[nodiscard]] std::uint32_t GetSeed() const {
+    return seed_;
+  }
+
+  [[nodiscard]] const std::string &GetSpellings() const {
+    return spellings_;
+  }
+
+  [[nodiscard]] const std::vector<int> &GetHosts() const {
+    return hosts_;
+  }
+
+ private:
+  struct Keyword {
+    std::string spelling;
+    int type;
+    int host;
+  };
+
+  /**
+   * Search a seed so that no two keywords share a slot.
+   *
+   * @param keywords Spellings must be different.
+   */
+  explicit KeywordTable(std::vector<Keyword> keywords);
+
+  /**
+   * @param regex
+   * @return the string matched by regex if it is made up of plain and
+   * escaped characters only
+   */
+  static std::optional<std::string> Literal(const std::string &regex);
+
+  std::vector<Keyword> keywords_;
+  std::vector<Slot> slots_;
+  std::uint32_t mask_{0};
+  std::uint32_t seed_{0};
+  std::string spellings_;
+  /**
+   * TokenTypes hosting at least one keyword
+   */
+  std::vector<int> hosts_;
+};
+}
+
+#endif // CCOMPILER_KEYWORD_TABLE_H
@@ -0,0 +1,208 @@
+//
+// Created by dxy on 2020/12/15.
+//
+
+#ifndef CCOMPILER_LAZY_DFA_H
+#define CCOMPILER_LAZY_DFA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "lex/nfa.h"
+
+namespace CCompiler {
+/**
+ * A DFA built on the fly from a Nfa, like the one in RE2. A DFA state is a
+ * set of NFA states and is only created when a match first reaches it, so
+ * states the input never visits cost nothing. It helps rules whose full
+ * subset construction explodes.
+ *
+ * States are cached until they take more than the memory limit, and then
+ * the cache is flushed and rebuilt from the current input. When flushes
+ * happen too often for the input they cover, the cache is thrashing and
+ * matches fall back to Nfa::NextMatch().
+ *
+ * It keeps the semantics of Nfa::NextMatch(). The cache is modified by
+ * matching, so an instance must not be shared by threads.
+ *
+ * A match takes O(n) time after the states it visits are cached and
+ * O(n * m) time when they are built, where n is the length scanned and m
+ * is the number of NFA states. Searching all matches of a text from left
+ * to right may scan a location again for every match before it, which is
+ * O(n^2 * m) in total, unless a FailureMemo is given.
+ */
+class LazyDfa {
+ public:
+  static constexpr std::size_t kDefaultMemoryLimit = 1 << 20;
+
+  /**
+   * Pairs of a state and a location of a text from which no accept state
+   * can be reached, recorded by NextMatch() for later matches of the same
+   * text, which is the method of "Maximal-munch tokenization in linear
+   * time" by Reps.
+   *
+   * Only runs of at least kMinFailureRun failures are recorded, since
+   * shorter ones are cheaper to scan again than to remember. A pair in a
+   * longer run is scanned at most once, so all matches of a text take
+   * O(n * (states + kMinFailureRun)) time.
+   *
+   * It is cleared when the cache of its LazyDfa is flushed, since states
+   * are renumbered. A thrashing LazyDfa doesn't use it.
+   */
+  class FailureMemo {
+   public:
+    static constexpr int kMinFailureRun = 32;
+
+    void Clear() {
+      failures_.clear();
+      last_location_ = nullptr;
+    }
+
+   private:
+    friend class LazyDfa;
+
+    struct FailureHash {
+      std::size_t operator()(
+              const std::pair<int, const char *> &failure) const {
+        return std::hash<const char *>()(failure.second) * 31 +
+               failure.first;
+      }
+    };
+
+    [[nodiscard]] bool Contains(int state, const char *location) const {
+      return location <= last_location_ &&
+             failures_.count({state, location}) != 0;
+    }
+
+    std::unordered_set<std::pair<int, const char *>, FailureHash> failures_;
+    // the last location of failures_, past which nothing is looked up
+    const char *last_location_{nullptr};
+    int flush_count_{0};
+  };
+
+  /**
+   * @param nfa It must outlive the LazyDfa.
+   * @param memory_limit bytes of cached states
+   */
+  explicit LazyDfa(const Nfa &nfa,
+                   std::size_t memory_limit = kDefaultMemoryLimit);
+
+  /**
+   * Get the next match in [begin, end). It works like Dfa::NextMatch().
+   *
+   * @param begin
+   * @param end
+   * @param memo If it isn't nullptr, scanning stops at known failures and
+   * records new ones. It must only be used for one text with one end.
+   * @return If no match exists, it returns std::nullopt.
+   */
+  std::optional<AcceptState> NextMatch(StrConstIt begin, StrConstIt end,
+                                       FailureMemo *memo = nullptr);
+
+  /**
+   * @return number of states in the cache, including the dead state
+   */
+  [[nodiscard]] int StateCount() const {
+    return static_cast<int>(accept_types_.size());
+  }
+
+  [[nodiscard]] int FlushCount() const {
+    return flush_count_;
+  }
+
+  /**
+   * @return whether matches fall back to the NFA
+   */
+  [[nodiscard]] bool Thrashing() const {
+    return thrashing_;
+  }
+
+  static constexpr int kDeadState = 0;
+  static constexpr int kUnknownState = -1;
+  static constexpr int kNotAccept = -1;
+
+ private:
+  /**
+   * Flushes are only judged after kMinFlushes of them. Then the cache is
+   * thrashing if it covered less than kMinBytesPerState bytes of input per
+   * state it built.
+   */
+  static constexpr int kMinFlushes = 3;
+  static constexpr int kMinBytesPerState = 10;
+
+  struct StateBitsHash {
+    std::size_t operator()(const Nfa::StateBits &states) const;
+  };
+
+  /**
+   * @param states
+   * @return the DFA state of states, which is added if it isn't cached. If
+   * the cache is full, it is flushed first, and if it is thrashing, it
+   * returns kUnknownState instead.
+   */
+  int GetState(Nfa::StateBits states);
+
+  /**
+   * Drop all states except the dead state and the start state.
+   */
+  void Flush();
+
+  /**
+   * @param state
+   * @param c
+   * @return the next state of state after consuming *c, which is added to
+   * the cache, or kUnknownState if the cache is thrashing
+   */
+  int AddTransition(int state, StrConstIt c);
+
+  /**
+   * Record that no accept state is reached from the states a match went
+   * through after its last accept state.
+   *
+   * @param state the state at location
+   * @param location the end of the match or where it began if it failed
+   * @param stop where the match stopped
+   * @param end
+   * @param memo
+   */
+  void AddFailures(int state, StrConstIt location, StrConstIt stop,
+                   StrConstIt end, FailureMemo &memo) const;
+
+  /**
+   * @return bytes used by a cached state
+   */
+  [[nodiscard]] std::size_t StateBytes() const;
+
+  const Nfa &nfa_;
+  std::size_t memory_limit_;
+  int class_count_;
+  /**
+   * byte_classes_[c] is the equivalence class of byte c, see
+   * Dfa::ByteClasses().
+   */
+  std::vector<int> byte_classes_;
+  int start_state_{kDeadState};
+  /**
+   * transitions_[state * class_count_ + byte_class] is the next state or
+   * kUnknownState if it isn't computed yet.
+   */
+  std::vector<int> transitions_;
+  std::vector<int> accept_types_;
+  std::unordered_map<Nfa::StateBits, int, StateBitsHash> state_ids_;
+  /**
+   * NFA states of every DFA state, pointing into the keys of state_ids_
+   */
+  std::vector<const Nfa::StateBits *> state_sets_;
+  int flush_count_{0};
+  // input consumed since the last flush
+  std::size_t bytes_since_flush_{0};
+  bool thrashing_{false};
+};
+}
+
+#endif // CCOMPILER_LAZY_DFA_H
@@ -6,28 +6,78 @@
 #define CCOMPILER_LEXER_H
 
 #include <fstream>
-#include <sstream>
+#include <memory>
+#include <optional>
+#include <string>
 #include <vector>
 
+#include "lex/dfa.h"
+#include "lex/lazy_dfa.h"
+#include "lex/nfa.h"
+#include "lex/source_buffer.h"
+#include "lex/stream_buffer.h"
+#include "lex/token_stream.h"
+
 namespace CCompiler {
 class Token;
 
-class Nfa;
-
-using StrConstIt = std::string::const_iterator;
-
+/**
+ * Lexers keep all scanning state in the instance and share the compiled
+ * automaton read-only, so different lexers can run on different threads.
+ * Environment::EnvironmentInit() must finish before lexers are created.
+ */
 class Lexer {
   friend class Environment;
 
  public:
-  explicit Lexer(std::ifstream &source_file) : line_(0), column_(0) {
-    source_stream_ << source_file.rdbuf();
+  /**
+   * Read the whole file into a buffer. Prefer SourceBuffer::Open(), which
+   * maps the file instead of copying it, or Lexer(int, std::size_t) for
+   * files that don't fit in memory.
+   *
+   * @param source_file
+   */
+  explicit Lexer(std::ifstream &source_file);
+
+  /**
+   * Lex a file descriptor, like a pipe or a file larger than the memory,
+   * through a window of buffer_size bytes. The window is refilled at the
+   * end of a line that isn't continued by a backslash, so no lexeme is cut
+   * unless a single line is longer than the window.
+   *
+   * A token is only valid until the lexer reads more of the file, which may
+   * happen in any later Next() or Peek(), so copy GetToken() to keep it.
+   * Peeked tokens and tokens rolled back since then are kept valid. Offsets
+   * wrap around after 4 GiB, and GetLocation() only works for tokens in the
+   * window. There is no SourceBuffer, so TokenizeAll() and GetSource()
+   * can't be used.
+   *
+   * @param fd It is read from its current position and isn't closed.
+   * @param buffer_size
+   */
+  explicit Lexer(int fd,
+                 std::size_t buffer_size = StreamBuffer::kDefaultCapacity)
+          : automaton_(shared_automaton_),
+            stream_(std::make_unique<StreamBuffer>(fd, buffer_size)) {
+    // the window is empty until the first Refill()
+    cursor_ = source_end_ = stream_->GetText().cbegin();
   }
 
   explicit Lexer(const std::string &source_string)
-          : line_(0),
-            column_(0),
-            source_stream_(source_string) {}
+          : automaton_(shared_automaton_) {
+    SourceInit(std::make_shared<const SourceBuffer>(source_string));
+  }
+
+  /**
+   * Lex a shared buffer, like a file mapped by SourceBuffer::Open(), without
+   * copying it.
+   *
+   * @param source
+   */
+  explicit Lexer(std::shared_ptr<const SourceBuffer> source)
+          : automaton_(shared_automaton_) {
+    SourceInit(std::move(source));
+  }
 
   /**
    * Get and consume the next token.
@@ -43,30 +93,167 @@ class Lexer {
    */
   Token Peek();
 
+  /**
+   * Consume all remaining tokens in one loop, including tokens that are
+   * peeked or rolled back.
+   *
+   * @return
+   */
+  TokenStream TokenizeAll();
+
   /**
    * Add a consumed token back to the Lexer.
    * @param token
    */
   void Rollback(const Token &token);
 
+  /**
+   * Lex source on chunk_count threads. The source is split into chunks at
+   * line boundaries that aren't continued by a backslash, and every chunk
+   * is lexed speculatively as if it doesn't start in a block comment, which
+   * is then the only state that crosses the boundaries. A chunk is lexed
+   * again when the previous chunk turns out to end in a comment.
+   *
+   * @param source
+   * @param chunk_count usually std::thread::hardware_concurrency()
+   * @return the same tokens as calling Next() until the end
+   */
+  static std::vector<Token> LexParallel(
+          const std::shared_ptr<const SourceBuffer> &source, int chunk_count);
+
+  /**
+   * @param token a token of this lexer
+   * @return
+   */
+  [[nodiscard]] SourceLocation GetLocation(const Token &token) const {
+    if (stream_ != nullptr) {
+      return stream_->GetLocation(
+              token.GetToken().data() - stream_->GetText().data());
+    }
+    return source_->GetLocation(token.GetOffset());
+  }
+
+  /**
+   * @return the buffer that tokens point into or nullptr when reading a file
+   * descriptor
+   */
+  [[nodiscard]] const std::shared_ptr<const SourceBuffer> &GetSource() const {
+    return source_;
+  }
+
  private:
   /**
-   * It gets a token from source_file_stream_. It can automatically
+   * Automata built by Environment::EnvironmentInit(). They are never
+   * modified after being published, and each lexer keeps the one that was
+   * current when it was created.
+   */
+  struct Automaton {
+    Nfa nfa = Nfa(std::map<std::string, TokenType>());
+    // compiled from nfa, or empty if it needs too many states
+    Dfa dfa;
+    // whether GeneratedNextMatch() is linked and built from the current rules
+    bool use_generated_scanner{false};
+  };
+
+  /**
+   * Lex [begin, end) of source.
+   *
+   * @param source
+   * @param begin the beginning of a line
+   * @param end
+   * @param in_comment whether begin is in a block comment
+   */
+  Lexer(std::shared_ptr<const SourceBuffer> source, StrConstIt begin,
+        StrConstIt end, bool in_comment);
+
+  void SourceInit(std::shared_ptr<const SourceBuffer> source) {
+    source_ = std::move(source);
+    cursor_ = source_->GetText().cbegin();
+    source_end_ = source_->GetText().cend();
+  }
+
+  /**
+   * @param text
+   * @param new_line a '\n' in text
+   * @return whether the line ending at new_line is continued by a backslash
+   */
+  static bool IsContinued(std::string_view text, StrConstIt new_line) {
+    if (new_line != text.cbegin() && *(new_line - 1) == '\r') {
+      new_line--;
+    }
+    return new_line != text.cbegin() && *(new_line - 1) == '\\';
+  }
+
+  /**
+   * @param it a location in the text being lexed
+   * @return the offset of it in the source
+   */
+  [[nodiscard]] std::uint32_t GetOffset(StrConstIt it) const {
+    if (stream_ != nullptr) {
+      return stream_->GetOffset(it - stream_->GetText().cbegin());
+    }
+    return it - source_->GetText().cbegin();
+  }
+
+  /**
+   * Move cursor_ after the end of the block comment it is in.
+   */
+  void SkipBlockComment();
+
+  /**
+   * Refill stream_ and lex the new bytes up to the last line that isn't
+   * continued. The bytes of tokens_ are kept, so peeked tokens stay valid,
+   * and the window grows if they fill it.
+   *
+   * @return If it isn't reading a file descriptor or the file ends, it
+   * returns false.
+   */
+  bool Refill();
+
+  /**
+   * It gets a token from source_ in one pass over the buffer, where new
+   * lines are delimiters like other white spaces. It can automatically
    * exclude some useless and invalid tokens.
    *
    * @return If no valid token remains, it returns an empty token.
    */
   Token NextToken();
 
-  Token NextTokenInLine(StrConstIt &begin, StrConstIt &end);
+  /**
+   * Match the longest token from begin. It prefers the scanner generated at
+   * build time, then the DFA when it has been built and falls back to
+   * lazy_dfa_ otherwise.
+   *
+   * Only lazy_dfa_ remembers failures (see LazyDfa::FailureMemo). The other
+   * automata may scan a location again for every token before it, which
+   * doesn't happen with the C rules, since no match of them is scanned more
+   * than a byte past its end.
+   *
+   * @param begin
+   * @param end
+   * @return
+   */
+  [[nodiscard]] std::optional<AcceptState> NextMatch(StrConstIt begin,
+                                                    StrConstIt end) const;
 
-  static Nfa nfa_;
+  static std::shared_ptr<const Automaton> shared_automaton_;
 
-  std::stringstream source_stream_;
-  int line_;
-  int column_;
+  std::shared_ptr<const Automaton> automaton_;
+  std::shared_ptr<const SourceBuffer> source_;
+  // the window over a file descriptor instead of source_
+  std::unique_ptr<StreamBuffer> stream_;
+  // the location to lex next
+  StrConstIt cursor_{};
+  // the end of the lexed part of source_ or stream_
+  StrConstIt source_end_{};
+  // whether a block comment is still open at source_end_
+  bool comment_flag_{false};
   // store tokens that are got but not consumed immediately
   std::vector<Token> tokens_;
+  // built from the NFA on the first match if the automaton has no DFA
+  mutable std::unique_ptr<LazyDfa> lazy_dfa_;
+  // failures of lazy_dfa_ before source_end_, cleared when the window moves
+  mutable LazyDfa::FailureMemo failure_memo_;
 };
 }
 
@@ -0,0 +1,53 @@
+//
+// Created by dxy on 2020/12/7.
+//
+
+#ifndef CCOMPILER_MAPPED_FILE_H
+#define CCOMPILER_MAPPED_FILE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace CCompiler {
+/**
+ * A read-only memory mapping of a whole file. It is movable but not
+ * copyable, and the mapping is released when the object is destroyed.
+ */
+class MappedFile {
+ public:
+  MappedFile() = default;
+
+  MappedFile(const MappedFile &) = delete;
+
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  MappedFile(MappedFile &&file) noexcept;
+
+  MappedFile &operator=(MappedFile &&file) noexcept;
+
+  ~MappedFile();
+
+  /**
+   * Map the file at path. Empty files are mapped as an empty range.
+   *
+   * @param path
+   * @return If the file cannot be opened or mapped, it returns nullptr.
+   */
+  static std::unique_ptr<MappedFile> Open(const std::string &path);
+
+  [[nodiscard]] const char *Data() const {
+    return data_;
+  }
+
+  [[nodiscard]] std::size_t Size() const {
+    return size_;
+  }
+
+ private:
+  const char *data_{nullptr};
+  std::size_t size_{0};
+};
+}
+
+#endif // CCOMPILER_MAPPED_FILE_H
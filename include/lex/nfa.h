@@ -5,33 +5,68 @@
 #ifndef CCOMPILER_NFA_H
 #define CCOMPILER_NFA_H
 
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <set>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
-namespace CCompiler {
-class RegexAstNode;
+#include "lex/keyword_table.h"
 
+namespace CCompiler {
 class SpecialPatternNfa;
 
 class RangeNfa;
 
 enum class TokenType;
 
-using RegexAstNodePtr = std::unique_ptr<RegexAstNode>;
-using StrConstIt = std::string::const_iterator;
+using StrConstIt = std::string_view::const_iterator;
 // pair.first -- state
 // pair.second -- current begin iterator
-using ReachableStatesMap = std::set<std::pair<int, StrConstIt>>;
 using State = std::pair<int, StrConstIt>;
 // pair.first -- token type
 // pair.second -- current begin iterator
 using AcceptState = std::pair<TokenType, StrConstIt>;
 using AcptStatePtr = std::unique_ptr<AcceptState>;
 
+/**
+ * A set of bytes as a 256-bit bitmap, so a test is one load and a bit test.
+ */
+class ByteSet {
+ public:
+  void Add(unsigned char c) {
+    bits_[c / 64] |= std::uint64_t{1} << (c % 64);
+  }
+
+  void Add(const ByteSet &bytes) {
+    for (std::size_t i = 0; i < bits_.size(); ++i) {
+      bits_[i] |= bytes.bits_[i];
+    }
+  }
+
+  void Invert() {
+    for (auto &word:bits_) {
+      word = ~word;
+    }
+  }
+
+  [[nodiscard]] bool Contains(unsigned char c) const {
+    return (bits_[c / 64] >> (c % 64)) & 1;
+  }
+
+  auto operator<=>(const ByteSet &) const = default;
+
+ private:
+  std::array<std::uint64_t, 4> bits_{};
+};
+
 /**
  * We split a regex to several parts and classify them to types in
  * RegexPart.
@@ -48,10 +83,14 @@ enum class RegexPart {
   kAnd, kChar, kQuantifier, kAlternative, kPassiveGroup, kError
 };
 
-using StrConstIt = std::string::const_iterator;
+using StrConstIt = std::string_view::const_iterator;
 
 class Nfa {
-  friend class NfaFactory;
+  friend class NfaBuilder;
+
+  friend class Dfa;
+
+  friend class LazyDfa;
 
  public:
   /**
@@ -59,8 +98,11 @@ class Nfa {
    * NFA can have several accept states.
    *
    * @param regex_rules
+   * @param extract_keywords whether to recognize keywords with a
+   * KeywordTable instead of states
    */
-  explicit Nfa(const std::map<std::string, TokenType> &regex_rules);
+  explicit Nfa(const std::map<std::string, TokenType> &regex_rules,
+               bool extract_keywords = true);
 
   /**
    * Build a NFA for regex. Notice that if regex is invalid, it creates an
@@ -76,13 +118,19 @@ class Nfa {
    * Notice that it matches from begin, say, the successful match must
    * be [begin, any location no more than end).
    *
+   * All active states are at the same location since every state consumes
+   * at most one character, so they are simulated in lockstep as a bitset
+   * and only the last accept location is remembered. Memory used by a
+   * match only depends on the number of states, and it takes O(n * m) time
+   * for n characters scanned and m states, whatever the rules are.
+   *
    * @param begin First iterator of the given string. If we successfully
    * find a token, 'begin' will be moved to the beginning of the first
    * character after the match.
    * @param end Last iterator of the given string.
    * @return A matched substring. If no match exists, it returns "".
    */
-  AcptStatePtr NextMatch(StrConstIt begin, StrConstIt end);
+  AcptStatePtr NextMatch(StrConstIt begin, StrConstIt end) const;
 
   /**
    * It is used to determine whether a NFA is a valid NFA.
@@ -93,116 +141,144 @@ class Nfa {
     return accept_states_.empty();
   }
 
+  /**
+   * @return number of character ranges, including the one reserved for
+   * empty edges
+   */
+  [[nodiscard]] int CharClassCount() const {
+    return static_cast<int>(char_ranges_.size());
+  }
+
+  [[nodiscard]] int StateCount() const {
+    return state_count_;
+  }
+
+  [[nodiscard]] const KeywordTable &GetKeywords() const {
+    return keywords_;
+  }
+
  protected:
   enum class StateType {
     kSpecialPattern, kRange, kCommon
   };
 
+  /**
+   * An edge added by the builder. It is turned into the compact form by
+   * Compile().
+   */
+  struct Edge {
+    int from;
+    int range;
+    int to;
+  };
+
   static const int kEmptyEdge = 0;
+  static constexpr int kNotAccept = -1;
 
   Nfa() = default;
 
   /**
-   * Build a NFA according to an AST. If ast_head is an invalid AST or
-   * a nullptr pointer, it creates an empty NFA.
-   *
-   * @param ast_head can be nullptr
+   * Turn the builder representation into the compact one. Edges are
+   * grouped by state and sorted by character range, and empty closures are
+   * computed once here instead of on every visit.
    */
-  Nfa(RegexAstNodePtr &ast_head, const std::vector<unsigned int> &char_ranges);
+  void Compile();
 
   /**
-   * It copies exchange_map_, assertion_states_, not_assertion_states_
-   * and group_states_ to the new NFA.
-   *
-   * @param nfa After calling the function, nfa.exchange_map_ becomes
-   * undefined and should never be accessed again.
-   * @return
+   * bit i of word i / 64 is set when state i is active
    */
-  Nfa &operator+=(Nfa &nfa);
+  using StateBits = std::vector<std::uint64_t>;
 
   /**
-   * It tries to move to the next state until to the end of the string or
-   * no next states can be found.
+   * Activate state and, if it is a common state, its empty closure.
    *
-   * @param begin
-   * @param end
-   * @return all possible routines
+   * @param state
+   * @param states
    */
-  std::vector<ReachableStatesMap> StateRoute(StrConstIt begin, StrConstIt end);
+  void AddState(int state, StateBits &states) const;
 
   /**
-   * Get all reachable states starting from cur_state. When cur_state
-   * is a functional state, it will be handled first. For common
-   * states, we match *begin first. Then we deal with states that can
-   * be reached through empty edges.
+   * Activate all states reachable from the active states in cur_states by
+   * consuming c.
    *
-   * @param cur_state
-   * @param str_end
-   * @return reachable states after handling cur_state
+   * @param cur_states
+   * @param c the character to consume
+   * @param next_states should be cleared by the caller
+   * @return whether any state is activated
    */
-  ReachableStatesMap NextState(const State &cur_state, StrConstIt str_end);
+  bool NextStates(const StateBits &cur_states, StrConstIt c,
+                  StateBits &next_states) const;
 
   /**
-   * All reachable states starting from cur_state through empty edges.
-   * Notice that cur_state is excluded and it does nothing to handle
-   * functional states.
-   *
-   * @param cur_state
-   * @return
+   * @param states
+   * @return the smallest TokenType of active accept states or kNotAccept
    */
-  ReachableStatesMap NextState(const State &cur_state);
+  [[nodiscard]] int AcceptType(const StateBits &states) const;
 
-  StateType GetStateType(int state);
+  [[nodiscard]] StateType GetStateType(int state) const {
+    return state_types_[state];
+  }
 
   /**
-   * Use 'delim' to split an encoding to several ranges.
-   *
-   * @param delim You should ensure it contains valid character classes.
-   * @param encoding
+   * @param state a common state
+   * @param range
+   * @return states reached from state by consuming a character in range
    */
-  void CharRangesInit(const std::set<std::string> &delim);
+  [[nodiscard]] std::span<const int> GetNextStates(int state, int range) const;
 
   /**
-   * Find which character range in the char_ranges_ c is in.
+   * All states reachable from state through empty edges. Common states are
+   * expanded and functional states are not since they must consume a
+   * character first. The state itself is excluded unless it is a functional
+   * state reached again.
    *
-   * @param c must be in the range of the current encoding
-   * @return range index in char_ranges_ where c is in
+   * @param state
+   * @return
    */
-  int GetCharLocation(int c);
+  [[nodiscard]] std::span<const int> GetEmptyClosure(int state) const {
+    return {closures_.data() + closure_offsets_[state],
+            closures_.data() + closure_offsets_[state + 1]};
+  }
 
   /**
-   * Parse a regex to an AST. We assume that regex can only include
-   * several valid elements:
-   * characters(include single character, escape character and '[...]')
-   * quantifiers
-   * |
-   * & (It is implicit in a regex string but we need to explicitly deal
-   * with them when parsing a regex)
-   * groups
-   * assertions
-   *
-   * All characters should be represented as a node, say, ranges and
-   * escape characters are seen as single character here. Moreover, groups
-   * and lookaheads will add a flag node to the head to remember its type.
+   * @param state a functional state
+   * @return bytes matched by state
+   */
+  [[nodiscard]] const ByteSet &GetFunctionalBytes(int state) const;
+
+  /**
+   * @param state a functional state
+   * @param c
+   * @return whether state matches the single character c
+   */
+  [[nodiscard]] bool FunctionalMatch(int state, char c) const {
+    return GetFunctionalBytes(state).Contains(c);
+  }
+
+  /**
+   * Use 'delim' to split an encoding to several ranges.
    *
-   * @param regex
-   * @return If regex is in a valid format, return the head of AST.
-   * Otherwise return nullptr.
+   * @param delim You should ensure it contains valid character classes.
+   * @param encoding
    */
-  static RegexAstNodePtr ParseRegex(const std::string &regex);
+  void CharRangesInit(const std::set<std::string_view> &delim);
 
   /**
-   * Add a new state to exchange_map_. Now it has no edges.
+   * Fill char_classes_ according to char_ranges_. It is called by Compile()
+   * since sub-NFAs under construction never look up characters.
    */
-  void NewState();
+  void CharClassesInit();
 
   /**
-   * We use i_ to generate a new state. First state should have a id 1.
-   * After that, it will be increased when creating a new state. i_
-   * points to the lastly added state at any time after creating the
-   * first state.
+   * Find which character range in the char_ranges_ c is in.
+   *
+   * @param c
+   * @return range index in char_ranges_ where c is in. Characters out of
+   * the encoding are all in the last range.
    */
-  static int i_;
+  [[nodiscard]] int GetCharLocation(int c) const {
+    return char_classes_[static_cast<unsigned char>(c)];
+  }
 
   /**
    * Record several continuous character ranges. Ranges are stored
@@ -214,14 +290,18 @@ class Nfa {
   std::vector<unsigned int> char_ranges_;
 
   /**
-   * map.first -- state
-   * map.second.element -- reachable states from an input character that
-   * is in the corresponding range
+   * char_classes_[c] is the index of the range in char_ranges_ that c is
+   * in. It replaces searching char_ranges_ for every input character.
    */
-  std::map<int, std::vector<std::set<int>>> exchange_map_;
+  std::array<int, 256> char_classes_{};
 
-  std::map<int, SpecialPatternNfa> special_pattern_states_;
-  std::map<int, RangeNfa> range_states_;
+  /**
+   * Edges and functional states added by NfaBuilder. They are cleared by
+   * Compile().
+   */
+  std::vector<Edge> edges_;
+  std::vector<std::pair<int, SpecialPatternNfa>> special_pattern_states_;
+  std::vector<std::pair<int, RangeNfa>> range_states_;
 
   int begin_state_{-1};
   /**
@@ -229,36 +309,78 @@ class Nfa {
    * map.second -- regex type
    */
   std::map<int, TokenType> accept_states_;
+
+  /**
+   * The compact form built by Compile(). State i owns
+   * edge_ranges_/edge_targets_[edge_offsets_[i], edge_offsets_[i + 1]),
+   * sorted by range, and closures_[closure_offsets_[i],
+   * closure_offsets_[i + 1]). A functional state i is
+   * special_patterns_[functionals_[i]] or ranges_[functionals_[i]]
+   * according to state_types_[i].
+   */
+  int state_count_{0};
+  std::vector<StateType> state_types_;
+  std::vector<int> functionals_;
+  std::vector<SpecialPatternNfa> special_patterns_;
+  std::vector<RangeNfa> ranges_;
+  std::vector<int> edge_offsets_;
+  std::vector<int> edge_ranges_;
+  std::vector<int> edge_targets_;
+  std::vector<int> closure_offsets_;
+  std::vector<int> closures_;
+  /**
+   * accept_types_[state] is the TokenType of an accept state or kNotAccept
+   */
+  std::vector<int> accept_types_;
+  /**
+   * bits of accept states, used to skip words without accept states
+   */
+  StateBits accept_bits_;
+
+  /**
+   * keywords extracted from the rules, used to classify matches of their
+   * hosts
+   */
+  KeywordTable keywords_;
 };
 
 /**
  * Escape characters, special meaning escape characters and back-reference.
+ * Every pattern matches a single byte, so it is compiled to the set of
+ * bytes it matches.
  */
 class SpecialPatternNfa {
  public:
-  explicit SpecialPatternNfa(std::string characters)
-          : characters_(std::move(characters)) {}
+  explicit SpecialPatternNfa(std::string_view characters);
 
   /**
-   * Determine whether a substring can match characters_.
+   * Determine whether a substring can match the pattern.
    *
    * @param begin
    * @param str_end
    * @return If a substring [begin, end_it) matches, return end_it.
    * Otherwise return begin.
    */
-  StrConstIt NextMatch(const State &state, StrConstIt str_end);
+  StrConstIt NextMatch(const State &state, StrConstIt str_end) const {
+    auto begin = state.second;
+    return begin < str_end && bytes_.Contains(*begin) ? begin + 1 : begin;
+  }
+
+  [[nodiscard]] const ByteSet &GetBytes() const {
+    return bytes_;
+  }
 
  private:
-  std::string characters_;
+  ByteSet bytes_;
 };
 
 /**
- * [...]. It can contain single characters, ranges and special patterns.
+ * [...]. It can contain single characters, ranges and special patterns,
+ * which are folded into one set of bytes when it is constructed.
  */
 class RangeNfa {
  public:
-  explicit RangeNfa(const std::string &regex);
+  explicit RangeNfa(std::string_view regex);
 
   /**
    * @param begin
@@ -266,71 +388,216 @@ class RangeNfa {
    * @return If a substring [begin, end_it) matches, return end_it.
    * Otherwise return begin.
    */
-  StrConstIt NextMatch(const State &state, StrConstIt str_end);
+  StrConstIt NextMatch(const State &state, StrConstIt str_end) const {
+    auto begin = state.second;
+    return begin < str_end && bytes_.Contains(*begin) ? begin + 1 : begin;
+  }
+
+  [[nodiscard]] const ByteSet &GetBytes() const {
+    return bytes_;
+  }
 
  private:
-  std::map<int, int> ranges_;
-  std::vector<SpecialPatternNfa> special_patterns_;
-  bool except_;  // true for [^...] and false for [...]
+  ByteSet bytes_;
+};
+
+/**
+ * Node in AST that is used as a intermediate format of a regex. It helps
+ * to show the regex structure more clearly and reduce the work to build
+ * the NFA. AST for regex is designed as a binary tree, so every AstNode
+ * has at most two son nodes, which are indexes in the same RegexAst.
+ */
+struct RegexAstNode {
+  RegexPart regex_type;
+  // a view into the parsed regex
+  std::string_view regex;
+  int left_son;
+  int right_son;
 };
 
 /**
- * Provide a function to create a sub-NFA for common operators in the
- * RegexPart. It's usually used to create NFAs for split parts.
+ * An arena of RegexAstNodes. Nodes of a regex are kept in one vector and
+ * linked by index, and groups are parsed in place on shared stacks, so
+ * parsing doesn't allocate per node. Clear() keeps the memory for the next
+ * regex.
  */
-class NfaFactory {
+class RegexAst {
  public:
-  static Nfa MakeCharacterNfa(const std::string &characters,
-                              const std::vector<unsigned int> &char_ranges);
+  static constexpr int kNoNode = -1;
 
-  static Nfa MakeAlternativeNfa(Nfa left_nfa, Nfa right_nfa);
+  /**
+   * Parse a regex to an AST. We assume that regex can only include
+   * several valid elements:
+   * characters(include single character, escape character and '[...]')
+   * quantifiers
+   * |
+   * & (It is implicit in a regex string but we need to explicitly deal
+   * with them when parsing a regex)
+   * groups
+   * assertions
+   *
+   * All characters should be represented as a node, say, ranges and
+   * escape characters are seen as single character here. Moreover, groups
+   * and lookaheads will add a flag node to the head to remember its type.
+   *
+   * @param regex It must outlive the nodes, which are views into it.
+   * @return If regex is in a valid format, return the head of AST.
+   * Otherwise return kNoNode.
+   */
+  int Parse(std::string_view regex);
 
-  static Nfa MakeAndNfa(Nfa left_nfa, Nfa right_nfa);
+  [[nodiscard]] const RegexAstNode &GetNode(int node) const {
+    return nodes_[node];
+  }
 
-  static Nfa MakeQuantifierNfa(const std::string &quantifier,
-                               RegexAstNodePtr &left,
-                               const std::vector<unsigned int> &char_ranges);
+  void Clear() {
+    nodes_.clear();
+  }
 
  private:
-  static std::pair<int, int> ParseQuantifier(const std::string &quantifier);
+  int AddNode(RegexPart regex_type, std::string_view regex) {
+    nodes_.push_back({regex_type, regex, kNoNode, kNoNode});
+    return static_cast<int>(nodes_.size()) - 1;
+  }
+
+  /**
+   * Pop operators with higher precedence to the operand stack and push an
+   * operator node. They fail if an operator lacks operands.
+   */
+  bool PushAnd();
+
+  bool PushOr();
+
+  bool PushQuantifier(std::string_view regex);
+
+  /**
+   * @param node an operator node popped from op_stack_
+   * @param sons number of operands it takes from rpn_stack_
+   * @return whether there are enough operands
+   */
+  bool PopOperator(int node, int sons);
+
+  std::vector<RegexAstNode> nodes_;
+  /**
+   * Stacks of the shunting-yard parser. The regex being parsed owns the
+   * parts above op_base_ and rpn_base_, below which are the stacks of
+   * the enclosing regex when it is a group.
+   */
+  std::vector<int> op_stack_;
+  std::vector<int> rpn_stack_;
+  std::size_t op_base_{0};
+  std::size_t rpn_base_{0};
 };
 
 /**
- * Node in AST that is used as a intermediate format of a regex. It helps
- * to show the regex structure more clearly and reduce the work to build
- * the NFA. AST for regex is designed as a binary tree, so every AstNode
- * has at most two son nodes.
+ * Build the states of a Nfa by Thompson's construction. The builder owns
+ * state allocation of the Nfa, which numbers states densely from 0, so ids
+ * index arrays directly and NFAs can be built on several threads at the
+ * same time.
+ *
+ * Sub-NFAs are Fragments of the Nfa under construction, and the functions
+ * creating a sub-NFA for each RegexPart combine them.
  */
-class RegexAstNode {
-  friend class Nfa;
-
+class NfaBuilder {
  public:
-  RegexAstNode(RegexPart regex_type, std::string regex)
-          : regex_type_(regex_type),
-            regex_(std::move(regex)) {}
+  /**
+   * A sub-NFA with a begin state and an accept state. It is move-only since
+   * combining fragments links their states into the result, which must not
+   * be linked again.
+   */
+  class Fragment {
+   public:
+    Fragment() = default;
 
-  void SetLeftSon(RegexAstNodePtr left_son) {
-    left_son_ = std::move(left_son);
-  }
+    Fragment(int begin_state, int accept_state)
+            : begin_state_(begin_state),
+              accept_state_(accept_state) {}
 
-  void SetRightSon(RegexAstNodePtr right_son) {
-    right_son_ = std::move(right_son);
+    Fragment(const Fragment &) = delete;
+
+    Fragment &operator=(const Fragment &) = delete;
+
+    Fragment(Fragment &&) noexcept = default;
+
+    Fragment &operator=(Fragment &&) noexcept = default;
+
+    /**
+     * @return whether the regex of the fragment is invalid
+     */
+    [[nodiscard]] bool Empty() const {
+      return begin_state_ == -1;
+    }
+
+    [[nodiscard]] int GetBeginState() const {
+      return begin_state_;
+    }
+
+    [[nodiscard]] int GetAcceptState() const {
+      return accept_state_;
+    }
+
+   private:
+    int begin_state_{-1};
+    int accept_state_{-1};
+  };
+
+  /**
+   * @param nfa an uncompiled Nfa whose char_ranges_ are initialized
+   */
+  explicit NfaBuilder(Nfa &nfa) : nfa_(nfa) {}
+
+  /**
+   * @return a new state without edges
+   */
+  int NewState() {
+    return nfa_.state_count_++;
   }
 
-  [[nodiscard]] RegexPart GetType() const {
-    return regex_type_;
+  void AddEdge(int from, int range, int to) {
+    nfa_.edges_.push_back({from, range, to});
   }
 
+  /**
+   * Build a sub-NFA for regex whose accept state is an accept state of type
+   * in the Nfa.
+   *
+   * @param regex
+   * @param type
+   * @return If regex is invalid, it returns an empty fragment.
+   */
+  Fragment MakeRuleNfa(const std::string &regex, TokenType type);
+
+  /**
+   * Build a sub-NFA according to an AST in ast_.
+   *
+   * @param ast_head can be RegexAst::kNoNode
+   * @return If ast_head is an invalid AST or kNoNode, it returns an empty
+   * fragment.
+   */
+  Fragment MakeNfa(int ast_head);
+
+  Fragment MakeCharacterNfa(std::string_view characters);
+
+  Fragment MakeAlternativeNfa(Fragment left_nfa, Fragment right_nfa);
+
+  Fragment MakeAndNfa(Fragment left_nfa, Fragment right_nfa);
+
+  Fragment MakeQuantifierNfa(std::string_view quantifier, int left);
+
+  /**
+   * @param quantifier *, +, ? or {...}
+   * @return the minimum and maximum times to repeat, where INT_MAX means
+   * no limit
+   */
+  static std::pair<int, int> ParseQuantifier(std::string_view quantifier);
+
  private:
-  RegexPart regex_type_;
-  std::string regex_;
-  RegexAstNodePtr left_son_;
-  RegexAstNodePtr right_son_;
-};
 
-std::ostream &operator<<(std::ostream &os, const Nfa &nfa);
+  Nfa &nfa_;
+  // the AST of the current rule, reused by every rule
+  RegexAst ast_;
+};
 
-std::istream &operator>>(std::istream &is, Nfa &nfa);
 }
 
 #endif // CCOMPILER_NFA_H
\ No newline at end of file
@@ -0,0 +1,87 @@
+//
+// Created by dxy on 2020/12/16.
+//
+
+#ifndef CCOMPILER_SCANNER_H
+#define CCOMPILER_SCANNER_H
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "lex/byte_scan.h"
+#include "lex/lazy_dfa.h"
+#include "lex/nfa.h"
+#include "lex/token.h"
+
+namespace CCompiler {
+/**
+ * Search a text for matches of many rules at once, like grep -o with
+ * several patterns. Nfa::NextMatch() only matches at a given location, so
+ * a Scanner tries every location that a match can begin at.
+ *
+ * The locations are found by a prefilter: the bytes every match of a rule
+ * can begin with are collected from the AST of the rule, and the bytes
+ * that can't begin a match are skipped with memchr() or SkipRanges().
+ * Rules that begin with literals, which is common in logs, skip most of a
+ * text this way.
+ *
+ * Matching state is cached by a LazyDfa, so an instance must not be shared
+ * by threads. Failures of earlier candidates are remembered by a
+ * LazyDfa::FailureMemo, so a search takes time linear in the length of
+ * the text as long as the cache isn't flushed.
+ */
+class Scanner {
+ public:
+  /**
+   * @param regex_rules Invalid rules are ignored like in Nfa.
+   */
+  explicit Scanner(const std::map<std::string, TokenType> &regex_rules);
+
+  Scanner(const Scanner &) = delete;
+
+  Scanner &operator=(const Scanner &) = delete;
+
+  /**
+   * Find matches from left to right. A match is the longest one among the
+   * rules that begins at the leftmost location, and the next match is
+   * searched after its end, so matches don't overlap. Empty matches are
+   * never reported.
+   *
+   * @param text
+   * @return matches as tokens whose offsets are from the beginning of text
+   */
+  std::vector<Token> FindAll(std::string_view text);
+
+  /**
+   * @return number of bytes that can begin a match
+   */
+  [[nodiscard]] int StartByteCount() const;
+
+ private:
+  /**
+   * @param begin
+   * @param end
+   * @return the first location in [begin, end) whose byte can begin a
+   * match or end
+   */
+  [[nodiscard]] StrConstIt NextCandidate(StrConstIt begin,
+                                         StrConstIt end) const;
+
+  Nfa nfa_;
+  LazyDfa lazy_dfa_;
+  // start_bytes_[c] is whether a match can begin with byte c
+  bool start_bytes_[256]{};
+  /**
+   * The prefilter chosen for start_bytes_: memchr() for a single byte,
+   * SkipRanges() when the other bytes fit in ByteRanges, or a loop over
+   * start_bytes_.
+   */
+  int start_byte_count_{0};
+  char single_start_byte_{0};
+  ByteRanges other_bytes_;
+};
+}
+
+#endif // CCOMPILER_SCANNER_H
@@ -0,0 +1,82 @@
+//
+// Created by dxy on 2020/12/13.
+//
+
+#ifndef CCOMPILER_SOURCE_BUFFER_H
+#define CCOMPILER_SOURCE_BUFFER_H
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "lex/mapped_file.h"
+
+namespace CCompiler {
+struct SourceLocation {
+  int line;  // starting from 1
+  int column;  // starting from 0, in bytes
+};
+
+/**
+ * The text of a source. A file is memory-mapped and a string is copied once.
+ * Tokens are views into the text, so the buffer must outlive them. It is
+ * shared by std::shared_ptr and never moved, which keeps the views valid.
+ *
+ * Sources must be smaller than 4 GiB, since offsets are 32-bit.
+ */
+class SourceBuffer {
+ public:
+  explicit SourceBuffer(std::string text)
+          : text_(std::move(text)),
+            view_(text_) {}
+
+  explicit SourceBuffer(std::unique_ptr<MappedFile> file)
+          : file_(std::move(file)),
+            view_(file_->Data(), file_->Size()) {}
+
+  SourceBuffer(const SourceBuffer &) = delete;
+
+  SourceBuffer &operator=(const SourceBuffer &) = delete;
+
+  /**
+   * @param path
+   * @return If the file cannot be mapped, it returns nullptr.
+   */
+  static std::shared_ptr<const SourceBuffer> Open(const std::string &path);
+
+  /**
+   * Copy a whole stream, like a file opened by std::ifstream.
+   *
+   * @param stream
+   * @return
+   */
+  static std::shared_ptr<const SourceBuffer> Read(std::istream &stream);
+
+  [[nodiscard]] std::string_view GetText() const {
+    return view_;
+  }
+
+  /**
+   * The table of line starts is built by the first call, which is safe to
+   * race with other calls.
+   *
+   * @param offset
+   * @return the line and the column of offset
+   */
+  [[nodiscard]] SourceLocation GetLocation(std::uint32_t offset) const;
+
+ private:
+  std::unique_ptr<MappedFile> file_;
+  std::string text_;
+  std::string_view view_;
+  // offsets of the beginnings of lines
+  mutable std::vector<std::uint32_t> line_starts_;
+  mutable std::once_flag line_starts_flag_;
+};
+}
+
+#endif // CCOMPILER_SOURCE_BUFFER_H
@@ -0,0 +1,100 @@
+//
+// Created by dxy on 2020/12/14.
+//
+
+#ifndef CCOMPILER_STREAM_BUFFER_H
+#define CCOMPILER_STREAM_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include "lex/byte_scan.h"
+#include "lex/source_buffer.h"
+
+namespace CCompiler {
+/**
+ * A fixed-size window over a file descriptor, which lexes a file of any size
+ * in constant memory. Refill() drops the consumed bytes, moves the rest to
+ * the front and reads more, so a lexeme cut by the end of the window is seen
+ * whole after the refill. The window stays contiguous for the automata
+ * instead of wrapping around like a ring, and only grows when bytes that
+ * must be kept fill it.
+ */
+class StreamBuffer {
+ public:
+  static constexpr std::size_t kDefaultCapacity = 1 << 16;
+
+  /**
+   * @param fd It is read from its current position and isn't closed.
+   * @param capacity size of the window in bytes
+   */
+  StreamBuffer(int fd, std::size_t capacity);
+
+  StreamBuffer(const StreamBuffer &) = delete;
+
+  StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+  /**
+   * Drop the bytes before keep, then read until the window is full or the
+   * file ends. A read error is taken as the end of the file.
+   *
+   * @param keep a location in GetText()
+   * @return how many bytes the kept ones are moved toward the front
+   */
+  std::size_t Refill(StrConstIt keep);
+
+  /**
+   * Double the capacity, so that a full window can be refilled without
+   * dropping bytes. The bytes are moved to a new window.
+   */
+  void Grow();
+
+  /**
+   * @return the bytes in the window, which are valid until Refill()
+   */
+  [[nodiscard]] std::string_view GetText() const {
+    return {data_.get(), size_};
+  }
+
+  /**
+   * @return whether the window holds the end of the file
+   */
+  [[nodiscard]] bool AtEnd() const {
+    return at_end_;
+  }
+
+  [[nodiscard]] std::size_t GetCapacity() const {
+    return capacity_;
+  }
+
+  /**
+   * @param position a position in GetText()
+   * @return the offset of position in the file
+   */
+  [[nodiscard]] std::uint64_t GetOffset(std::size_t position) const {
+    return offset_ + position;
+  }
+
+  /**
+   * @param position a position in GetText()
+   * @return the line and the column of position in the file
+   */
+  [[nodiscard]] SourceLocation GetLocation(std::size_t position) const;
+
+ private:
+  int fd_;
+  std::size_t capacity_;
+  std::unique_ptr<char[]> data_;
+  std::size_t size_{0};
+  bool at_end_{false};
+  // offset of data_[0] in the file
+  std::uint64_t offset_{0};
+  // line of data_[0] and the offset where the line begins
+  int line_{1};
+  std::uint64_t line_start_{0};
+};
+}
+
+#endif // CCOMPILER_STREAM_BUFFER_H
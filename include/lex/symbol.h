@@ -0,0 +1,116 @@
+//
+// Created by dxy on 2020/12/17.
+//
+
+#ifndef CCOMPILER_SYMBOL_H
+#define CCOMPILER_SYMBOL_H
+
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace CCompiler {
+/**
+ * An interned spelling of an identifier or a string literal. Equal
+ * spellings are interned to equal symbols, so the AST keeps 4 bytes per
+ * name and scopes compare names as integers.
+ */
+class Symbol {
+ public:
+  /**
+   * The symbol of "", like an anonymous struct tag.
+   */
+  Symbol() = default;
+
+  /**
+   * Intern spelling in SymbolTable::Global().
+   *
+   * @param spelling
+   */
+  explicit Symbol(std::string_view spelling);
+
+  [[nodiscard]] std::uint32_t GetId() const {
+    return id_;
+  }
+
+  [[nodiscard]] bool Empty() const {
+    return id_ == 0;
+  }
+
+  /**
+   * @return the spelling, which lives as long as the program
+   */
+  [[nodiscard]] std::string_view GetSpelling() const;
+
+  auto operator<=>(const Symbol &) const = default;
+
+ private:
+  friend class SymbolTable;
+
+  std::uint32_t id_{0};
+};
+
+/**
+ * Map spellings to Symbols. Spellings are split into shards by their hash
+ * and every shard has its own lock, so lexers and parsers on several
+ * threads can intern into one table without waiting for each other most of
+ * the time.
+ */
+class SymbolTable {
+ public:
+  /**
+   * @return the table shared by every compilation in the process, which
+   * Symbol(std::string_view) interns into
+   */
+  static SymbolTable &Global();
+
+  /**
+   * @param spelling
+   * @return the symbol of spelling, which is added if it isn't interned
+   */
+  Symbol Intern(std::string_view spelling);
+
+  /**
+   * @param symbol It must be interned by this table.
+   * @return
+   */
+  [[nodiscard]] std::string_view GetSpelling(Symbol symbol) const;
+
+  /**
+   * @return number of interned spellings, not including ""
+   */
+  [[nodiscard]] std::size_t Size() const;
+
+ private:
+  /**
+   * The low kShardBits bits of an id are its shard, and the others are
+   * one more than its index in the shard, so the id of "" is 0.
+   */
+  static constexpr int kShardBits = 4;
+  static constexpr int kShardCount = 1 << kShardBits;
+
+  struct Shard {
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string_view, std::uint32_t> ids;
+    // Elements of a deque don't move, so views of them stay valid.
+    std::deque<std::string> spellings;
+  };
+
+  std::array<Shard, kShardCount> shards_;
+};
+}
+
+template<>
+struct std::hash<CCompiler::Symbol> {
+  std::size_t operator()(CCompiler::Symbol symbol) const {
+    return std::hash<std::uint32_t>()(symbol.GetId());
+  }
+};
+
+#endif // CCOMPILER_SYMBOL_H
@@ -5,9 +5,12 @@
 #ifndef CCOMPILER_TOKEN_H
 #define CCOMPILER_TOKEN_H
 
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
 namespace CCompiler {
 enum class TokenType {
@@ -111,25 +114,30 @@ enum class TokenType {
   kEmpty
 };
 
+/**
+ * The matched string is a view into the SourceBuffer of the Lexer, so tokens
+ * are cheap to copy but must not outlive the buffer. The location is only an
+ * offset into the buffer, and SourceBuffer::GetLocation() turns it into a
+ * line and a column when needed.
+ */
 class Token {
  public:
-  explicit Token(std::string token = "", TokenType type = TokenType::kEmpty,
-                 int line = 0, int column = 0)
-          : token_(std::move(token)),
+  explicit Token(std::string_view token = {},
+                 TokenType type = TokenType::kEmpty, std::uint32_t offset = 0)
+          : token_(token),
             type_(type),
-            line_(line),
-            column_(column) {}
+            offset_(offset) {}
 
   /**
    * Check token_ to determine whether it's a valid token.
    *
    * @return
    */
-  bool Empty() {
+  [[nodiscard]] bool Empty() const {
     return token_.empty();
   }
 
-  [[nodiscard]] std::string GetToken() {
+  [[nodiscard]] std::string_view GetToken() const {
     return token_;
   }
 
@@ -137,33 +145,21 @@ class Token {
     return type_;
   }
 
-  [[nodiscard]] int GetLine() const {
-    return line_;
+  [[nodiscard]] std::uint32_t GetOffset() const {
+    return offset_;
   }
 
-  [[nodiscard]] int GetColumn() const {
-    return column_;
-  }
-
-  void SetLine(int line) {
-    line_ = line;
-  }
-
-  void SetColumn(int column) {
-    column_ = column;
-  }
-
-  void SetToken(const std::string &token) {
+  void SetToken(std::string_view token) {
     token_ = token;
   }
 
  private:
-  std::string token_;  // the matched string
+  std::string_view token_;  // the matched string
   TokenType type_;  // terminal symbol type
-  // record token location in the source file
-  int line_;
-  int column_;
+  std::uint32_t offset_;  // offset of the token in the source
 };
+
+static_assert(std::is_trivially_copyable_v<Token>);
 }
 
 #endif // CCOMPILER_TOKEN_H
\ No newline at end of file
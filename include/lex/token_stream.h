@@ -0,0 +1,79 @@
+//
+// Created by dxy on 2020/12/14.
+//
+
+#ifndef CCOMPILER_TOKEN_STREAM_H
+#define CCOMPILER_TOKEN_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "lex/source_buffer.h"
+#include "lex/token.h"
+
+namespace CCompiler {
+/**
+ * Tokens of a source stored as a structure of arrays: a byte of TokenType,
+ * a 32-bit offset into the source and a 32-bit length per token, 9 bytes
+ * instead of a 24-byte Token. Like tokens, lines and columns are recovered
+ * by SourceBuffer::GetLocation().
+ */
+class TokenStream {
+ public:
+  explicit TokenStream(std::shared_ptr<const SourceBuffer> source)
+          : source_(std::move(source)) {}
+
+  void Reserve(std::size_t size) {
+    types_.reserve(size);
+    offsets_.reserve(size);
+    lengths_.reserve(size);
+  }
+
+  void Append(TokenType type, std::uint32_t offset, std::uint32_t length) {
+    types_.push_back(static_cast<std::uint8_t>(type));
+    offsets_.push_back(offset);
+    lengths_.push_back(length);
+  }
+
+  [[nodiscard]] std::size_t Size() const {
+    return types_.size();
+  }
+
+  [[nodiscard]] TokenType GetType(std::size_t i) const {
+    return static_cast<TokenType>(types_[i]);
+  }
+
+  [[nodiscard]] std::uint32_t GetOffset(std::size_t i) const {
+    return offsets_[i];
+  }
+
+  [[nodiscard]] std::string_view GetToken(std::size_t i) const {
+    return source_->GetText().substr(offsets_[i], lengths_[i]);
+  }
+
+  [[nodiscard]] SourceLocation GetLocation(std::size_t i) const {
+    return source_->GetLocation(offsets_[i]);
+  }
+
+  [[nodiscard]] Token At(std::size_t i) const {
+    return Token(GetToken(i), GetType(i), offsets_[i]);
+  }
+
+  [[nodiscard]] const std::shared_ptr<const SourceBuffer> &GetSource() const {
+    return source_;
+  }
+
+ private:
+  std::shared_ptr<const SourceBuffer> source_;
+  std::vector<std::uint8_t> types_;
+  std::vector<std::uint32_t> offsets_;
+  std::vector<std::uint32_t> lengths_;
+};
+
+static_assert(static_cast<int>(TokenType::kEmpty) <= UINT8_MAX);
+}
+
+#endif // CCOMPILER_TOKEN_STREAM_H
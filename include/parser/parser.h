@@ -5,6 +5,7 @@
 #ifndef CCOMPILER_PARSER_H
 #define CCOMPILER_PARSER_H
 
+#include <fstream>
 #include <functional>
 #include <list>
 #include <map>
@@ -13,8 +14,9 @@
 #include "ast/declaration.h"
 #include "ast/translation_unit.h"
 #include "ast/type.h"
-#include "lex/lexer.h"
+#include "lex/source_buffer.h"
 #include "lex/token.h"
+#include "preprocess/preprocessor.h"
 
 namespace CCompiler {
 class Constant;
@@ -34,7 +36,16 @@ class PointerType;
 class Parser {
  public:
   explicit Parser(std::ifstream &source_file)
-          : lexer_(source_file),
+          : preprocessor_(SourceBuffer::Read(source_file)),
+            trans_unit_(new TranslationUnit()),
+            scope_(trans_unit_->GetScope()) {}
+
+  /**
+   * @param source a buffer shared with the lexer, like a file mapped by
+   * SourceBuffer::Open()
+   */
+  explicit Parser(std::shared_ptr<const SourceBuffer> source)
+          : preprocessor_(std::move(source)),
             trans_unit_(new TranslationUnit()),
             scope_(trans_unit_->GetScope()) {}
 
@@ -43,7 +54,16 @@ class Parser {
    * @param source_string
    */
   explicit Parser(const std::string &source_string)
-          : lexer_(source_string),
+          : preprocessor_(std::make_shared<const SourceBuffer>(source_string)),
+            trans_unit_(new TranslationUnit()),
+            scope_(trans_unit_->GetScope()) {}
+
+  /**
+   * @param preprocessor a preprocessor with the path and the include
+   * directories of the source
+   */
+  explicit Parser(Preprocessor preprocessor)
+          : preprocessor_(std::move(preprocessor)),
             trans_unit_(new TranslationUnit()),
             scope_(trans_unit_->GetScope()) {}
 
@@ -184,7 +204,7 @@ class Parser {
 
   Scope *scope_;
 
-  Lexer lexer_;
+  Preprocessor preprocessor_;
 };
 }
 
@@ -0,0 +1,168 @@
+//
+// Created by dxy on 2020/12/18.
+//
+
+#ifndef CCOMPILER_HEADER_CACHE_H
+#define CCOMPILER_HEADER_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "lex/source_buffer.h"
+#include "lex/symbol.h"
+#include "lex/token.h"
+#include "lex/token_stream.h"
+
+namespace CCompiler {
+/**
+ * The tokens of a file and the lines they start, which is all the
+ * preprocessor needs from it. It is lexed once and then read by every
+ * inclusion of the file, so it is never modified after being built.
+ */
+class LexedFile {
+ public:
+  /**
+   * Lex the whole source. Environment::EnvironmentInit() must finish
+   * before.
+   *
+   * @param source
+   * @param path It finds headers included by "name".
+   */
+  explicit LexedFile(std::shared_ptr<const SourceBuffer> source,
+                     std::string path = "");
+
+  [[nodiscard]] const std::string &GetPath() const {
+    return path_;
+  }
+
+  [[nodiscard]] std::size_t Size() const {
+    return tokens_.Size();
+  }
+
+  [[nodiscard]] Token At(std::size_t i) const {
+    return tokens_.At(i);
+  }
+
+  [[nodiscard]] TokenType GetType(std::size_t i) const {
+    return tokens_.GetType(i);
+  }
+
+  [[nodiscard]] std::string_view GetToken(std::size_t i) const {
+    return tokens_.GetToken(i);
+  }
+
+  /**
+   * Identifiers are interned once when the file is lexed, so macros are
+   * looked up by integers however many times the file is included.
+   *
+   * @param i
+   * @return the symbol of token i if it is an identifier or a keyword, or
+   * an empty symbol
+   */
+  [[nodiscard]] Symbol GetName(std::size_t i) const {
+    return names_[i];
+  }
+
+  /**
+   * @param i
+   * @return whether token i is the first token of a line
+   */
+  [[nodiscard]] bool AtLineStart(std::size_t i) const {
+    return line_starts_[i];
+  }
+
+  /**
+   * @param i
+   * @return the index after the last token on the line of token i
+   */
+  [[nodiscard]] std::size_t LineEnd(std::size_t i) const;
+
+  /**
+   * @param i
+   * @return the index of the first '#' starting a line at or after i, or
+   * Size() if there is none
+   */
+  [[nodiscard]] std::size_t NextDirective(std::size_t i) const;
+
+  /**
+   * @param i the index of a '#' starting a directive
+   * @return the name of the directive like "include", or "" if the line
+   * only has the '#'
+   */
+  [[nodiscard]] std::string_view GetDirective(std::size_t i) const {
+    return i + 1 < Size() && !AtLineStart(i + 1) ? GetToken(i + 1) : "";
+  }
+
+  /**
+   * The whole file is in "#ifndef guard" or "#if !defined guard" and the
+   * matching "#endif", without "#else" or "#elif" between them. Once the
+   * guard is defined, the file expands to nothing and including it again
+   * can be skipped without reading its tokens.
+   *
+   * @return the guard or an empty symbol if the file isn't guarded
+   */
+  [[nodiscard]] Symbol GetGuard() const {
+    return guard_;
+  }
+
+ private:
+  /**
+   * Set guard_ if the directives around the file form an include guard.
+   */
+  void DetectGuard();
+
+  std::string path_;
+  TokenStream tokens_;
+  std::vector<bool> line_starts_;
+  std::vector<Symbol> names_;
+  // indexes of the '#' tokens that start directives
+  std::vector<std::uint32_t> directives_;
+  Symbol guard_;
+};
+
+/**
+ * Headers lexed by the translation units of a process. A header included
+ * by many sources, or many times by one source, is read and lexed only
+ * once. Different threads may get headers at the same time.
+ */
+class HeaderCache {
+ public:
+  /**
+   * @return the cache shared by every Preprocessor in the process
+   */
+  static HeaderCache &Global();
+
+  /**
+   * A missing file is also cached, so a header searched in several
+   * directories costs a failed open per directory only once.
+   *
+   * @param path
+   * @return the file lexed by the first call, or nullptr if it can't be
+   * opened
+   */
+  std::shared_ptr<const LexedFile> Get(const std::string &path);
+
+  /**
+   * @return number of cached paths, including missing ones
+   */
+  [[nodiscard]] std::size_t Size() const;
+
+  /**
+   * Forget all files, so changed headers are read again. Files still used
+   * by a Preprocessor are kept alive by it.
+   */
+  void Clear();
+
+ private:
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, std::shared_ptr<const LexedFile>> files_;
+};
+}
+
+#endif // CCOMPILER_HEADER_CACHE_H
@@ -0,0 +1,94 @@
+//
+// Created by dxy on 2020/12/19.
+//
+
+#ifndef CCOMPILER_HIDE_SET_H
+#define CCOMPILER_HIDE_SET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "lex/symbol.h"
+
+namespace CCompiler {
+/**
+ * Hide sets of macro expansion in "A New Approach to Macro Expansion" by
+ * Prosser. A hide set holds the names of the macros that must not expand a
+ * token again, and a token only carries the 32-bit id of its set.
+ *
+ * Sets are interned, so equal sets have equal ids, and the results of
+ * Add(), Union() and Intersect() are memoized. Expanding the same macros
+ * again costs a hash lookup per operation whatever the size of the sets.
+ */
+class HideSetTable {
+ public:
+  static constexpr std::uint32_t kEmpty = 0;
+
+  HideSetTable() : sets_(1) {
+    ids_.insert({sets_.front(), kEmpty});
+  }
+
+  /**
+   * @param set
+   * @param name
+   * @return
+   */
+  [[nodiscard]] bool Contains(std::uint32_t set, Symbol name) const;
+
+  /**
+   * @param set
+   * @param name
+   * @return the union of set and {name}
+   */
+  std::uint32_t Add(std::uint32_t set, Symbol name);
+
+  std::uint32_t Union(std::uint32_t a, std::uint32_t b);
+
+  std::uint32_t Intersect(std::uint32_t a, std::uint32_t b);
+
+  /**
+   * @return number of different sets, including the empty set
+   */
+  [[nodiscard]] std::size_t Size() const {
+    return sets_.size();
+  }
+
+ private:
+  struct SetHash {
+    std::size_t operator()(const std::vector<Symbol> &set) const {
+      std::size_t hash = 0;
+      for (auto name:set) {
+        hash = hash * 31 + name.GetId();
+      }
+      return hash;
+    }
+  };
+
+  /**
+   * @param a
+   * @param b
+   * @return a key of the unordered pair {a, b}
+   */
+  static std::uint64_t PairKey(std::uint32_t a, std::uint32_t b) {
+    return a < b ? std::uint64_t(a) << 32 | b : std::uint64_t(b) << 32 | a;
+  }
+
+  /**
+   * @param set sorted names
+   * @return the id of set, which is added if it isn't interned
+   */
+  std::uint32_t Intern(std::vector<Symbol> set);
+
+  // sorted names of every set by its id
+  std::vector<std::vector<Symbol>> sets_;
+  std::unordered_map<std::vector<Symbol>, std::uint32_t, SetHash> ids_;
+  // results by a set and a name, or by PairKey() of two sets
+  std::unordered_map<std::uint64_t, std::uint32_t> adds_;
+  std::unordered_map<std::uint64_t, std::uint32_t> unions_;
+  std::unordered_map<std::uint64_t, std::uint32_t> intersections_;
+};
+}
+
+#endif // CCOMPILER_HIDE_SET_H
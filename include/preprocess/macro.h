@@ -0,0 +1,79 @@
+//
+// Created by dxy on 2020/12/19.
+//
+
+#ifndef CCOMPILER_MACRO_H
+#define CCOMPILER_MACRO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "preprocess/header_cache.h"
+
+namespace CCompiler {
+/**
+ * A macro defined by "#define". The replacement list stays in the tokens of
+ * the file, and it is compiled to items when the macro is defined, so
+ * parameters, '#' and "##" are found once instead of at every expansion.
+ */
+class Macro {
+ public:
+  enum class ItemType : std::uint8_t {
+    kToken,  // a token of the replacement list
+    kParam,  // a parameter replaced by its argument after expansion
+    kRawParam,  // a parameter next to "##" replaced by its argument as is
+    kStringize,  // # parameter
+    kPaste  // ## between the items before and after it
+  };
+
+  struct Item {
+    ItemType type;
+    // the index of a token in the file or of a parameter
+    std::uint32_t index;
+  };
+
+  /**
+   * Parse "#define name replacement" or "#define name(params) replacement",
+   * where there is no white space between the name and '('. The variadic
+   * parameter "..." is named __VA_ARGS__.
+   *
+   * @param file It must outlive the macro.
+   * @param name the index of the name of the macro
+   * @param end the end of the line
+   */
+  Macro(const LexedFile &file, std::size_t name, std::size_t end);
+
+  [[nodiscard]] const LexedFile &GetFile() const {
+    return *file_;
+  }
+
+  [[nodiscard]] const std::vector<Item> &GetBody() const {
+    return body_;
+  }
+
+  [[nodiscard]] bool IsFunctionLike() const {
+    return param_count_ >= 0;
+  }
+
+  /**
+   * @return number of parameters including __VA_ARGS__, or -1 if it is
+   * object-like
+   */
+  [[nodiscard]] int GetParamCount() const {
+    return param_count_;
+  }
+
+  [[nodiscard]] bool IsVariadic() const {
+    return variadic_;
+  }
+
+ private:
+  const LexedFile *file_;
+  std::vector<Item> body_;
+  int param_count_{-1};
+  bool variadic_{false};
+};
+}
+
+#endif // CCOMPILER_MACRO_H
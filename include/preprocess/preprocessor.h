@@ -0,0 +1,274 @@
+//
+// Created by dxy on 2020/12/18.
+//
+
+#ifndef CCOMPILER_PREPROCESSOR_H
+#define CCOMPILER_PREPROCESSOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "lex/source_buffer.h"
+#include "lex/symbol.h"
+#include "lex/token.h"
+#include "preprocess/header_cache.h"
+#include "preprocess/hide_set.h"
+#include "preprocess/macro.h"
+
+namespace CCompiler {
+/**
+ * The stage between the Lexer and the Parser, which runs the directives of a
+ * translation unit and expands macros in the tokens left. Headers are got
+ * from a HeaderCache, so a header is lexed once in a process however many
+ * times it is included.
+ *
+ * Macros are expanded lazily by the algorithm of Prosser when the parser
+ * reaches them. Expansions are made of tokens of the files, whose names are
+ * interned when they are lexed, and only tokens made by '#' and "##" get
+ * new spellings. Every token carries an interned hide set (see
+ * HideSetTable) to stop recursion.
+ *
+ * Including a header again is skipped without reading its tokens when it
+ * has "#pragma once" or its include guard (see LexedFile::GetGuard()) is
+ * defined.
+ *
+ * Like the parser, it calls exit() on errors, like a missing header or an
+ * unbalanced #endif.
+ */
+class Preprocessor {
+ public:
+  /**
+   * @param source the main file of a translation unit
+   * @param path the path of source, relative to which "name" is included
+   * first
+   * @param include_dirs directories in which <name> is searched, and then
+   * "name"
+   * @param cache
+   */
+  explicit Preprocessor(std::shared_ptr<const SourceBuffer> source,
+                        std::string path = "",
+                        std::vector<std::string> include_dirs = {},
+                        HeaderCache &cache = HeaderCache::Global());
+
+  /**
+   * Get and consume the next token. The token is valid as long as the
+   * preprocessor.
+   *
+   * @return an empty token at the end of the translation unit
+   */
+  Token Next();
+
+  /**
+   * Get but not consume the next token.
+   *
+   * @return
+   */
+  Token Peek();
+
+  /**
+   * Add a consumed token back to the Preprocessor.
+   * @param token
+   */
+  void Rollback(const Token &token);
+
+  /**
+   * @param name
+   * @return whether name is defined as a macro now
+   */
+  [[nodiscard]] bool IsDefined(Symbol name) const {
+    return macros_.count(name) != 0;
+  }
+
+  /**
+   * @return number of #include skipped by include guards and #pragma once
+   */
+  [[nodiscard]] int SkippedIncludeCount() const {
+    return skipped_include_count_;
+  }
+
+ private:
+  /**
+   * Deeper includes are taken as a recursion.
+   */
+  static constexpr int kMaxIncludeDepth = 200;
+
+  /**
+   * A token with what macro expansion needs.
+   */
+  struct MacroToken {
+    Token token;
+    // the spelling interned if it is an identifier or a keyword
+    Symbol name;
+    // an id of hide_sets_
+    std::uint32_t hide_set;
+  };
+
+  /**
+   * An argument of a macro, which is [begin, end) of the tokens of all
+   * arguments.
+   */
+  using Argument = std::pair<std::size_t, std::size_t>;
+
+  /**
+   * A file being read, from the main file to the innermost header.
+   */
+  struct Frame {
+    std::shared_ptr<const LexedFile> file;
+    // the next token to read
+    std::size_t index;
+    // size of conditionals_ when the file is entered
+    std::size_t conditional_depth;
+  };
+
+  /**
+   * A #if, #ifdef or #ifndef whose #endif isn't read yet.
+   */
+  struct Conditional {
+    // whether tokens of the current group are kept
+    bool taking;
+    // whether a group has been taken, so later groups are skipped
+    bool taken;
+    bool seen_else;
+  };
+
+  /**
+   * @return the next token after macro expansion, or an empty token if no
+   * token remains
+   */
+  Token NextToken();
+
+  /**
+   * @return the next token of an expansion or the files before macro
+   * expansion. In ExpandAll(), no token is read after the expanded tokens.
+   */
+  MacroToken NextUnexpanded();
+
+  /**
+   * Read the tokens left in the files and run directives until a token is
+   * kept.
+   *
+   * @return If no token remains, it returns an empty token.
+   */
+  MacroToken ReadToken();
+
+  /**
+   * If token is the name of a macro that isn't in its hide set, read the
+   * arguments of the macro and push the expansion back to be read again.
+   *
+   * @param token
+   * @return whether token is expanded
+   */
+  bool Expand(const MacroToken &token);
+
+  /**
+   * Push the replacement list of macro with the arguments substituted.
+   *
+   * @param macro
+   * @param tokens the tokens of all arguments
+   * @param args
+   * @param hide_set It is added to every token.
+   */
+  void Substitute(const Macro &macro, const std::vector<MacroToken> &tokens,
+                  const std::vector<Argument> &args, std::uint32_t hide_set);
+
+  /**
+   * Expand macros in [begin, end) as if no token follows them, like an
+   * argument of a macro.
+   *
+   * @param begin
+   * @param end
+   * @param expanded the tokens after expansion are appended to it
+   */
+  void ExpandAll(const MacroToken *begin, const MacroToken *end,
+                 std::vector<MacroToken> &expanded);
+
+  /**
+   * @param begin
+   * @param end
+   * @return a string literal of the spellings of [begin, end)
+   */
+  static MacroToken Stringize(const MacroToken *begin, const MacroToken *end);
+
+  /**
+   * @param left
+   * @param right
+   * @return the token whose spelling is left followed by right
+   */
+  static MacroToken Paste(const MacroToken &left, const MacroToken &right);
+
+  /**
+   * Run the directive at the current index of the innermost file.
+   */
+  void RunDirective();
+
+  /**
+   * Enter the header of "#include "name"", "#include <name>" or a line
+   * whose macros expand to either.
+   *
+   * @param file
+   * @param begin the first token after the name of the directive
+   * @param end the end of the line
+   */
+  void Include(const LexedFile &file, std::size_t begin, std::size_t end);
+
+  /**
+   * @param includer the file that includes the header
+   * @param name
+   * @param quoted whether it is "name" instead of <name>
+   * @return the header, or nullptr if it isn't found
+   */
+  std::shared_ptr<const LexedFile> FindHeader(const LexedFile &includer,
+                                              std::string_view name,
+                                              bool quoted);
+
+  /**
+   * @param file
+   * @param begin the first token after "#if" or "#elif"
+   * @param end the end of the line
+   * @return whether the condition after macro expansion isn't 0
+   */
+  bool Evaluate(const LexedFile &file, std::size_t begin, std::size_t end);
+
+  /**
+   * @param file
+   * @param i the token after the name of a directive
+   * @param end the end of the line
+   * @return the macro name of a directive like "#define name"
+   */
+  static Symbol GetMacroName(const LexedFile &file, std::size_t i,
+                             std::size_t end);
+
+  [[nodiscard]] bool Skipping() const {
+    return !conditionals_.empty() && !conditionals_.back().taking;
+  }
+
+  HeaderCache *cache_;
+  std::vector<std::string> include_dirs_;
+  std::vector<Frame> frames_;
+  std::vector<Conditional> conditionals_;
+  std::unordered_map<Symbol, Macro> macros_;
+  HideSetTable hide_sets_;
+  // tokens of expansions to read before the files, from the last one
+  std::vector<MacroToken> pending_;
+  // ExpandAll() stops at this size of pending_
+  std::size_t pending_floor_{0};
+  // whether ExpandAll() is running, so the files aren't read
+  bool expanding_all_{false};
+  // included files that have "#pragma once"
+  std::unordered_set<const LexedFile *> once_files_;
+  // every file read, which keeps tokens valid after the cache is cleared
+  std::unordered_set<std::shared_ptr<const LexedFile>> files_;
+  // store tokens that are got but not consumed immediately
+  std::vector<Token> tokens_;
+  int skipped_include_count_{0};
+};
+}
+
+#endif // CCOMPILER_PREPROCESSOR_H
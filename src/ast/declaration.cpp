@@ -19,7 +19,7 @@ ObjectDecl::ObjectDecl(Object *object, Initializer *initializer)
   object_->decl_ = this;
 }
 
-string ObjectDecl::GetIdent() {
+Symbol ObjectDecl::GetIdent() {
   return object_->GetIdent();
 }
 
@@ -41,6 +41,10 @@ bool ObjectDecl::operator==(const ObjectDecl &rhs) const {
   return object_equal && init_equal;
 }
 
+Symbol FuncDecl::GetIdent() {
+  return func_->GetIdent();
+}
+
 bool FuncDecl::operator==(const FuncDecl &rhs) const {
   if (func_ == nullptr) {
     return rhs.func_ == nullptr;
@@ -61,7 +65,7 @@ bool TypeDecl::operator==(const TypeDecl &rhs) const {
   return type_->Equal(rhs.type_);
 }
 
-string TypeDecl::GetIdent() {
+Symbol TypeDecl::GetIdent() {
   return type_->GetIdent();
 }
 
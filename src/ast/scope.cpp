@@ -11,7 +11,7 @@ using namespace CCompiler;
 using namespace std;
 
 
-Object *Scope::GetObject(const string &ident) {
+Object *Scope::GetObject(Symbol ident) {
   // find an object in the current scope
   for (auto &decl:decl_list_) {
     if (decl->GetIdent() == ident) {
@@ -29,7 +29,7 @@ Object *Scope::GetObject(const string &ident) {
   return nullptr;
 }
 
-TypeDeclType *Scope::GetType(const string &ident) {
+TypeDeclType *Scope::GetType(Symbol ident) {
   // find an type in the current scope
   for (auto &decl:decl_list_) {
     if (decl->GetIdent() == ident) {
@@ -47,7 +47,7 @@ TypeDeclType *Scope::GetType(const string &ident) {
   return nullptr;
 }
 
-Function *Scope::GetFunc(const string &ident) {
+Function *Scope::GetFunc(Symbol ident) {
   for (auto &decl:decl_list_) {
     if (decl->GetIdent() == ident && typeid(*decl) == typeid(FuncDecl)) {
       return dynamic_cast<FuncDecl *>(decl)->GetFunc();
@@ -80,7 +80,7 @@ void Scope::AddIdent(FuncDecl *func_decl) {
 void Scope::AddIdent(TypeDecl *type_decl) {
   // TODO(dxy): typedef permits multiple definitions
   // type declared with no tag doesn't have to consider redefinition
-  if (!type_decl->GetIdent().empty()) {
+  if (!type_decl->GetIdent().Empty()) {
     for (auto &decl:decl_list_) {
       if (typeid(*decl) == typeid(TypeDecl) &&
           decl->GetIdent() == type_decl->GetIdent()) {
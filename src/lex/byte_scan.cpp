@@ -0,0 +1,267 @@
+//
+// Created by dxy on 2020/12/12.
+//
+
+#include "lex/byte_scan.h"
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CCOMPILER_X86_SIMD
+
+#include <immintrin.h>
+
+#endif
+
+using namespace CCompiler;
+using namespace std;
+
+namespace {
+const char *SkipRangesScalar(const char *begin, const char *end,
+                             const ByteRanges &ranges) {
+  while (begin != end && ranges.Contains(*begin)) {
+    begin++;
+  }
+  return begin;
+}
+
+const char *FindPairScalar(const char *begin, const char *end, char first,
+                           char second) {
+  for (auto it = begin; it + 1 < end; ++it) {
+    if (it[0] == first && it[1] == second) {
+      return it;
+    }
+  }
+  return end;
+}
+
+void FindAllScalar(const char *base, const char *begin, const char *end,
+                   char c, vector<uint32_t> &offsets) {
+  for (auto it = begin; it != end; ++it) {
+    if (*it == c) {
+      offsets.push_back(it - base);
+    }
+  }
+}
+
+/**
+ * @param base
+ * @param begin
+ * @param mask bit i is set if begin[i] is found
+ * @param offsets offsets of found bytes from base are appended to it
+ */
+void AppendMask(const char *base, const char *begin, uint32_t mask,
+                vector<uint32_t> &offsets) {
+  while (mask != 0) {
+    offsets.push_back(begin - base + countr_zero(mask));
+    mask &= mask - 1;
+  }
+}
+
+#ifdef CCOMPILER_X86_SIMD
+
+/**
+ * @param v
+ * @param ranges
+ * @return 0xff in bytes of v that are in ranges and 0 in others
+ */
+__m128i InRangesSse2(__m128i v, const ByteRanges &ranges) {
+  auto zero = _mm_setzero_si128();
+  auto in = zero;
+  for (int i = 0; i < ranges.count; ++i) {
+    // c is in [low, high] iff (c - low) saturating-minus (high - low) is 0
+    auto offset = _mm_sub_epi8(v, _mm_set1_epi8(ranges.lows[i]));
+    auto over = _mm_subs_epu8(
+            offset, _mm_set1_epi8(ranges.highs[i] - ranges.lows[i]));
+    in = _mm_or_si128(in, _mm_cmpeq_epi8(over, zero));
+  }
+  return in;
+}
+
+const char *SkipRangesSse2(const char *begin, const char *end,
+                           const ByteRanges &ranges) {
+  for (; end - begin >= 16; begin += 16) {
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+    auto out = ~static_cast<uint32_t>(
+            _mm_movemask_epi8(InRangesSse2(v, ranges))) & 0xffff;
+    if (out != 0) {
+      return begin + countr_zero(out);
+    }
+  }
+  return SkipRangesScalar(begin, end, ranges);
+}
+
+const char *FindPairSse2(const char *begin, const char *end, char first,
+                         char second) {
+  auto first_v = _mm_set1_epi8(first), second_v = _mm_set1_epi8(second);
+  // the second byte is loaded from it + 1, so stop one byte earlier
+  for (; end - begin >= 17; begin += 16) {
+    auto v0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+    auto v1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin + 1));
+    auto found = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(v0, first_v),
+                          _mm_cmpeq_epi8(v1, second_v))));
+    if (found != 0) {
+      return begin + countr_zero(found);
+    }
+  }
+  return FindPairScalar(begin, end, first, second);
+}
+
+void FindAllSse2(const char *base, const char *begin, const char *end, char c,
+                 vector<uint32_t> &offsets) {
+  auto c_v = _mm_set1_epi8(c);
+  for (; end - begin >= 16; begin += 16) {
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+    AppendMask(base, begin, _mm_movemask_epi8(_mm_cmpeq_epi8(v, c_v)),
+               offsets);
+  }
+  FindAllScalar(base, begin, end, c, offsets);
+}
+
+__attribute__((target("avx2")))
+const char *SkipRangesAvx2(const char *begin, const char *end,
+                           const ByteRanges &ranges) {
+  auto zero = _mm256_setzero_si256();
+  for (; end - begin >= 32; begin += 32) {
+    auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+    auto in = zero;
+    for (int i = 0; i < ranges.count; ++i) {
+      auto offset = _mm256_sub_epi8(v, _mm256_set1_epi8(ranges.lows[i]));
+      auto over = _mm256_subs_epu8(
+              offset, _mm256_set1_epi8(ranges.highs[i] - ranges.lows[i]));
+      in = _mm256_or_si256(in, _mm256_cmpeq_epi8(over, zero));
+    }
+    auto out = ~static_cast<uint32_t>(_mm256_movemask_epi8(in));
+    if (out != 0) {
+      return begin + countr_zero(out);
+    }
+  }
+  return SkipRangesSse2(begin, end, ranges);
+}
+
+__attribute__((target("avx2")))
+const char *FindPairAvx2(const char *begin, const char *end, char first,
+                         char second) {
+  auto first_v = _mm256_set1_epi8(first), second_v = _mm256_set1_epi8(second);
+  for (; end - begin >= 33; begin += 32) {
+    auto v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+    auto v1 = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(begin + 1));
+    auto found = static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(v0, first_v),
+                             _mm256_cmpeq_epi8(v1, second_v))));
+    if (found != 0) {
+      return begin + countr_zero(found);
+    }
+  }
+  return FindPairSse2(begin, end, first, second);
+}
+
+__attribute__((target("avx2")))
+void FindAllAvx2(const char *base, const char *begin, const char *end, char c,
+                 vector<uint32_t> &offsets) {
+  auto c_v = _mm256_set1_epi8(c);
+  for (; end - begin >= 32; begin += 32) {
+    auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+    AppendMask(base, begin, _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, c_v)),
+               offsets);
+  }
+  FindAllSse2(base, begin, end, c, offsets);
+}
+
+#endif
+}
+
+SimdLevel CCompiler::BestSimdLevel() {
+#ifdef CCOMPILER_X86_SIMD
+  static const auto kLevel = __builtin_cpu_supports("avx2") ?
+                             SimdLevel::kAvx2 : SimdLevel::kSse2;
+  return kLevel;
+#else
+  return SimdLevel::kScalar;
+#endif
+}
+
+ByteRanges ByteRanges::FromBytes(const bool (&bytes)[256]) {
+  ByteRanges ranges;
+
+  for (int c = 0; c < 256; ++c) {
+    if (!bytes[c]) {
+      continue;
+    }
+    ranges.bits[c / 64] |= uint64_t{1} << (c % 64);
+    if (c > 0 && bytes[c - 1]) {
+      continue;
+    }
+    if (ranges.count == kMaxRanges) {
+      return ByteRanges();
+    }
+
+    auto high = c;
+    while (high + 1 < 256 && bytes[high + 1]) {
+      high++;
+    }
+    ranges.lows[ranges.count] = c;
+    ranges.highs[ranges.count] = high;
+    ranges.count++;
+  }
+
+  return ranges;
+}
+
+StrConstIt CCompiler::SkipRanges(StrConstIt begin, StrConstIt end,
+                                 const ByteRanges &ranges, SimdLevel level) {
+  auto first = to_address(begin), last = to_address(end);
+  switch (level) {
+#ifdef CCOMPILER_X86_SIMD
+    case SimdLevel::kAvx2:
+      return begin + (SkipRangesAvx2(first, last, ranges) - first);
+    case SimdLevel::kSse2:
+      return begin + (SkipRangesSse2(first, last, ranges) - first);
+#endif
+    default:
+      return begin + (SkipRangesScalar(first, last, ranges) - first);
+  }
+}
+
+StrConstIt CCompiler::FindPair(StrConstIt begin, StrConstIt end, char first,
+                               char second, SimdLevel level) {
+  auto data = to_address(begin), data_end = to_address(end);
+  switch (level) {
+#ifdef CCOMPILER_X86_SIMD
+    case SimdLevel::kAvx2:
+      return begin + (FindPairAvx2(data, data_end, first, second) - data);
+    case SimdLevel::kSse2:
+      return begin + (FindPairSse2(data, data_end, first, second) - data);
+#endif
+    default:
+      return begin + (FindPairScalar(data, data_end, first, second) - data);
+  }
+}
+
+StrConstIt CCompiler::FindByte(StrConstIt begin, StrConstIt end, char c) {
+  auto found = memchr(to_address(begin), c, end - begin);
+  return found == nullptr ?
+         end : begin + (static_cast<const char *>(found) - to_address(begin));
+}
+
+void CCompiler::FindAll(StrConstIt begin, StrConstIt end, char c,
+                        vector<uint32_t> &offsets, SimdLevel level) {
+  auto data = to_address(begin), data_end = to_address(end);
+  switch (level) {
+#ifdef CCOMPILER_X86_SIMD
+    case SimdLevel::kAvx2:
+      FindAllAvx2(data, data, data_end, c, offsets);
+      break;
+    case SimdLevel::kSse2:
+      FindAllSse2(data, data, data_end, c, offsets);
+      break;
+#endif
+    default:
+      FindAllScalar(data, data, data_end, c, offsets);
+  }
+}
@@ -0,0 +1,586 @@
+//
+// Created by dxy on 2020/12/2.
+//
+
+#include "lex/dfa.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+#include "lex/mapped_file.h"
+#include "lex/token.h"
+
+using namespace CCompiler;
+using namespace std;
+
+/**
+ * Header of the file written by Dfa::Save(). It is followed by byte
+ * classes, accept types and transitions of the table, all stored as native
+ * int, and then keywords written by KeywordTable::Serialize().
+ */
+struct DfaFileHeader {
+  char magic[8];
+  uint32_t version;
+  int32_t state_count;
+  int32_t start_state;
+  int32_t class_count;
+  uint32_t keyword_size;
+  uint32_t reserved;
+  uint64_t fingerprint;
+  // FNV-1a of the header with checksum set to 0, the table and keywords
+  uint64_t checksum;
+};
+
+const char kDfaFileMagic[8] = "CCDFA";
+
+/**
+ * 64-bit FNV-1a hash.
+ *
+ * @param data
+ * @param size
+ * @param hash the hash of the data before 'data'
+ * @return
+ */
+uint64_t Fnv1a(const void *data, size_t size,
+               uint64_t hash = 0xcbf29ce484222325);
+
+/**
+ * @param header checksum is ignored
+ * @return number of ints following the header
+ */
+size_t DfaFileTableSize(const DfaFileHeader &header);
+
+/**
+ * @param header checksum is ignored
+ * @param table byte classes, accept types and transitions
+ * @param keywords
+ * @return checksum of a DFA file
+ */
+uint64_t DfaFileChecksum(DfaFileHeader header, const int *table,
+                         const char *keywords);
+
+Dfa::Dfa(const Nfa &nfa, int max_states) {
+  Table table;
+  // state 0 is the dead state and all its edges point to itself
+  table.NewState(kNotAccept);
+
+  if (nfa.begin_state_ == -1) {
+    Assign(std::move(table));
+    return;
+  }
+
+  table.class_count = ByteClasses(nfa, table.byte_classes);
+  table.transitions.assign(table.class_count, kDeadState);
+  // a byte standing for every class
+  vector<unsigned char> class_chars(table.class_count);
+  for (int c = kAlphabetSize - 1; c >= 0; --c) {
+    class_chars[table.byte_classes[c]] = c;
+  }
+
+  map<NfaStateSet, int> dfa_states;
+  vector<NfaStateSet> unmarked;
+
+  NfaStateSet start;
+  Closure(nfa, nfa.begin_state_, start);
+  table.start_state = table.NewState(AcceptType(nfa, start));
+  dfa_states[start] = table.start_state;
+  unmarked.push_back(std::move(start));
+
+  for (size_t i = 0; i < unmarked.size(); ++i) {
+    int from = dfa_states[unmarked[i]];
+    for (int byte_class = 0; byte_class < table.class_count; ++byte_class) {
+      auto next = Move(nfa, unmarked[i], class_chars[byte_class]);
+      if (next.empty()) {
+        continue;
+      }
+
+      auto it = dfa_states.find(next);
+      if (it == dfa_states.end()) {
+        if (table.StateCount() >= max_states) {  // give up
+          table = Table();
+          table.NewState(kNotAccept);
+          Assign(std::move(table));
+          return;
+        }
+        it = dfa_states.insert(
+                {next, table.NewState(AcceptType(nfa, next))}).first;
+        unmarked.push_back(std::move(next));
+      }
+      table.transitions[from * table.class_count + byte_class] = it->second;
+    }
+  }
+
+  table.MergeClasses();
+  Assign(std::move(table));
+  if (!nfa.GetKeywords().Empty()) {
+    keywords_ = make_shared<const KeywordTable>(nfa.GetKeywords());
+  }
+}
+
+optional<AcceptState> Dfa::NextMatch(StrConstIt begin, StrConstIt end) const {
+  if (Empty()) {
+    return nullopt;
+  }
+
+  int state = start_state_;
+  auto last_accept = accept_types_[state];
+  auto last_end = begin;
+
+  for (auto it = begin; it != end;) {
+    state = transitions_[state * class_count_ +
+                         byte_classes_[static_cast<unsigned char>(*it++)]];
+    if (state == kDeadState) {
+      break;
+    }
+    if (accelerations_[state].count != 0) {
+      it = SkipRanges(it, end, accelerations_[state]);
+    }
+    if (accept_types_[state] != kNotAccept) {
+      last_accept = accept_types_[state];
+      last_end = it;
+    }
+  }
+
+  if (last_accept == kNotAccept) {
+    return nullopt;
+  }
+  return AcceptState{
+          GetKeywords().Classify(static_cast<TokenType>(last_accept), begin,
+                                 last_end), last_end};
+}
+
+void Dfa::Minimize() {
+  if (Empty()) {
+    return;
+  }
+
+  int state_count = StateCount();
+  Table table;
+  table.start_state = start_state_;
+  table.class_count = class_count_;
+  table.byte_classes.assign(byte_classes_, byte_classes_ + kAlphabetSize);
+  table.accept_types.assign(accept_types_, accept_types_ + state_count);
+  table.transitions.assign(transitions_,
+                           transitions_ + state_count * class_count_);
+
+  // predecessors[byte_class][state] -- states that reach 'state' by
+  // consuming a byte in byte_class
+  vector<vector<vector<int>>> predecessors(
+          class_count_, vector<vector<int>>(state_count));
+  for (int state = 0; state < state_count; ++state) {
+    for (int byte_class = 0; byte_class < class_count_; ++byte_class) {
+      predecessors[byte_class][table.transitions[
+              state * class_count_ + byte_class]].push_back(state);
+    }
+  }
+
+  // initial partition by accept types
+  vector<int> block_of(state_count);
+  vector<vector<int>> blocks;
+  map<int, int> type_blocks;
+  for (int state = 0; state < state_count; ++state) {
+    auto it = type_blocks.find(table.accept_types[state]);
+    if (it == type_blocks.end()) {
+      it = type_blocks.insert({table.accept_types[state], blocks.size()}).first;
+      blocks.emplace_back();
+    }
+    block_of[state] = it->second;
+    blocks[it->second].push_back(state);
+  }
+
+  deque<int> work_list;
+  vector<bool> in_work_list(blocks.size(), true);
+  for (int i = 0; i < static_cast<int>(blocks.size()); ++i) {
+    work_list.push_back(i);
+  }
+
+  // mark[state] == stamp means 'state' is a predecessor of the splitter
+  vector<int> mark(state_count, -1);
+  int stamp = 0;
+  while (!work_list.empty()) {
+    auto splitter = blocks[work_list.front()];
+    in_work_list[work_list.front()] = false;
+    work_list.pop_front();
+
+    for (int byte_class = 0; byte_class < class_count_; ++byte_class) {
+      map<int, vector<int>> touched_blocks;
+      for (auto state:splitter) {
+        for (auto pre:predecessors[byte_class][state]) {
+          if (mark[pre] != stamp) {
+            mark[pre] = stamp;
+            touched_blocks[block_of[pre]].push_back(pre);
+          }
+        }
+      }
+      stamp++;
+
+      for (auto &[block, inside]:touched_blocks) {
+        if (inside.size() == blocks[block].size()) {
+          continue;
+        }
+
+        // split 'block' into states inside the predecessors and the others
+        int new_block = blocks.size();
+        vector<int> outside;
+        for (auto state:blocks[block]) {
+          if (mark[state] != stamp - 1) {
+            outside.push_back(state);
+          }
+        }
+        for (auto state:inside) {
+          block_of[state] = new_block;
+        }
+        blocks[block] = std::move(outside);
+        blocks.push_back(std::move(inside));
+        in_work_list.push_back(false);
+
+        if (in_work_list[block] ||
+            blocks[new_block].size() <= blocks[block].size()) {
+          work_list.push_back(new_block);
+          in_work_list[new_block] = true;
+        } else {
+          work_list.push_back(block);
+          in_work_list[block] = true;
+        }
+      }
+    }
+  }
+
+  table.Renumber(block_of, blocks.size());
+  // keep the dead state as state 0
+  auto dead_block = block_of[kDeadState];
+  vector<int> swap_dead(blocks.size());
+  for (int i = 0; i < static_cast<int>(blocks.size()); ++i) {
+    swap_dead[i] = i == dead_block ? kDeadState :
+                   i == kDeadState ? dead_block : i;
+  }
+  table.Renumber(swap_dead, blocks.size());
+
+  if (table.start_state == kDeadState) {  // nothing can be matched
+    table = Table();
+    table.NewState(kNotAccept);
+  } else {
+    table.Renumber(table.BfsOrder(), blocks.size());
+    table.MergeClasses();
+  }
+  Assign(std::move(table));
+}
+
+int Dfa::Table::NewState(int accept_type) {
+  accept_types.push_back(accept_type);
+  transitions.resize(transitions.size() + class_count, kDeadState);
+  return StateCount() - 1;
+}
+
+void Dfa::Table::Renumber(const vector<int> &new_states, int state_count) {
+  vector<int> new_transitions(state_count * class_count, kDeadState);
+  vector<int> new_accept_types(state_count, kNotAccept);
+
+  for (int state = 0; state < static_cast<int>(new_states.size());
+       ++state) {
+    auto new_state = new_states[state];
+    new_accept_types[new_state] = accept_types[state];
+    for (int byte_class = 0; byte_class < class_count; ++byte_class) {
+      new_transitions[new_state * class_count + byte_class] =
+              new_states[transitions[state * class_count + byte_class]];
+    }
+  }
+
+  start_state = new_states[start_state];
+  transitions = std::move(new_transitions);
+  accept_types = std::move(new_accept_types);
+}
+
+vector<int> Dfa::Table::BfsOrder() const {
+  vector<int> new_states(StateCount(), -1);
+  vector<int> queue{start_state};
+  new_states[kDeadState] = kDeadState;
+  new_states[start_state] = 1;
+  int next_state = 2;
+
+  for (size_t i = 0; i < queue.size(); ++i) {
+    for (int byte_class = 0; byte_class < class_count; ++byte_class) {
+      auto next = transitions[queue[i] * class_count + byte_class];
+      if (new_states[next] == -1) {
+        new_states[next] = next_state++;
+        queue.push_back(next);
+      }
+    }
+  }
+
+  return new_states;
+}
+
+void Dfa::Table::MergeClasses() {
+  map<vector<int>, int> columns;
+  vector<int> new_classes(class_count);
+
+  for (int byte_class = 0; byte_class < class_count; ++byte_class) {
+    vector<int> column(StateCount());
+    for (int state = 0; state < StateCount(); ++state) {
+      column[state] = transitions[state * class_count + byte_class];
+    }
+    new_classes[byte_class] =
+            columns.insert({std::move(column), columns.size()}).first->second;
+  }
+
+  int new_class_count = columns.size();
+  vector<int> new_transitions(StateCount() * new_class_count);
+  for (int state = 0; state < StateCount(); ++state) {
+    for (int byte_class = 0; byte_class < class_count; ++byte_class) {
+      new_transitions[state * new_class_count + new_classes[byte_class]] =
+              transitions[state * class_count + byte_class];
+    }
+  }
+  for (auto &byte_class:byte_classes) {
+    byte_class = new_classes[byte_class];
+  }
+
+  class_count = new_class_count;
+  transitions = std::move(new_transitions);
+}
+
+void Dfa::Assign(Table table) {
+  auto storage = make_shared<const Table>(std::move(table));
+
+  start_state_ = storage->start_state;
+  state_count_ = storage->StateCount();
+  class_count_ = storage->class_count;
+  byte_classes_ = storage->byte_classes.data();
+  accept_types_ = storage->accept_types.data();
+  transitions_ = storage->transitions.data();
+  storage_ = std::move(storage);
+  AccelerationsInit();
+}
+
+void Dfa::AccelerationsInit() {
+  accelerations_.assign(state_count_, ByteRanges());
+  for (int state = 0; state < state_count_; ++state) {
+    if (state == kDeadState) {
+      continue;
+    }
+
+    bool loop[kAlphabetSize];
+    for (int c = 0; c < kAlphabetSize; ++c) {
+      loop[c] = GetNextState(state, c) == state;
+    }
+    accelerations_[state] = ByteRanges::FromBytes(loop);
+  }
+}
+
+bool Dfa::Save(const string &path, uint64_t fingerprint) const {
+  DfaFileHeader header{};
+  memcpy(header.magic, kDfaFileMagic, sizeof(header.magic));
+  header.version = kFormatVersion;
+  header.state_count = state_count_;
+  header.start_state = start_state_;
+  header.class_count = class_count_;
+  header.fingerprint = fingerprint;
+
+  // the arrays may not be adjacent in memory
+  vector<int> table(byte_classes_, byte_classes_ + kAlphabetSize);
+  table.insert(table.end(), accept_types_, accept_types_ + state_count_);
+  table.insert(table.end(), transitions_,
+               transitions_ + state_count_ * class_count_);
+  auto keywords = GetKeywords().Serialize();
+  header.keyword_size = keywords.size();
+  header.checksum = DfaFileChecksum(header, table.data(), keywords.data());
+
+  auto tmp_path = path + "." + to_string(getpid()) + ".tmp";
+  {
+    ofstream file(tmp_path, ios::binary | ios::trunc);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(table.data()),
+               table.size() * sizeof(int));
+    file.write(keywords.data(), keywords.size());
+    if (!file) {
+      file.close();
+      filesystem::remove(tmp_path);
+      return false;
+    }
+  }
+
+  error_code error;
+  filesystem::rename(tmp_path, path, error);
+  if (error) {
+    filesystem::remove(tmp_path, error);
+    return false;
+  }
+  return true;
+}
+
+optional<Dfa> Dfa::Load(const string &path, uint64_t fingerprint) {
+  shared_ptr<const MappedFile> file = MappedFile::Open(path);
+  if (file == nullptr || file->Size() < sizeof(DfaFileHeader)) {
+    return nullopt;
+  }
+
+  DfaFileHeader header{};
+  memcpy(&header, file->Data(), sizeof(header));
+  if (memcmp(header.magic, kDfaFileMagic, sizeof(header.magic)) != 0 ||
+      header.version != kFormatVersion ||
+      header.fingerprint != fingerprint ||
+      header.state_count <= 0 ||
+      header.class_count <= 0 || header.class_count > kAlphabetSize ||
+      header.start_state < 0 || header.start_state >= header.state_count ||
+      file->Size() != sizeof(header) +
+                      DfaFileTableSize(header) * sizeof(int) +
+                      header.keyword_size) {
+    return nullopt;
+  }
+
+  auto table = reinterpret_cast<const int *>(file->Data() + sizeof(header));
+  auto keyword_data = file->Data() + sizeof(header) +
+                      DfaFileTableSize(header) * sizeof(int);
+  if (DfaFileChecksum(header, table, keyword_data) != header.checksum) {
+    return nullopt;
+  }
+  auto keywords = KeywordTable::Deserialize(keyword_data, header.keyword_size);
+  if (!keywords) {
+    return nullopt;
+  }
+
+  Dfa dfa;
+  dfa.start_state_ = header.start_state;
+  dfa.state_count_ = header.state_count;
+  dfa.class_count_ = header.class_count;
+  dfa.byte_classes_ = table;
+  dfa.accept_types_ = dfa.byte_classes_ + kAlphabetSize;
+  dfa.transitions_ = dfa.accept_types_ + header.state_count;
+  for (int c = 0; c < kAlphabetSize; ++c) {
+    if (dfa.byte_classes_[c] < 0 ||
+        dfa.byte_classes_[c] >= header.class_count) {
+      return nullopt;
+    }
+  }
+  for (int i = 0; i < header.state_count; ++i) {
+    // kNotAccept or a TokenType of a token
+    if (dfa.accept_types_[i] < kNotAccept ||
+        dfa.accept_types_[i] >= static_cast<int>(TokenType::kEmpty)) {
+      return nullopt;
+    }
+  }
+  for (int i = 0; i < header.state_count * header.class_count; ++i) {
+    if (dfa.transitions_[i] < 0 ||
+        dfa.transitions_[i] >= header.state_count) {
+      return nullopt;
+    }
+  }
+
+  if (!keywords->Empty()) {
+    dfa.keywords_ = make_shared<const KeywordTable>(std::move(*keywords));
+  }
+  dfa.storage_ = std::move(file);
+  dfa.AccelerationsInit();
+  return dfa;
+}
+
+uint64_t Dfa::Fingerprint(const map<string, TokenType> &regex_rules) {
+  uint64_t hash = Fnv1a(&kFormatVersion, sizeof(kFormatVersion));
+  hash = Fnv1a(&kEngineVersion, sizeof(kEngineVersion), hash);
+  for (auto &[regex, type]:regex_rules) {
+    // include '\0' to split adjacent rules
+    hash = Fnv1a(regex.c_str(), regex.size() + 1, hash);
+    hash = Fnv1a(&type, sizeof(type), hash);
+  }
+  return hash;
+}
+
+uint64_t Fnv1a(const void *data, size_t size, uint64_t hash) {
+  auto bytes = static_cast<const unsigned char *>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+size_t DfaFileTableSize(const DfaFileHeader &header) {
+  return Dfa::kAlphabetSize + static_cast<size_t>(header.state_count) *
+                              (header.class_count + 1);
+}
+
+uint64_t DfaFileChecksum(DfaFileHeader header, const int *table,
+                         const char *keywords) {
+  header.checksum = 0;
+  auto hash = Fnv1a(&header, sizeof(header));
+  hash = Fnv1a(table, DfaFileTableSize(header) * sizeof(int), hash);
+  return Fnv1a(keywords, header.keyword_size, hash);
+}
+
+int Dfa::ByteClasses(const Nfa &nfa, vector<int> &byte_classes) {
+  // functional states with the same bytes split bytes the same way
+  vector<ByteSet> functional_bytes;
+  for (int state = 0; state < nfa.StateCount(); ++state) {
+    if (nfa.GetStateType(state) != Nfa::StateType::kCommon) {
+      functional_bytes.push_back(nfa.GetFunctionalBytes(state));
+    }
+  }
+  sort(functional_bytes.begin(), functional_bytes.end());
+  functional_bytes.erase(
+          unique(functional_bytes.begin(), functional_bytes.end()),
+          functional_bytes.end());
+
+  // bytes with the same signature are equivalent for every NFA state
+  map<vector<int>, int> signatures;
+  for (int c = 0; c < kAlphabetSize; ++c) {
+    vector<int> signature{nfa.GetCharLocation(static_cast<char>(c))};
+    for (auto &bytes:functional_bytes) {
+      signature.push_back(bytes.Contains(c));
+    }
+    byte_classes[c] = signatures.insert(
+            {std::move(signature), signatures.size()}).first->second;
+  }
+  return static_cast<int>(signatures.size());
+}
+
+void Dfa::Closure(const Nfa &nfa, int state, NfaStateSet &states) {
+  if (states.insert(state).second &&
+      nfa.GetStateType(state) == Nfa::StateType::kCommon) {
+    auto closure = nfa.GetEmptyClosure(state);
+    states.insert(closure.begin(), closure.end());
+  }
+}
+
+Dfa::NfaStateSet Dfa::Move(const Nfa &nfa, const NfaStateSet &states,
+                           unsigned char c) {
+  NfaStateSet next_states;
+  int char_location = nfa.GetCharLocation(static_cast<char>(c));
+
+  for (auto state:states) {
+    if (nfa.GetStateType(state) == Nfa::StateType::kCommon) {
+      // range 0 is reserved for empty edges
+      if (char_location != Nfa::kEmptyEdge) {
+        for (auto next:nfa.GetNextStates(state, char_location)) {
+          Closure(nfa, next, next_states);
+        }
+      }
+    } else if (nfa.FunctionalMatch(state, static_cast<char>(c))) {
+      // the closure of a functional state is already closed
+      auto closure = nfa.GetEmptyClosure(state);
+      next_states.insert(closure.begin(), closure.end());
+    }
+  }
+
+  return next_states;
+}
+
+int Dfa::AcceptType(const Nfa &nfa, const NfaStateSet &states) {
+  int type = kNotAccept;
+
+  for (auto state:states) {
+    auto cur_type = nfa.accept_types_[state];
+    if (cur_type != Nfa::kNotAccept &&
+        (type == kNotAccept || cur_type < type)) {
+      type = cur_type;
+    }
+  }
+
+  return type;
+}
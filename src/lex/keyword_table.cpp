@@ -0,0 +1,152 @@
+//
+// Created by dxy on 2020/12/11.
+//
+
+#include "lex/keyword_table.h"
+
+#include <cstring>
+#include <unordered_set>
+
+#include "lex/nfa.h"
+#include "lex/token.h"
+
+using namespace CCompiler;
+using namespace std;
+
+KeywordTable KeywordTable::Extract(map<string, TokenType> &regex_rules) {
+  map<string, TokenType> others;
+  for (auto &regex_rule:regex_rules) {
+    auto literal = Literal(regex_rule.first);
+    if (!literal || literal->empty()) {
+      others.insert(regex_rule);
+    }
+  }
+  if (others.size() == regex_rules.size()) {
+    return KeywordTable();
+  }
+
+  // A literal is a keyword if the rule that wins on its whole spelling
+  // without it has a larger TokenType, so the literal used to win every tie.
+  Nfa nfa(others, false);
+  vector<Keyword> keywords;
+  for (auto it = regex_rules.begin(); it != regex_rules.end();) {
+    auto literal = Literal(it->first);
+    if (literal && !literal->empty()) {
+      string_view spelling(*literal);
+      auto match = nfa.NextMatch(spelling.cbegin(), spelling.cend());
+      if (match != nullptr && match->second == spelling.cend() &&
+          it->second < match->first) {
+        keywords.push_back({*literal, static_cast<int>(it->second),
+                            static_cast<int>(match->first)});
+        it = regex_rules.erase(it);
+        continue;
+      }
+    }
+    ++it;
+  }
+
+  return KeywordTable(std::move(keywords));
+}
+
+string KeywordTable::Serialize() const {
+  string data;
+  for (auto &keyword:keywords_) {
+    int32_t types[2] = {keyword.type, keyword.host};
+    data.append(reinterpret_cast<const char *>(types), sizeof(types));
+    data.append(keyword.spelling.c_str(), keyword.spelling.size() + 1);
+  }
+  return data;
+}
+
+optional<KeywordTable> KeywordTable::Deserialize(const char *data,
+                                                 size_t size) {
+  vector<Keyword> keywords;
+  // no seed separates two keywords with the same spelling
+  unordered_set<string_view> spellings;
+  auto end = data + size;
+
+  while (data != end) {
+    int32_t types[2];
+    if (static_cast<size_t>(end - data) < sizeof(types)) {
+      return nullopt;
+    }
+    memcpy(types, data, sizeof(types));
+    data += sizeof(types);
+
+    auto spelling_end = static_cast<const char *>(memchr(data, '\0',
+                                                         end - data));
+    auto type_count = static_cast<int32_t>(TokenType::kEmpty);
+    if (spelling_end == nullptr || spelling_end == data || types[0] < 0 ||
+        types[1] < 0 || types[0] >= type_count || types[1] >= type_count ||
+        !spellings.insert(string_view(data, spelling_end - data)).second) {
+      return nullopt;
+    }
+    keywords.push_back({string(data, spelling_end), types[0], types[1]});
+    data = spelling_end + 1;
+  }
+
+  return KeywordTable(std::move(keywords));
+}
+
+KeywordTable::KeywordTable(vector<Keyword> keywords)
+        : keywords_(std::move(keywords)) {
+  if (keywords_.empty()) {
+    return;
+  }
+
+  vector<int> offsets;
+  for (auto &keyword:keywords_) {
+    offsets.push_back(spellings_.size());
+    spellings_ += keyword.spelling;
+    if (find(hosts_.cbegin(), hosts_.cend(), keyword.host) == hosts_.cend()) {
+      hosts_.push_back(keyword.host);
+    }
+  }
+
+  // With 4 slots per keyword a seed without collisions is found after a few
+  // tries on average.
+  uint32_t slot_count = 1;
+  while (slot_count < 4 * keywords_.size()) {
+    slot_count *= 2;
+  }
+  mask_ = slot_count - 1;
+
+  for (seed_ = 0;; ++seed_) {
+    slots_.assign(slot_count, {0, 0, -1, -1});
+    bool collision = false;
+    for (size_t i = 0; i < keywords_.size() && !collision; ++i) {
+      string_view spelling(keywords_[i].spelling);
+      auto &slot = slots_[Hash(seed_, spelling.cbegin(), spelling.cend()) &
+                          mask_];
+      if (slot.host != -1) {
+        collision = true;
+      } else {
+        slot = {offsets[i], static_cast<int>(spelling.size()),
+                keywords_[i].type, keywords_[i].host};
+      }
+    }
+    if (!collision) {
+      break;
+    }
+  }
+}
+
+optional<string> KeywordTable::Literal(const string &regex) {
+  const string kMetaCharacters = "\\|.^$*+?()[]{}";
+  string literal;
+
+  for (auto it = regex.cbegin(); it != regex.cend(); ++it) {
+    if (*it == '\\') {
+      // only escaped meta characters stand for themselves
+      if (++it == regex.cend() ||
+          kMetaCharacters.find(*it) == string::npos) {
+        return nullopt;
+      }
+    } else if (kMetaCharacters.find(*it) != string::npos) {
+      return nullopt;
+    }
+    literal += *it;
+  }
+
+  return literal;
+}
@@ -0,0 +1,182 @@
+//
+// Created by dxy on 2020/12/15.
+//
+
+#include "lex/lazy_dfa.h"
+
+#include "lex/dfa.h"
+#include "lex/token.h"
+
+using namespace CCompiler;
+using namespace std;
+
+LazyDfa::LazyDfa(const Nfa &nfa, size_t memory_limit)
+        : nfa_(nfa),
+          memory_limit_(memory_limit),
+          byte_classes_(Dfa::kAlphabetSize) {
+  class_count_ = Dfa::ByteClasses(nfa_, byte_classes_);
+  Flush();
+}
+
+optional<AcceptState> LazyDfa::NextMatch(StrConstIt begin, StrConstIt end,
+                                         FailureMemo *memo) {
+  if (nfa_.begin_state_ == -1) {
+    return nullopt;
+  }
+  if (thrashing_) {
+    auto match = nfa_.NextMatch(begin, end);
+    if (match == nullptr) {
+      return nullopt;
+    }
+    return *match;
+  }
+
+  auto flushes = flush_count_;
+  auto sync_memo = [&]() {
+      if (memo != nullptr && memo->flush_count_ != flush_count_) {
+        memo->Clear();
+        memo->flush_count_ = flush_count_;
+      }
+  };
+  sync_memo();
+
+  int state = start_state_;
+  auto last_accept = accept_types_[state];
+  auto last_end = begin;
+  auto last_state = state;  // the state at last_end
+
+  auto it = begin;
+  for (; it != end; ++it) {
+    if (memo != nullptr && memo->Contains(state, &*it)) {
+      break;
+    }
+    auto next = transitions_[state * class_count_ +
+                             byte_classes_[static_cast<unsigned char>(*it)]];
+    if (next == kUnknownState) {
+      next = AddTransition(state, it);
+      if (next == kUnknownState) {  // start over with the NFA
+        bytes_since_flush_ += it - begin;
+        return NextMatch(begin, end, memo);
+      }
+      sync_memo();
+    }
+    if (next == kDeadState) {
+      break;
+    }
+    state = next;
+    if (accept_types_[state] != kNotAccept) {
+      last_accept = accept_types_[state];
+      last_end = it + 1;
+      last_state = state;
+    }
+  }
+  bytes_since_flush_ += last_end - begin;
+  // states before a flush are gone, so failures can't be replayed
+  if (memo != nullptr && flushes == flush_count_) {
+    AddFailures(last_state, last_end, it, end, *memo);
+  }
+
+  if (last_accept == kNotAccept) {
+    return nullopt;
+  }
+  return AcceptState{
+          nfa_.GetKeywords().Classify(static_cast<TokenType>(last_accept),
+                                      begin, last_end), last_end};
+}
+
+size_t LazyDfa::StateBitsHash::operator()(
+        const Nfa::StateBits &states) const {
+  // 64-bit FNV-1a over words
+  uint64_t hash = 0xcbf29ce484222325;
+  for (auto word:states) {
+    hash ^= word;
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+int LazyDfa::GetState(Nfa::StateBits states) {
+  auto it = state_ids_.find(states);
+  if (it != state_ids_.end()) {
+    return it->second;
+  }
+
+  // the dead state, the start state and one more are always kept
+  if (StateCount() > 2 && (StateCount() + 1) * StateBytes() > memory_limit_) {
+    if (++flush_count_ >= kMinFlushes &&
+        bytes_since_flush_ < kMinBytesPerState * state_sets_.size()) {
+      thrashing_ = true;
+      return kUnknownState;
+    }
+    Flush();
+    return GetState(std::move(states));
+  }
+
+  auto accept_type = nfa_.AcceptType(states);
+  it = state_ids_.insert({std::move(states), StateCount()}).first;
+  state_sets_.push_back(&it->first);
+  accept_types_.push_back(accept_type);
+  transitions_.resize(transitions_.size() + class_count_, kUnknownState);
+  return it->second;
+}
+
+void LazyDfa::Flush() {
+  state_ids_.clear();
+  state_sets_.clear();
+  accept_types_.clear();
+  transitions_.clear();
+  bytes_since_flush_ = 0;
+
+  // the dead state is the empty set and never leaves itself
+  Nfa::StateBits states((nfa_.StateCount() + 63) / 64);
+  GetState(states);
+  fill(transitions_.begin(), transitions_.end(), kDeadState);
+
+  if (nfa_.begin_state_ != -1) {
+    nfa_.AddState(nfa_.begin_state_, states);
+    start_state_ = GetState(std::move(states));
+  }
+}
+
+int LazyDfa::AddTransition(int state, StrConstIt c) {
+  Nfa::StateBits next_states(state_sets_[state]->size());
+  nfa_.NextStates(*state_sets_[state], c, next_states);
+
+  auto flushes = flush_count_;
+  auto next = GetState(std::move(next_states));
+  // the transition is only recorded if state survives
+  if (next != kUnknownState && flushes == flush_count_) {
+    transitions_[state * class_count_ +
+                 byte_classes_[static_cast<unsigned char>(*c)]] = next;
+  }
+  return next;
+}
+
+void LazyDfa::AddFailures(int state, StrConstIt location, StrConstIt stop,
+                          StrConstIt end, FailureMemo &memo) const {
+  if (stop - location < FailureMemo::kMinFailureRun) {
+    return;
+  }
+
+  // replay the cached transitions from the last accept state
+  for (; location != stop; ++location) {
+    memo.failures_.insert({state, &*location});
+    state = transitions_[state * class_count_ + byte_classes_[
+            static_cast<unsigned char>(*location)]];
+  }
+  if (stop != end) {
+    memo.failures_.insert({state, &*stop});
+  } else {
+    --stop;
+  }
+  if (memo.last_location_ == nullptr || memo.last_location_ < &*stop) {
+    memo.last_location_ = &*stop;
+  }
+}
+
+size_t LazyDfa::StateBytes() const {
+  // the hash node and the pointer to its key are counted roughly
+  return class_count_ * sizeof(int) + sizeof(int) +
+         (nfa_.StateCount() + 63) / 64 * sizeof(uint64_t) +
+         4 * sizeof(void *);
+}
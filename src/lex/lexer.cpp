@@ -4,14 +4,101 @@
 
 #include "lex/lexer.h"
 
+#include <thread>
+
 #include "environment.h"
+#include "lex/byte_scan.h"
+#include "lex/dfa.h"
+#include "lex/generated_scanner.h"
 #include "lex/nfa.h"
 #include "lex/token.h"
 
 using namespace CCompiler;
 using namespace std;
 
-Nfa Lexer::nfa_ = Nfa(map<string, TokenType>());
+shared_ptr<const Lexer::Automaton> Lexer::shared_automaton_ =
+        make_shared<const Automaton>();
+
+Lexer::Lexer(ifstream &source_file) : automaton_(shared_automaton_) {
+  SourceInit(SourceBuffer::Read(source_file));
+}
+
+Lexer::Lexer(shared_ptr<const SourceBuffer> source, StrConstIt begin,
+             StrConstIt end, bool in_comment)
+        : automaton_(shared_automaton_),
+          source_(std::move(source)),
+          cursor_(begin),
+          source_end_(end) {
+  if (in_comment) {
+    SkipBlockComment();
+  }
+}
+
+vector<Token> Lexer::LexParallel(const shared_ptr<const SourceBuffer> &source,
+                                int chunk_count) {
+  auto text = source->GetText();
+  chunk_count = max(chunk_count, 1);
+
+  // chunks[i] is [bounds[i], bounds[i + 1]) and starts at a line. Lines
+  // continued by a backslash are kept together, since a string literal may
+  // span them.
+  vector<StrConstIt> bounds{text.cbegin()};
+  for (int i = 1; i < chunk_count; ++i) {
+    auto it = FindByte(max(bounds.back(), text.cbegin() +
+                                          text.size() * i / chunk_count),
+                       text.cend(), '\n');
+    while (it != text.cend() && IsContinued(text, it)) {
+      it = FindByte(it + 1, text.cend(), '\n');
+    }
+    bounds.push_back(it == text.cend() ? it : it + 1);
+  }
+  bounds.push_back(text.cend());
+
+  struct Chunk {
+    vector<Token> tokens;
+    bool end_in_comment;
+  };
+  auto lex_chunk = [&](int i, bool in_comment) {
+    Lexer lexer(source, bounds[i], bounds[i + 1], in_comment);
+    Chunk chunk;
+    Token token;
+    while (!(token = lexer.Next()).Empty()) {
+      chunk.tokens.push_back(token);
+    }
+    chunk.end_in_comment = lexer.comment_flag_;
+    return chunk;
+  };
+
+  vector<Chunk> chunks(chunk_count);
+  vector<thread> threads;
+  for (int i = 1; i < chunk_count; ++i) {
+    threads.emplace_back([&, i]() {
+        chunks[i] = lex_chunk(i, false);
+    });
+  }
+  chunks[0] = lex_chunk(0, false);
+  for (auto &thread:threads) {
+    thread.join();
+  }
+
+  // Fix up wrong guesses in order, since a chunk lexed again may end in a
+  // different state.
+  size_t token_count = 0;
+  for (int i = 0; i < chunk_count; ++i) {
+    if (i > 0 && chunks[i - 1].end_in_comment) {
+      chunks[i] = lex_chunk(i, true);
+    }
+    token_count += chunks[i].tokens.size();
+  }
+
+  auto tokens = std::move(chunks[0].tokens);
+  tokens.reserve(token_count);
+  for (int i = 1; i < chunk_count; ++i) {
+    tokens.insert(tokens.cend(), chunks[i].tokens.cbegin(),
+                  chunks[i].tokens.cend());
+  }
+  return tokens;
+}
 
 Token Lexer::Next() {
   if (tokens_.empty()) {
@@ -31,56 +118,93 @@ Token Lexer::Peek() {
   return token;
 }
 
-Token Lexer::NextToken() {
-  static string line;
-  static auto begin = line.cbegin(), end = line.cend();
-  static bool line_flag = true;  // whether to read a new word from the file
-
-  while (true) {
-    if (line_flag) {
-      while (getline(source_stream_, line)) {
-        line_++;
-        column_ = 0;
-        line_flag = false;
-        begin = line.cbegin(), end = line.cend();
-        Token token = NextTokenInLine(begin, end);
-        if (!token.Empty()) {
-          return token;
+void Lexer::SkipBlockComment() {
+  auto comment_end = FindPair(cursor_, source_end_, '*', '/');
+  comment_flag_ = comment_end == source_end_;
+  cursor_ = comment_flag_ ? source_end_ : comment_end + 2;
+}
+
+bool Lexer::Refill() {
+  if (stream_ == nullptr) {
+    return false;
+  }
+
+  while (!stream_->AtEnd()) {
+    auto text = stream_->GetText();
+    auto cursor = cursor_ - text.cbegin();
+    auto keep = cursor;
+    for (auto &token:tokens_) {
+      auto position = token.GetToken().data() - text.data();
+      if (position >= 0 && position < keep) {
+        keep = position;
+      }
+    }
+    if (keep == 0 && text.size() == stream_->GetCapacity()) {
+      // pending tokens fill the whole window, which grows to keep them
+      auto old_data = text.data();
+      stream_->Grow();
+      text = stream_->GetText();
+      for (auto &token:tokens_) {
+        auto position = token.GetToken().data() - old_data;
+        if (position >= 0 && position < cursor) {
+          token.SetToken(string_view(text.data() + position,
+                                     token.GetToken().size()));
         }
       }
+    }
 
-      return Token();  // reach to the end of the file
-    } else {
-      Token token = NextTokenInLine(begin, end);
-      if (token.Empty()) {  // reach to the end of a line
-        line_flag = true;
-        continue;
+    // the window doesn't move, so only positions change
+    auto moved = static_cast<ptrdiff_t>(stream_->Refill(text.cbegin() + keep));
+    for (auto &token:tokens_) {
+      auto data = token.GetToken().data();
+      if (data >= text.data() + keep && data < text.data() + cursor) {
+        token.SetToken(string_view(data - moved, token.GetToken().size()));
+      }
+    }
+    text = stream_->GetText();
+    cursor_ = text.cbegin() + (cursor - moved);
+    // the memo holds locations of the old window with the old end
+    failure_memo_.Clear();
+
+    // stop after the last line that is complete in the window
+    source_end_ = text.cend();
+    if (!stream_->AtEnd()) {
+      auto it = source_end_;
+      while (it != cursor_ && (*(it - 1) != '\n' ||
+                               IsContinued(text, it - 1))) {
+        it--;
+      }
+      // a line longer than the window has to be cut
+      if (it != cursor_ || text.size() < stream_->GetCapacity()) {
+        source_end_ = it;
       }
-      return token;
+    }
+
+    if (comment_flag_) {
+      SkipBlockComment();
+    }
+    if (cursor_ != source_end_) {
+      return true;
     }
   }
+  return false;
 }
 
-Token Lexer::NextTokenInLine(StrConstIt &begin, StrConstIt &end) {
-  static bool comment_flag = false;  // used to skip /**/ comments
+Token Lexer::NextToken() {
+  auto &begin = cursor_;
+  auto &end = source_end_;
 
-  while (begin != end) {
-    auto pair = nfa_.NextMatch(begin, end);
-    if (pair == nullptr || begin == pair->second) {  // invalid token
+  while (begin != end || Refill()) {
+    auto pair = NextMatch(begin, end);
+    if (!pair || begin == pair->second) {  // invalid token
       // ignore the current character to find the next valid token
       begin++;
       continue;
     }
 
-    Token token(string{begin, pair->second}, pair->first);
+    Token token(string_view(begin, pair->second), pair->first,
+                GetOffset(begin));
     begin = pair->second;
-    if (comment_flag) {
-      if (token.GetToken() == "*/") {
-        comment_flag = false;
-      }
-      column_ += token.GetToken().size();
-      continue;
-    }
 
     if (token.GetType() == TokenType::kString ||
         token.GetType() == TokenType::kCharacter) {
@@ -88,33 +212,72 @@ Token Lexer::NextTokenInLine(StrConstIt &begin, StrConstIt &end) {
       while (begin != end) {
         if (*begin == token.GetToken()[0] && *(begin - 1) != '\\') {
           begin++;
-          token.SetToken(string(tmp, begin));
-          token.SetLine(line_);
-          token.SetColumn(column_);
-          column_ += begin - tmp;
+          token.SetToken(string_view(tmp, begin));
           return token;
         }
+        if (*begin == '\n') {
+          // only an escaped new line continues the literal
+          auto last = begin - 1;
+          if (*last == '\r' && last != tmp) {
+            last--;
+          }
+          if (*last != '\\') {  // drop the unterminated literal
+            break;
+          }
+        }
         begin++;
       }
     } else if (token.GetType() == TokenType::kComment) {
       if (token.GetToken() == "//") {  // skip the line
-        begin = end;
+        begin = FindByte(begin, end, '\n');
       } else if (token.GetToken() == "/*") {
-        comment_flag = true;
-        column_ += token.GetToken().size();
+        SkipBlockComment();
       }
-    } else if (token.GetType() == TokenType::kDelim) {
-      column_ += token.GetToken().size();
-    } else {
-      token.SetLine(line_);
-      token.SetColumn(column_);
-      column_ += token.GetToken().size();
+    } else if (token.GetType() != TokenType::kDelim) {
       return token;
     }
   }
   return Token();
 }
 
+optional<AcceptState> Lexer::NextMatch(StrConstIt begin,
+                                       StrConstIt end) const {
+#ifdef CCOMPILER_GENERATED_SCANNER
+  if (automaton_->use_generated_scanner) {
+    return GeneratedNextMatch(begin, end);
+  }
+#endif
+  if (!automaton_->dfa.Empty()) {
+    return automaton_->dfa.NextMatch(begin, end);
+  }
+
+  if (lazy_dfa_ == nullptr) {
+    lazy_dfa_ = make_unique<LazyDfa>(automaton_->nfa);
+  }
+  return lazy_dfa_->NextMatch(begin, end, &failure_memo_);
+}
+
+TokenStream Lexer::TokenizeAll() {
+  TokenStream stream(source_);
+  // C sources have about one token per 4 to 8 bytes
+  stream.Reserve((source_end_ - cursor_) / 8);
+  auto append = [&](const Token &token) {
+      stream.Append(token.GetType(), token.GetOffset(),
+                    token.GetToken().size());
+  };
+
+  for (auto &token:tokens_) {
+    append(token);
+  }
+  tokens_.clear();
+  Token token;
+  while (!(token = NextToken()).Empty()) {
+    append(token);
+  }
+
+  return stream;
+}
+
 void Lexer::Rollback(const Token &token) {
   tokens_.insert(tokens_.cbegin(), token);
 }
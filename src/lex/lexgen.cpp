@@ -0,0 +1,192 @@
+//
+// Created by dxy on 2020/12/9.
+//
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "environment.h"
+#include "lex/byte_scan.h"
+#include "lex/dfa.h"
+#include "lex/nfa.h"
+#include "lex/token.h"
+
+using namespace CCompiler;
+using namespace std;
+
+/**
+ * Emit a scanner for dfa in the style of re2c. Every DFA state becomes a
+ * label and its transitions become a switch on the next byte, so the host
+ * compiler can lay out and predict each state separately.
+ *
+ * @param dfa should be minimized first to keep the code small
+ * @param fingerprint
+ * @param os
+ */
+void EmitScanner(const Dfa &dfa, uint64_t fingerprint, ostream &os);
+
+/**
+ * Emit the perfect hash table of keywords as constants used by
+ * KeywordTable::Lookup().
+ *
+ * @param keywords
+ * @param os
+ */
+void EmitKeywords(const KeywordTable &keywords, ostream &os);
+
+/**
+ * Emit byte ranges of accelerated states as constants named
+ * kAcceleration<state>.
+ *
+ * @param dfa
+ * @param os
+ */
+void EmitAccelerations(const Dfa &dfa, ostream &os);
+
+/**
+ * Usage: ccompiler-lexgen <output.cpp>
+ */
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    cerr << "usage: " << argv[0] << " <output.cpp>" << endl;
+    return 1;
+  }
+
+  auto &regex_rules = Environment::GetRegexRules();
+  Dfa dfa{Nfa(regex_rules)};
+  dfa.Minimize();
+
+  ofstream file(argv[1], ios::trunc);
+  EmitScanner(dfa, Dfa::Fingerprint(regex_rules), file);
+  if (!file) {
+    cerr << "failed to write " << argv[1] << endl;
+    return 1;
+  }
+
+  return 0;
+}
+
+void EmitScanner(const Dfa &dfa, uint64_t fingerprint, ostream &os) {
+  os << "// Generated by ccompiler-lexgen. Do not edit.\n"
+        "\n"
+        "#include \"lex/generated_scanner.h\"\n"
+        "\n"
+        "#include \"lex/byte_scan.h\"\n"
+        "#include \"lex/keyword_table.h\"\n"
+        "#include \"lex/token.h\"\n"
+        "\n"
+        "namespace CCompiler {\n";
+  os << "const std::uint64_t kGeneratedScannerFingerprint = " << fingerprint
+     << "ull;\n\n";
+  EmitKeywords(dfa.GetKeywords(), os);
+  EmitAccelerations(dfa, os);
+  os << "std::optional<AcceptState> GeneratedNextMatch(StrConstIt begin,\n"
+        "                                              StrConstIt end) {\n"
+        "  auto it = begin, last_end = begin;\n";
+  os << "  int last_accept = " << Dfa::kNotAccept << ";\n";
+  if (!dfa.Empty()) {
+    os << "  goto state_" << dfa.GetStartState() << ";\n";
+  }
+
+  for (int state = 0; state < dfa.StateCount(); ++state) {
+    if (state == Dfa::kDeadState) {
+      continue;
+    }
+
+    os << "\nstate_" << state << ":\n";
+    if (dfa.GetAcceleration(state).count != 0) {
+      os << "  it = SkipRanges(it, end, kAcceleration" << state << ");\n";
+    }
+    if (dfa.GetAcceptType(state) != Dfa::kNotAccept) {
+      os << "  last_accept = " << dfa.GetAcceptType(state) << ";\n";
+      os << "  last_end = it;\n";
+    }
+    os << "  if (it == end) {\n"
+          "    goto done;\n"
+          "  }\n"
+          "  switch (static_cast<unsigned char>(*it++)) {\n";
+
+    // group characters by the next state
+    map<int, vector<int>> next_states;
+    for (int c = 0; c < Dfa::kAlphabetSize; ++c) {
+      auto next = dfa.GetNextState(state, c);
+      if (next != Dfa::kDeadState) {
+        next_states[next].push_back(c);
+      }
+    }
+    for (auto &[next, chars]:next_states) {
+      for (auto c:chars) {
+        os << "    case " << c << ":\n";
+      }
+      os << "      goto state_" << next << ";\n";
+    }
+    os << "    default:\n"
+          "      goto done;\n"
+          "  }\n";
+  }
+
+  os << "\ndone:\n";
+  os << "  if (last_accept == " << Dfa::kNotAccept << ") {\n";
+  os << "    return std::nullopt;\n"
+        "  }\n";
+  os << "  auto type = static_cast<TokenType>(last_accept);\n";
+  for (auto host:dfa.GetKeywords().GetHosts()) {
+    os << "  if (last_accept == " << host << ") {\n"
+          "    type = KeywordTable::Lookup(kKeywordSlots, kKeywordMask, "
+          "kKeywordSeed,\n"
+          "                                kKeywordSpellings, type, begin, "
+          "last_end);\n"
+          "  }\n";
+  }
+  os << "  return AcceptState{type, last_end};\n"
+        "}\n"
+        "}\n";
+}
+
+void EmitKeywords(const KeywordTable &keywords, ostream &os) {
+  if (keywords.Empty()) {
+    return;
+  }
+
+  os << "namespace {\n";
+  os << "const std::uint32_t kKeywordMask = " << keywords.GetMask() << "u;\n";
+  os << "const std::uint32_t kKeywordSeed = " << keywords.GetSeed() << "u;\n";
+  // spellings are made up of characters of literal regexes, which never
+  // need escaping except for '\\' and '"'
+  os << "const char kKeywordSpellings[] = \"";
+  for (auto c:keywords.GetSpellings()) {
+    if (c == '\\' || c == '"') {
+      os << '\\';
+    }
+    os << c;
+  }
+  os << "\";\n";
+  os << "const KeywordTable::Slot kKeywordSlots[] = {\n";
+  for (auto &slot:keywords.GetSlots()) {
+    os << "        {" << slot.offset << ", " << slot.length << ", "
+       << slot.type << ", " << slot.host << "},\n";
+  }
+  os << "};\n"
+        "}\n\n";
+}
+
+void EmitAccelerations(const Dfa &dfa, ostream &os) {
+  os << "namespace {\n";
+  for (int state = 0; state < dfa.StateCount(); ++state) {
+    auto &ranges = dfa.GetAcceleration(state);
+    if (ranges.count == 0) {
+      continue;
+    }
+
+    os << "constexpr auto kAcceleration" << state
+       << " = ByteRanges::FromRanges({";
+    for (int i = 0; i < ranges.count; ++i) {
+      os << (i == 0 ? "{" : ", {") << static_cast<int>(ranges.lows[i]) << ", "
+         << static_cast<int>(ranges.highs[i]) << "}";
+    }
+    os << "});\n";
+  }
+  os << "}\n\n";
+}
@@ -0,0 +1,67 @@
+//
+// Created by dxy on 2020/12/7.
+//
+
+#include "lex/mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace CCompiler;
+using namespace std;
+
+MappedFile::MappedFile(MappedFile &&file) noexcept
+        : data_(file.data_),
+          size_(file.size_) {
+  file.data_ = nullptr;
+  file.size_ = 0;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&file) noexcept {
+  if (this != &file) {
+    this->~MappedFile();
+    data_ = file.data_;
+    size_ = file.size_;
+    file.data_ = nullptr;
+    file.size_ = 0;
+  }
+  return *this;
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    munmap(const_cast<char *>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
+unique_ptr<MappedFile> MappedFile::Open(const string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return nullptr;
+  }
+
+  struct stat file_stat{};
+  if (fstat(fd, &file_stat) == -1) {
+    close(fd);
+    return nullptr;
+  }
+
+  auto file = make_unique<MappedFile>();
+  if (file_stat.st_size > 0) {
+    auto data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      return nullptr;
+    }
+    file->data_ = static_cast<const char *>(data);
+    file->size_ = file_stat.st_size;
+  }
+  // the mapping stays valid after closing the descriptor
+  close(fd);
+
+  return file;
+}
@@ -4,18 +4,18 @@
 
 #include "lex/nfa.h"
 
+#include <bit>
 #include <cctype>
+#include <charconv>
 #include <climits>
 #include <sstream>
-#include <stack>
+#include <tuple>
 
 #include "lex/token.h"
 
 using namespace CCompiler;
 using namespace std;
 
-int Nfa::i_ = 0;
-
 /**
  * It determines which RegexPart should be chosen according to regex's a few
  * characters from its head.
@@ -23,9 +23,13 @@ int Nfa::i_ = 0;
  * @param regex
  * @return
  */
-RegexPart GetRegexType(const string &regex);
+RegexPart GetRegexType(string_view regex);
 
-set<string> GetDelim(const string &regex);
+/**
+ * @param regex
+ * @param delim tokens of characters in regex are added to it
+ */
+void GetDelim(string_view regex, set<string_view> &delim);
 
 /**
  * It finds one token a time and sets 'begin' to the head of the next token.
@@ -37,7 +41,7 @@ set<string> GetDelim(const string &regex);
  * @return A valid token. If it finds an invalid token or reaching to the end
  * of the regex, it returns "".
  */
-std::string NextTokenInRegex(StrConstIt &begin, StrConstIt &end);
+string_view NextTokenInRegex(StrConstIt &begin, StrConstIt end);
 
 /**
      * @param begin
@@ -47,6 +51,14 @@ std::string NextTokenInRegex(StrConstIt &begin, StrConstIt &end);
      */
 StrConstIt SkipEscapeCharacters(StrConstIt begin, StrConstIt end);
 
+/**
+ * Add the bytes matched by a special pattern to bytes.
+ *
+ * @param characters a special pattern, see SpecialPatternNfa
+ * @param bytes
+ */
+void AddSpecialPatternBytes(string_view characters, ByteSet &bytes);
+
 /**
  * Add a character range [begin, end) to char_ranges.
  *
@@ -63,44 +75,39 @@ void AddCharRange(
  */
 void AddCharRange(set<unsigned int> &char_ranges, unsigned int begin);
 
-bool
-PushAnd(stack<RegexAstNodePtr> &op_stack, stack<RegexAstNodePtr> &rpn_stack);
-
-bool
-PushOr(stack<RegexAstNodePtr> &op_stack, stack<RegexAstNodePtr> &rpn_stack);
 
-bool PushQuantifier(stack<RegexAstNodePtr> &op_stack,
-                    stack<RegexAstNodePtr> &rpn_stack, const string &regex);
+AcptStatePtr Nfa::NextMatch(StrConstIt begin, StrConstIt end) const {
+  if (begin_state_ == -1) {
+    return nullptr;
+  }
 
-AcptStatePtr Nfa::NextMatch(StrConstIt begin, StrConstIt end) {
-  vector<ReachableStatesMap> state_vec = StateRoute(begin, end);
-  auto it = state_vec.cbegin();
-  State state = *state_vec[0].find({begin_state_, begin});
+  StateBits cur_states((state_count_ + 63) / 64);
+  StateBits next_states(cur_states.size());
+  AddState(begin_state_, cur_states);
 
   // find the longest match
-  while (it != state_vec.cend()) {
-    for (const auto &cur_state:*it) {
-      if (accept_states_.contains(cur_state.first)) {
-        if (cur_state.second > state.second) {
-          state = cur_state;
-        } else if (cur_state.second == state.second) {
-          if (accept_states_.contains(state.first)) {
-            if (accept_states_[cur_state.first] < accept_states_[state.first]) {
-              state = cur_state;
-            }
-          } else {
-            state = cur_state;
-          }
-        }
-      }
+  auto last_type = AcceptType(cur_states);
+  auto last_end = begin;
+  for (auto it = begin; it != end; ++it) {
+    fill(next_states.begin(), next_states.end(), 0);
+    if (!NextStates(cur_states, it, next_states)) {
+      break;
+    }
+    cur_states.swap(next_states);
+
+    auto type = AcceptType(cur_states);
+    if (type != kNotAccept) {
+      last_type = type;
+      last_end = it + 1;
     }
-    it++;
   }
 
-  if (state.first == begin_state_) {
+  if (last_type == kNotAccept) {
     return nullptr;
   } else {
-    return make_unique<AcceptState>(accept_states_[state.first], state.second);
+    return make_unique<AcceptState>(
+            keywords_.Classify(static_cast<TokenType>(last_type), begin,
+                               last_end), last_end);
   }
 }
 
@@ -108,138 +115,211 @@ StrConstIt SkipEscapeCharacters(StrConstIt begin, StrConstIt end) {
   auto cur_it = begin;
 
   if (cur_it != end && *cur_it == '\\') {
-    cur_it++;
+    if (++cur_it == end) {
+      return end;  // a trailing '\\'
+    }
 
+    ptrdiff_t length;
     switch (*cur_it) {
       case 'u':
-        return cur_it + 5;
+        length = 5;
+        break;
       case 'c':
-        return cur_it + 2;
+        length = 2;
+        break;
       case 'x':
-        return cur_it + 3;
-      case '0':
-        return begin;
+        length = 3;
+        break;
       default:
-        return cur_it + 1;
+        length = 1;
+        break;
     }
+    // an escape cut short by the end of the regex ends there
+    return cur_it + min(length, end - cur_it);
   }
 
   return begin;  // not escape characters
 }
 
-vector<ReachableStatesMap> Nfa::StateRoute(StrConstIt begin, StrConstIt end) {
-  vector<ReachableStatesMap> state_vec;
-  ReachableStatesMap cur_states;
-
-  // Use states that can be accessed through empty edges from begin_state_
-  // and begin_state_ itself as an initial driver.
-  State begin_state = {begin_state_, begin};
-  if (GetStateType(begin_state_) == StateType::kCommon) {
-    cur_states.merge(NextState(begin_state));
+void Nfa::AddState(int state, StateBits &states) const {
+  states[state / 64] |= uint64_t{1} << (state % 64);
+  if (GetStateType(state) == StateType::kCommon) {
+    for (auto next:GetEmptyClosure(state)) {
+      states[next / 64] |= uint64_t{1} << (next % 64);
+    }
   }
-  cur_states.insert(begin_state);
-  state_vec.push_back(cur_states);
+}
+
+bool Nfa::NextStates(const StateBits &cur_states, StrConstIt c,
+                     StateBits &next_states) const {
+  auto char_location = GetCharLocation(*c);
+  bool active = false;
+
+  for (size_t i = 0; i < cur_states.size(); ++i) {
+    for (auto bits = cur_states[i]; bits != 0; bits &= bits - 1) {
+      auto state = static_cast<int>(i * 64 + countr_zero(bits));
+      switch (GetStateType(state)) {
+        case StateType::kSpecialPattern:
+        case StateType::kRange:
+          if (!FunctionalMatch(state, *c)) {
+            continue;
+          }
+          break;
+        case StateType::kCommon:
+          // range 0 is reserved for empty edges
+          if (char_location != kEmptyEdge) {
+            for (auto next:GetNextStates(state, char_location)) {
+              AddState(next, next_states);
+              active = true;
+            }
+          }
+          continue;
+      }
 
-  // find all reachable states from current states
-  while (!state_vec[state_vec.size() - 1].empty()) {
-    cur_states.clear();
-    for (const auto &last_state:state_vec[state_vec.size() - 1]) {
-      cur_states.merge(NextState(last_state, end));
+      // the closure of a functional state is already closed
+      for (auto next:GetEmptyClosure(state)) {
+        next_states[next / 64] |= uint64_t{1} << (next % 64);
+        active = true;
+      }
     }
-    state_vec.push_back(cur_states);
   }
-  // remove the last empty vector
-  state_vec.pop_back();
 
-  return state_vec;
+  return active;
 }
 
-ReachableStatesMap Nfa::NextState(const State &cur_state, StrConstIt str_end) {
-  ReachableStatesMap next_states;
-  auto begin = cur_state.second;
+int Nfa::AcceptType(const StateBits &states) const {
+  int type = kNotAccept;
 
-  switch (GetStateType(cur_state.first)) {
-    case StateType::kSpecialPattern:
-      begin = special_pattern_states_.find(cur_state.first)->second.NextMatch(
-              cur_state, str_end);
-      if (begin != cur_state.second) {
-        next_states.insert({cur_state.first, begin});
-      }
-      break;
-    case StateType::kRange:
-      begin = range_states_.find(cur_state.first)->second.NextMatch(
-              cur_state, str_end);
-      if (begin != cur_state.second) {
-        next_states.insert({cur_state.first, begin});
-      }
-      break;
-    case StateType::kCommon:
-      // add states that can be reached through *cur_it
-      if (begin < str_end) {
-        for (auto state:
-                exchange_map_[cur_state.first][GetCharLocation(*begin)]) {
-          next_states.insert({state, begin + 1});
-        }
+  for (size_t i = 0; i < states.size(); ++i) {
+    for (auto bits = states[i] & accept_bits_[i]; bits != 0;
+         bits &= bits - 1) {
+      auto cur_type = accept_types_[i * 64 + countr_zero(bits)];
+      if (type == kNotAccept || cur_type < type) {
+        type = cur_type;
       }
-      break;
+    }
   }
 
-  ReachableStatesMap next_states_from_empty;
-  for (const auto &state:next_states) {
-    next_states_from_empty.merge(NextState(state));
-  }
-  next_states.erase({cur_state.first, begin});
-  next_states.merge(next_states_from_empty);
+  return type;
+}
 
-  return next_states;
+span<const int> Nfa::GetNextStates(int state, int range) const {
+  auto first = edge_ranges_.cbegin() + edge_offsets_[state];
+  auto last = edge_ranges_.cbegin() + edge_offsets_[state + 1];
+  auto [lower, upper] = equal_range(first, last, range);
+
+  return {edge_targets_.data() + (lower - edge_ranges_.cbegin()),
+          edge_targets_.data() + (upper - edge_ranges_.cbegin())};
 }
 
-ReachableStatesMap Nfa::NextState(const State &cur_state) {
-  vector<int> common_states;
-  set<int> func_states;
-
-  common_states.push_back(cur_state.first);
-  int i = -1;
-  while (++i != common_states.size()) {
-    for (auto state:exchange_map_[common_states[i]][kEmptyEdge]) {
-      if (GetStateType(state) == StateType::kCommon) {
-        if (find(common_states.cbegin(), common_states.cend(), state) ==
-            common_states.cend()) {
-          common_states.push_back(state);
-        }
-      } else {
-        func_states.insert(state);
-      }
-    }
+const ByteSet &Nfa::GetFunctionalBytes(int state) const {
+  if (GetStateType(state) == StateType::kSpecialPattern) {
+    return special_patterns_[functionals_[state]].GetBytes();
   }
-  // erase cur_state
-  common_states.erase(common_states.cbegin());
+  return ranges_[functionals_[state]].GetBytes();
+}
 
-  ReachableStatesMap next_states_map;
-  for (auto state:common_states) {
-    next_states_map.insert({state, cur_state.second});
+void Nfa::Compile() {
+  CharClassesInit();
+
+  // NfaBuilder numbers states in [0, state_count_)
+  state_types_.assign(state_count_, StateType::kCommon);
+  functionals_.assign(state_count_, -1);
+  for (auto &[state, nfa]:special_pattern_states_) {
+    state_types_[state] = StateType::kSpecialPattern;
+    functionals_[state] = special_patterns_.size();
+    special_patterns_.push_back(std::move(nfa));
+  }
+  for (auto &[state, nfa]:range_states_) {
+    state_types_[state] = StateType::kRange;
+    functionals_[state] = ranges_.size();
+    ranges_.push_back(std::move(nfa));
+  }
+
+  accept_types_.assign(state_count_, kNotAccept);
+  accept_bits_.assign((state_count_ + 63) / 64, 0);
+  for (auto &[state, type]:accept_states_) {
+    accept_types_[state] = static_cast<int>(type);
+    accept_bits_[state / 64] |= uint64_t{1} << (state % 64);
+  }
+
+  auto edge_less = [](const Edge &lhs, const Edge &rhs) {
+      return tie(lhs.from, lhs.range, lhs.to) <
+             tie(rhs.from, rhs.range, rhs.to);
+  };
+  auto edge_equal = [](const Edge &lhs, const Edge &rhs) {
+      return tie(lhs.from, lhs.range, lhs.to) ==
+             tie(rhs.from, rhs.range, rhs.to);
+  };
+  sort(edges_.begin(), edges_.end(), edge_less);
+  edges_.erase(unique(edges_.begin(), edges_.end(), edge_equal),
+               edges_.end());
+
+  // empty edges are only used to compute closures
+  vector<int> empty_offsets(state_count_ + 1, 0);
+  vector<int> empty_targets;
+  edge_offsets_.assign(state_count_ + 1, 0);
+  for (auto &edge:edges_) {
+    if (edge.range == kEmptyEdge) {
+      empty_offsets[edge.from + 1]++;
+      empty_targets.push_back(edge.to);
+    } else {
+      edge_offsets_[edge.from + 1]++;
+      edge_ranges_.push_back(edge.range);
+      edge_targets_.push_back(edge.to);
+    }
   }
-  for (auto state:func_states) {
-    next_states_map.insert({state, cur_state.second});
+  for (int state = 0; state < state_count_; ++state) {
+    empty_offsets[state + 1] += empty_offsets[state];
+    edge_offsets_[state + 1] += edge_offsets_[state];
   }
 
-  return next_states_map;
-}
-
-Nfa::StateType Nfa::GetStateType(int state) {
-  if (special_pattern_states_.contains(state)) {
-    return StateType::kSpecialPattern;
-  }
-  if (range_states_.contains(state)) {
-    return StateType::kRange;
+  // Common states are expanded and functional states are only recorded.
+  // The state itself is excluded unless it is a functional state reached
+  // again.
+  closure_offsets_.assign(1, 0);
+  vector<int> mark(state_count_, -1);
+  vector<int> common_states;
+  vector<int> closure;
+  for (int state = 0; state < state_count_; ++state) {
+    common_states.assign(1, state);
+    mark[state] = state;
+    closure.clear();
+    bool self_reached = false;
+    for (size_t i = 0; i < common_states.size(); ++i) {
+      for (int j = empty_offsets[common_states[i]];
+           j < empty_offsets[common_states[i] + 1]; ++j) {
+        auto next = empty_targets[j];
+        if (next == state) {
+          self_reached = GetStateType(state) != StateType::kCommon;
+        } else if (mark[next] != state) {
+          mark[next] = state;
+          closure.push_back(next);
+          if (GetStateType(next) == StateType::kCommon) {
+            common_states.push_back(next);
+          }
+        }
+      }
+    }
+    if (self_reached) {
+      closure.push_back(state);
+    }
+    sort(closure.begin(), closure.end());
+    closures_.insert(closures_.end(), closure.cbegin(), closure.cend());
+    closure_offsets_.push_back(closures_.size());
   }
-  return StateType::kCommon;
+
+  edges_ = vector<Edge>();
+  special_pattern_states_ = vector<pair<int, SpecialPatternNfa>>();
+  range_states_ = vector<pair<int, RangeNfa>>();
+  edge_ranges_.shrink_to_fit();
+  edge_targets_.shrink_to_fit();
+  closures_.shrink_to_fit();
 }
 
-set<string> GetDelim(const string &regex) {
+void GetDelim(string_view regex, set<string_view> &delim) {
   auto begin = regex.cbegin(), end = regex.cend();
-  set<string> delim;
-  string token;
+  string_view token;
 
   while (!(token = NextTokenInRegex(begin, end)).empty()) {
     switch (GetRegexType(token)) {
@@ -247,30 +327,15 @@ set<string> GetDelim(const string &regex) {
         delim.insert(token);
         break;
       case RegexPart::kPassiveGroup:
-        delim.merge(GetDelim(string{token.cbegin() + 3, token.cend() - 1}));
+        GetDelim(token.substr(3, token.size() - 4), delim);
         break;
       default:
         break;
     }
   }
-
-  return delim;
-}
-
-Nfa &Nfa::operator+=(Nfa &nfa) {
-  if (char_ranges_.empty()) {
-    char_ranges_.assign(nfa.char_ranges_.cbegin(), nfa.char_ranges_.cend());
-  }
-  for (auto &pair:nfa.exchange_map_) {
-    exchange_map_[pair.first] = std::move(pair.second);
-  }
-  special_pattern_states_.merge(nfa.special_pattern_states_);
-  range_states_.merge(nfa.range_states_);
-
-  return *this;
 }
 
-void Nfa::CharRangesInit(const set<string> &delim) {
+void Nfa::CharRangesInit(const set<string_view> &delim) {
   set<unsigned int> char_ranges;
 
   // determine encode range
@@ -290,6 +355,17 @@ void Nfa::CharRangesInit(const set<string> &delim) {
   char_ranges_.assign(char_ranges.begin(), char_ranges.end());
 }
 
+void Nfa::CharClassesInit() {
+  size_t location = 0;
+  for (unsigned int c = 0; c < char_classes_.size(); ++c) {
+    while (location + 1 < char_ranges_.size() &&
+           char_ranges_[location + 1] <= c) {
+      location++;
+    }
+    char_classes_[c] = static_cast<int>(location);
+  }
+}
+
 void AddCharRange(
         set<unsigned int> &char_ranges, unsigned int begin, unsigned int end) {
   char_ranges.insert(begin);
@@ -300,98 +376,96 @@ void AddCharRange(set<unsigned int> &char_ranges, unsigned int begin) {
   AddCharRange(char_ranges, begin, begin + 1);
 }
 
-int Nfa::GetCharLocation(int c) {
-  for (int i = 0; i < char_ranges_.size(); ++i) {
-    if (char_ranges_[i] > c) {
-      return i - 1;
-    }
-  }
-  return -1;
-}
-
 /**
  * It works like add | between regexes. But it only adds empty edges from
  * the new begin state to all nfas' begin states. All accept states are
  * reserved.
  */
-Nfa::Nfa(const map<string, TokenType> &regex_rules) {
+Nfa::Nfa(const map<string, TokenType> &rules, bool extract_keywords) {
+  auto regex_rules = rules;
+  if (extract_keywords) {
+    keywords_ = KeywordTable::Extract(regex_rules);
+  }
+
   // initialize char_ranges_
   if (!regex_rules.empty()) {
-    string regex;
+    set<string_view> delim;
     for (auto &regex_rule:regex_rules) {
-      regex += regex_rule.first + "|";
+      GetDelim(regex_rule.first, delim);
     }
-    regex.erase(regex.cend() - 1);
-    auto delim = GetDelim(regex);
     CharRangesInit(delim);
 
-    NewState();  // begin state
-    begin_state_ = i_;
+    NfaBuilder builder(*this);
+    begin_state_ = builder.NewState();
 
     for (auto &regex_rule:regex_rules) {
-      Nfa nfa(regex_rule.first, regex_rule.second, char_ranges_);
-      *this += nfa;
-      // copy the only accept state in nfa
-      this->accept_states_.merge(nfa.accept_states_);
-      // add an empty edge to nfa's begin state
-      exchange_map_[begin_state_][0].insert(nfa.begin_state_);
+      auto rule = builder.MakeRuleNfa(regex_rule.first, regex_rule.second);
+      if (rule.Empty()) {  // invalid regex
+        continue;
+      }
+      // add an empty edge to the rule's begin state
+      builder.AddEdge(begin_state_, kEmptyEdge, rule.GetBeginState());
     }
   }
+  Compile();
 }
 
 Nfa::Nfa(const string &regex, TokenType type,
-         const vector<unsigned int> &char_ranges) {
-  auto ast_head = ParseRegex(regex);
-  if (ast_head) {
-    *this = Nfa(ast_head, char_ranges);
-
-    // add a new state as the accept state to prevent that accept state is a
-    // functional state
-    NewState();
-    exchange_map_[accept_states_.cbegin()->first][kEmptyEdge].insert(i_);
-    accept_states_.clear();
-    accept_states_[i_] = type;
-  }
+         const vector<unsigned int> &char_ranges)
+        : char_ranges_(char_ranges) {
+  NfaBuilder builder(*this);
+  begin_state_ = builder.MakeRuleNfa(regex, type).GetBeginState();
+  Compile();
 }
 
-RegexAstNodePtr Nfa::ParseRegex(const string &regex) {
-  stack<RegexAstNodePtr> op_stack;
-  stack<RegexAstNodePtr> rpn_stack;
-  string lex;
+int RegexAst::Parse(string_view regex) {
+  // parse on top of the stacks of the enclosing regex
+  auto op_base = op_base_, rpn_base = rpn_base_;
+  op_base_ = op_stack_.size();
+  rpn_base_ = rpn_stack_.size();
+  auto restore = [&](int head) {
+      op_stack_.resize(op_base_);
+      rpn_stack_.resize(rpn_base_);
+      op_base_ = op_base;
+      rpn_base_ = rpn_base;
+      return head;
+  };
+
   auto cur_it = regex.cbegin(), end = regex.cend();
   bool or_flag = true;  // whether the last lex is |
-  RegexAstNodePtr son;
+  string_view lex;
 
   while (!(lex = NextTokenInRegex(cur_it, end)).empty()) {
     switch (GetRegexType(lex)) {
       case RegexPart::kAlternative:
         or_flag = true;
-        if (!PushOr(op_stack, rpn_stack)) {
-          return nullptr;
+        if (!PushOr()) {
+          return restore(kNoNode);
         }
         break;
       case RegexPart::kQuantifier:
-        if (!PushQuantifier(op_stack, rpn_stack, lex)) {
-          return nullptr;
+        if (!PushQuantifier(lex)) {
+          return restore(kNoNode);
         }
         break;
       case RegexPart::kChar:
         // We need to explicitly add & before a character when the last lex
         // isn't |.
-        if (!or_flag && !PushAnd(op_stack, rpn_stack)) {
-          return nullptr;
+        if (!or_flag && !PushAnd()) {
+          return restore(kNoNode);
         }
-        rpn_stack.push(make_unique<RegexAstNode>(RegexPart::kChar, lex));
+        rpn_stack_.push_back(AddNode(RegexPart::kChar, lex));
         or_flag = false;
         break;
-      case RegexPart::kPassiveGroup:
-        if (!or_flag && !PushAnd(op_stack, rpn_stack)) {
-          return nullptr;
+      case RegexPart::kPassiveGroup: {
+        if (!or_flag && !PushAnd()) {
+          return restore(kNoNode);
         }
-        son = ParseRegex(string{lex.cbegin() + 3, lex.cend() - 1});
-        rpn_stack.push(std::move(son));
+        auto son = Parse(lex.substr(3, lex.size() - 4));
+        rpn_stack_.push_back(son);
         or_flag = false;
         break;
+      }
       case RegexPart::kAnd:
         // kAnd should not exist here, so it is seen as an error.
       case RegexPart::kError:  // skip the error token
@@ -399,19 +473,18 @@ RegexAstNodePtr Nfa::ParseRegex(const string &regex) {
     }
   }
 
-  // empty 'op_stack'
-  if (!PushOr(op_stack, rpn_stack) || rpn_stack.size() != 1) {
-    return nullptr;
+  // empty 'op_stack_'
+  if (!PushOr() || rpn_stack_.size() - rpn_base_ != 1) {
+    return restore(kNoNode);
   }
-  return std::move(rpn_stack.top());
+  return restore(rpn_stack_.back());
 }
 
-string NextTokenInRegex(StrConstIt &begin, StrConstIt &end) {
+string_view NextTokenInRegex(StrConstIt &begin, StrConstIt end) {
   if (begin != end) {
     auto cur_begin = begin;
-    map<char, char> pair_characters{
-            {'}', '{'},
-            {']', '['}
+    auto token = [&]() {
+        return string_view(cur_begin, begin);
     };
 
     // count ( to ensure correct matches of nested ()
@@ -421,7 +494,8 @@ string NextTokenInRegex(StrConstIt &begin, StrConstIt &end) {
       case '.':
       case '^':
       case '$':
-        return string(1, *begin++);
+        begin++;
+        return token();
 
         // repeat(greedy and non-greedy)
       case '*':
@@ -429,14 +503,14 @@ string NextTokenInRegex(StrConstIt &begin, StrConstIt &end) {
       case '?':
         if (++begin != end) {
           if (*begin == '?') {
-            return string(cur_begin, ++begin);
+            begin++;
           }
         }
-        return string(cur_begin, begin);
+        return token();
 
       case '\\':  // escape characters
         begin = SkipEscapeCharacters(begin, end);
-        return string(cur_begin, begin);
+        return token();
 
         // See [...] {...} <...> as a lex. Although it cannot be nested,
         // nested error is detected by caller and now we only find the first
@@ -446,11 +520,12 @@ string NextTokenInRegex(StrConstIt &begin, StrConstIt &end) {
         while (++begin != end) {
           // skip \] \}
           begin = SkipEscapeCharacters(begin, end);
-          if (begin != end) {
-            auto it = pair_characters.find(*begin);
-            if (it != pair_characters.end() && it->second == *cur_begin) {
-              return string(cur_begin, ++begin);
-            }
+          if (begin == end) {
+            break;
+          }
+          if (*begin == (*cur_begin == '[' ? ']' : '}')) {
+            begin++;
+            return token();
           }
         }
         return "";  // lack of ] } >
@@ -460,19 +535,21 @@ string NextTokenInRegex(StrConstIt &begin, StrConstIt &end) {
       case '(':
         while (parentheses != 0 && ++begin != end) {
           begin = SkipEscapeCharacters(begin, end);
-          if (begin != end) {
-            switch (*begin) {
-              case '(':
-                parentheses++;
-                break;
-              case ')':
-                parentheses--;
-                break;
-            }
+          if (begin == end) {
+            break;
+          }
+          switch (*begin) {
+            case '(':
+              parentheses++;
+              break;
+            case ')':
+              parentheses--;
+              break;
           }
         }
         if (parentheses == 0) {
-          return string(cur_begin, ++begin);
+          begin++;
+          return token();
         }
         return "";  // lack of )
 
@@ -482,13 +559,14 @@ string NextTokenInRegex(StrConstIt &begin, StrConstIt &end) {
       case ')':
         return "";
       default:
-        return string(1, *begin++);
+        begin++;
+        return token();
     }
   }
   return "";  // All characters in regex have been scanned.
 }
 
-RegexPart GetRegexType(const string &regex) {
+RegexPart GetRegexType(string_view regex) {
   switch (regex[0]) {
     // & is implicit so we don't have to think about it.
     case '|':
@@ -514,239 +592,210 @@ RegexPart GetRegexType(const string &regex) {
   }
 }
 
-bool
-PushAnd(stack<RegexAstNodePtr> &op_stack, stack<RegexAstNodePtr> &rpn_stack) {
-  while (!op_stack.empty() &&
-         op_stack.top()->GetType() != RegexPart::kAlternative) {
-    if (op_stack.top()->GetType() == RegexPart::kAnd) {
-      if (rpn_stack.size() < 2) {
-        return false;
-      }
-      op_stack.top()->SetRightSon(std::move(rpn_stack.top()));
-      rpn_stack.pop();
-      op_stack.top()->SetLeftSon(std::move(rpn_stack.top()));
-      rpn_stack.pop();
-    } else {
-      if (rpn_stack.empty()) {
-        return false;
-      }
-      op_stack.top()->SetLeftSon(std::move(rpn_stack.top()));
-      rpn_stack.pop();
-    }
-    rpn_stack.push(std::move(op_stack.top()));
-    op_stack.pop();
+bool RegexAst::PopOperator(int node, int sons) {
+  if (rpn_stack_.size() - rpn_base_ < static_cast<size_t>(sons)) {
+    return false;
   }
-  op_stack.push(make_unique<RegexAstNode>(RegexPart::kAnd, ""));
-
+  if (sons == 2) {
+    nodes_[node].right_son = rpn_stack_.back();
+    rpn_stack_.pop_back();
+  }
+  nodes_[node].left_son = rpn_stack_.back();
+  rpn_stack_.back() = node;
   return true;
 }
 
-bool
-PushOr(stack<RegexAstNodePtr> &op_stack, stack<RegexAstNodePtr> &rpn_stack) {
-  while (!op_stack.empty()) {
-    if (op_stack.top()->GetType() == RegexPart::kAnd ||
-        op_stack.top()->GetType() == RegexPart::kAlternative) {
-      if (rpn_stack.size() < 2) {
-        return false;
-      }
-      op_stack.top()->SetRightSon(std::move(rpn_stack.top()));
-      rpn_stack.pop();
-      op_stack.top()->SetLeftSon(std::move(rpn_stack.top()));
-      rpn_stack.pop();
-    } else {
-      if (rpn_stack.empty()) {
-        return false;
-      }
-      op_stack.top()->SetLeftSon(std::move(rpn_stack.top()));
-      rpn_stack.pop();
+bool RegexAst::PushAnd() {
+  while (op_stack_.size() > op_base_ &&
+         nodes_[op_stack_.back()].regex_type != RegexPart::kAlternative) {
+    auto node = op_stack_.back();
+    op_stack_.pop_back();
+    if (!PopOperator(node,
+                     nodes_[node].regex_type == RegexPart::kAnd ? 2 : 1)) {
+      return false;
     }
-    rpn_stack.push(std::move(op_stack.top()));
-    op_stack.pop();
   }
-  op_stack.push(make_unique<RegexAstNode>(RegexPart::kAlternative, ""));
+  op_stack_.push_back(AddNode(RegexPart::kAnd, ""));
 
   return true;
 }
 
-bool PushQuantifier(stack<RegexAstNodePtr> &op_stack,
-                    stack<RegexAstNodePtr> &rpn_stack, const string &regex) {
-  while (!op_stack.empty() &&
-         op_stack.top()->GetType() != RegexPart::kAlternative &&
-         op_stack.top()->GetType() != RegexPart::kAnd) {
-    if (rpn_stack.empty()) {
+bool RegexAst::PushOr() {
+  while (op_stack_.size() > op_base_) {
+    auto node = op_stack_.back();
+    op_stack_.pop_back();
+    auto type = nodes_[node].regex_type;
+    if (!PopOperator(node, type == RegexPart::kAnd ||
+                           type == RegexPart::kAlternative ? 2 : 1)) {
       return false;
     }
-    op_stack.top()->SetLeftSon(std::move(rpn_stack.top()));
-    rpn_stack.pop();
-    rpn_stack.push(std::move(op_stack.top()));
-    op_stack.pop();
   }
-  op_stack.push(make_unique<RegexAstNode>(RegexPart::kQuantifier, regex));
+  op_stack_.push_back(AddNode(RegexPart::kAlternative, ""));
 
   return true;
 }
 
-Nfa::Nfa(RegexAstNodePtr &ast_head, const vector<unsigned int> &char_ranges) {
-  if (ast_head) {
-    switch (ast_head->regex_type_) {
-      case RegexPart::kChar:
-        *this = NfaFactory::MakeCharacterNfa(ast_head->regex_, char_ranges);
-        break;
-      case RegexPart::kAlternative:
-        *this = NfaFactory::MakeAlternativeNfa(
-                Nfa(ast_head->left_son_, char_ranges),
-                Nfa(ast_head->right_son_, char_ranges));
-        break;
-      case RegexPart::kAnd:
-        *this = NfaFactory::MakeAndNfa(
-                Nfa(ast_head->left_son_, char_ranges),
-                Nfa(ast_head->right_son_, char_ranges));
-        break;
-      case RegexPart::kQuantifier:
-        *this = NfaFactory::MakeQuantifierNfa(
-                ast_head->regex_, ast_head->left_son_, char_ranges);
-        break;
-      case RegexPart::kPassiveGroup:
-        // It is handled in ParseRegex(), so it shouldn't appear here.
-      case RegexPart::kError:
-        break;
+bool RegexAst::PushQuantifier(string_view regex) {
+  while (op_stack_.size() > op_base_ &&
+         nodes_[op_stack_.back()].regex_type != RegexPart::kAlternative &&
+         nodes_[op_stack_.back()].regex_type != RegexPart::kAnd) {
+    auto node = op_stack_.back();
+    op_stack_.pop_back();
+    if (!PopOperator(node, 1)) {
+      return false;
     }
   }
+  op_stack_.push_back(AddNode(RegexPart::kQuantifier, regex));
+
+  return true;
 }
 
-void Nfa::NewState() {
-  vector<set<int>> edges_vec;
-  edges_vec.reserve(char_ranges_.size());
-  for (int i = 0; i < char_ranges_.size(); ++i) {
-    edges_vec.emplace_back(set<int>());
+NfaBuilder::Fragment NfaBuilder::MakeNfa(int ast_head) {
+  if (ast_head == RegexAst::kNoNode) {
+    return {};
+  }
+
+  auto &node = ast_.GetNode(ast_head);
+  switch (node.regex_type) {
+    case RegexPart::kChar:
+      return MakeCharacterNfa(node.regex);
+    case RegexPart::kAlternative:
+      return MakeAlternativeNfa(MakeNfa(node.left_son),
+                                MakeNfa(node.right_son));
+    case RegexPart::kAnd:
+      return MakeAndNfa(MakeNfa(node.left_son), MakeNfa(node.right_son));
+    case RegexPart::kQuantifier:
+      return MakeQuantifierNfa(node.regex, node.left_son);
+    case RegexPart::kPassiveGroup:
+      // It is handled in RegexAst::Parse(), so it shouldn't appear here.
+    case RegexPart::kError:
+      break;
   }
-  exchange_map_.insert({++i_, edges_vec});
+  return {};
 }
 
-Nfa NfaFactory::MakeCharacterNfa(
-        const string &characters, const vector<unsigned int> &char_ranges) {
-  Nfa nfa;
-  nfa.char_ranges_.assign(char_ranges.cbegin(), char_ranges.cend());
+NfaBuilder::Fragment NfaBuilder::MakeRuleNfa(const string &regex,
+                                             TokenType type) {
+  // the nodes of the last rule are reused
+  ast_.Clear();
+  auto nfa = MakeNfa(ast_.Parse(regex));
+  if (nfa.Empty()) {
+    return {};
+  }
 
-  nfa.NewState();
-  nfa.begin_state_ = Nfa::i_;
+  // add a new state as the accept state to prevent that accept state is a
+  // functional state
+  auto accept_state = NewState();
+  AddEdge(nfa.GetAcceptState(), Nfa::kEmptyEdge, accept_state);
+  nfa_.accept_states_[accept_state] = type;
 
-  if (characters.size() == 1) {
-    if (characters == ".") {
-      nfa.accept_states_[nfa.begin_state_] = TokenType::kEmpty;
-      nfa.special_pattern_states_.insert(
-              {nfa.begin_state_, SpecialPatternNfa(characters)});
-    } else {  // single character
-      nfa.NewState();
-      nfa.accept_states_[Nfa::i_] = TokenType::kEmpty;
-      nfa.exchange_map_[nfa.begin_state_][nfa.GetCharLocation(
-              characters[0])].insert(nfa.accept_states_.cbegin()->first);
-    }
-  } else if (characters[0] == '[') {  // [...]
-    nfa.accept_states_[nfa.begin_state_] = TokenType::kEmpty;
-    nfa.range_states_.insert({nfa.begin_state_, RangeNfa(characters)});
-  } else {  // special pattern characters
-    nfa.accept_states_[nfa.begin_state_] = TokenType::kEmpty;
-    nfa.special_pattern_states_.insert(
-            {nfa.begin_state_, SpecialPatternNfa(characters)});
-  }
+  return {nfa.GetBeginState(), accept_state};
+}
 
-  return nfa;
+NfaBuilder::Fragment NfaBuilder::MakeCharacterNfa(string_view characters) {
+  auto begin_state = NewState();
+
+  if (characters.size() == 1 && characters != ".") {  // single character
+    auto accept_state = NewState();
+    // char_classes_ is only filled by Compile(), so search the ranges
+    auto &char_ranges = nfa_.char_ranges_;
+    auto location = upper_bound(
+            char_ranges.cbegin(), char_ranges.cend(),
+            static_cast<unsigned char>(characters[0])) -
+                    char_ranges.cbegin() - 1;
+    AddEdge(begin_state, static_cast<int>(location), accept_state);
+    return {begin_state, accept_state};
+  }
+
+  // a functional state is both the begin state and the accept state
+  if (characters[0] == '[') {  // [...]
+    nfa_.range_states_.emplace_back(begin_state, RangeNfa(characters));
+  } else {  // . and special pattern characters
+    nfa_.special_pattern_states_.emplace_back(
+            begin_state, SpecialPatternNfa(characters));
+  }
+  return {begin_state, begin_state};
 }
 
-Nfa NfaFactory::MakeAlternativeNfa(Nfa left_nfa, Nfa right_nfa) {
-  Nfa nfa;
+NfaBuilder::Fragment NfaBuilder::MakeAlternativeNfa(Fragment left_nfa,
+                                                    Fragment right_nfa) {
+  if (left_nfa.Empty() || right_nfa.Empty()) {
+    return {};
+  }
 
-  nfa += left_nfa;
-  nfa += right_nfa;
   // Add empty edges from new begin state to left_nfa's and right_nfa's begin
   // state.
-  nfa.NewState();
-  nfa.begin_state_ = Nfa::i_;
-  nfa.exchange_map_[nfa.begin_state_][Nfa::kEmptyEdge].insert(
-          left_nfa.begin_state_);
-  nfa.exchange_map_[nfa.begin_state_][Nfa::kEmptyEdge].insert(
-          right_nfa.begin_state_);
+  auto begin_state = NewState();
+  AddEdge(begin_state, Nfa::kEmptyEdge, left_nfa.GetBeginState());
+  AddEdge(begin_state, Nfa::kEmptyEdge, right_nfa.GetBeginState());
   // Add empty edges from left_nfa's and right_nfa's accept states to the new
   // accept state.
-  nfa.NewState();
-  nfa.exchange_map_[left_nfa.accept_states_.cbegin()->first][
-          Nfa::kEmptyEdge].insert(Nfa::i_);
-  nfa.exchange_map_[right_nfa.accept_states_.cbegin()->first][
-          Nfa::kEmptyEdge].insert(Nfa::i_);
-  nfa.accept_states_[Nfa::i_] = TokenType::kEmpty;
+  auto accept_state = NewState();
+  AddEdge(left_nfa.GetAcceptState(), Nfa::kEmptyEdge, accept_state);
+  AddEdge(right_nfa.GetAcceptState(), Nfa::kEmptyEdge, accept_state);
 
-  return nfa;
+  return {begin_state, accept_state};
 }
 
-Nfa NfaFactory::MakeAndNfa(Nfa left_nfa, Nfa right_nfa) {
-  Nfa nfa;
+NfaBuilder::Fragment NfaBuilder::MakeAndNfa(Fragment left_nfa,
+                                            Fragment right_nfa) {
+  if (left_nfa.Empty() || right_nfa.Empty()) {
+    return {};
+  }
 
-  nfa += left_nfa;
-  nfa += right_nfa;
-  nfa.begin_state_ = left_nfa.begin_state_;
-  nfa.accept_states_ = right_nfa.accept_states_;
   // Add empty edges from 'left_nfa''s accept state to 'right_nfa''s begin
   // state.
-  nfa.exchange_map_[left_nfa.accept_states_.cbegin()->first][
-          Nfa::kEmptyEdge].insert(right_nfa.begin_state_);
+  AddEdge(left_nfa.GetAcceptState(), Nfa::kEmptyEdge,
+          right_nfa.GetBeginState());
 
-  return nfa;
+  return {left_nfa.GetBeginState(), right_nfa.GetAcceptState()};
 }
 
-Nfa NfaFactory::MakeQuantifierNfa(const string &quantifier,
-                                  RegexAstNodePtr &left,
-                                  const vector<unsigned int> &char_ranges) {
-  Nfa nfa;
-  nfa.char_ranges_.assign(char_ranges.cbegin(), char_ranges.cend());
-
+NfaBuilder::Fragment NfaBuilder::MakeQuantifierNfa(string_view quantifier,
+                                                   int left) {
   auto repeat_range = ParseQuantifier(quantifier);
 
-  nfa.NewState();
-  nfa.begin_state_ = Nfa::i_;
-  nfa.accept_states_[Nfa::i_] = TokenType::kEmpty;
+  auto begin_state = NewState();
+  Fragment nfa(begin_state, begin_state);
 
   int i = 1;
   for (; i < repeat_range.first; ++i) {
-    Nfa left_nfa(left, nfa.char_ranges_);
-    // connect 'left_nfa' to the end of the current nfa
-    nfa = MakeAndNfa(nfa, left_nfa);
+    // connect a copy of left to the end of the current nfa
+    nfa = MakeAndNfa(std::move(nfa), MakeNfa(left));
   }
 
-  nfa.NewState();
-  int final_accept_state = Nfa::i_;
+  int final_accept_state = NewState();
 
   if (repeat_range.second == INT_MAX) {
-    Nfa left_nfa(left, nfa.char_ranges_);
+    auto left_nfa = MakeNfa(left);
+    auto left_begin_state = left_nfa.GetBeginState();
     // connect left_nfa to the end of the current nfa
-    nfa = MakeAndNfa(nfa, left_nfa);
-    nfa.exchange_map_[nfa.accept_states_.cbegin()->first][
-            Nfa::kEmptyEdge].insert(left_nfa.begin_state_);
-    nfa.exchange_map_[nfa.accept_states_.cbegin()->first][
-            Nfa::kEmptyEdge].insert(final_accept_state);
+    nfa = MakeAndNfa(std::move(nfa), std::move(left_nfa));
+    if (nfa.Empty()) {
+      return {};
+    }
+    AddEdge(nfa.GetAcceptState(), Nfa::kEmptyEdge, left_begin_state);
+    AddEdge(nfa.GetAcceptState(), Nfa::kEmptyEdge, final_accept_state);
   } else {
     for (; i <= repeat_range.second; ++i) {
-      Nfa left_nfa{left, nfa.char_ranges_};
       // connect left_nfa to the end of the current nfa
-      nfa = MakeAndNfa(nfa, left_nfa);
-      nfa.exchange_map_[left_nfa.accept_states_.cbegin()->first][
-              Nfa::kEmptyEdge].insert(final_accept_state);
+      nfa = MakeAndNfa(std::move(nfa), MakeNfa(left));
+      if (nfa.Empty()) {
+        return {};
+      }
+      AddEdge(nfa.GetAcceptState(), Nfa::kEmptyEdge, final_accept_state);
     }
   }
 
-  nfa.accept_states_.clear();
-  nfa.accept_states_[final_accept_state] = TokenType::kEmpty;
-
   if (repeat_range.first == 0) {
     // add an empty edge from the begin state to the accept state
-    nfa.exchange_map_[nfa.begin_state_][Nfa::kEmptyEdge].insert(
-            nfa.accept_states_.cbegin()->first);
+    AddEdge(begin_state, Nfa::kEmptyEdge, final_accept_state);
   }
 
-  return nfa;
+  return {begin_state, final_accept_state};
 }
 
-pair<int, int> NfaFactory::ParseQuantifier(const string &quantifier) {
+pair<int, int> NfaBuilder::ParseQuantifier(string_view quantifier) {
   pair<int, int> repeat_range;
 
   // initialize 'repeat_range'
@@ -760,27 +809,28 @@ pair<int, int> NfaFactory::ParseQuantifier(const string &quantifier) {
     repeat_range.first = 0;
     repeat_range.second = 1;
   } else {  // {...}
+    // a negative char passed to isdigit() is undefined
+    auto is_digit = [](char c) {
+        return isdigit(static_cast<unsigned char>(c)) != 0;
+    };
     // extract first number
-    auto beg_it = find_if(quantifier.cbegin(), quantifier.cend(),
-                          [](auto c) { return isdigit(c); });
-    auto end_it = find_if_not(beg_it, quantifier.cend(),
-                              [](auto c) { return isdigit(c); });
-    repeat_range.first = stoi(string(beg_it, end_it));
+    auto end = quantifier.data() + quantifier.size();
+    auto beg_it = find_if(quantifier.data(), end, is_digit);
+    auto end_it = find_if_not(beg_it, end, is_digit);
+    from_chars(beg_it, end_it, repeat_range.first);
 
     auto comma = quantifier.find(',');
-    if (comma == string::npos) {  // exact times
+    if (comma == string_view::npos) {  // exact times
       repeat_range.second = repeat_range.first;
     } else {  // {min,max} or {min,}
       // extract first number
-      beg_it = find_if(end_it, quantifier.cend(),
-                       [](auto c) { return isdigit(c); });
-      end_it = find_if_not(beg_it, quantifier.cend(),
-                           [](auto c) { return isdigit(c); });
+      beg_it = find_if(end_it, end, is_digit);
+      end_it = find_if_not(beg_it, end, is_digit);
 
       if (beg_it == end_it) {  // {min,}
         repeat_range.second = INT_MAX;
       } else {  // {min,max}
-        repeat_range.second = stoi(string(beg_it, end_it));
+        from_chars(beg_it, end_it, repeat_range.second);
       }
     }
   }
@@ -788,142 +838,87 @@ pair<int, int> NfaFactory::ParseQuantifier(const string &quantifier) {
   return repeat_range;
 }
 
-StrConstIt SpecialPatternNfa::NextMatch(
-        const State &state, StrConstIt str_end) {
-  auto begin = state.second;
-
-  if (begin < str_end) {
-    if (characters_ == ".") {  // not new line
-      if (*begin != '\n' && *begin != '\r') {
-        return begin + 1;
-      }
-    } else if (characters_ == "\\d") {  // digit
-      if (isdigit(*begin)) {
-        return begin + 1;
-      }
-    } else if (characters_ == "\\D") {  // not digit
-      if (!isdigit(*begin)) {
-        return begin + 1;
-      }
-    } else if (characters_ == "\\s") {  // whitespace
-      if (isspace(*begin)) {
-        return begin + 1;
-      }
-    } else if (characters_ == "\\S") {  // not whitespace
-      if (!isspace(*begin)) {
-        return begin + 1;
-      }
-    } else if (characters_ == "\\w") {  // word
-      if (isalnum(*begin)) {
-        return begin + 1;
-      }
-    } else if (characters_ == "\\W") {  // not word
-      if (!isalnum(*begin)) {
-        return begin + 1;
-      }
-    } else if (characters_ == "\\t") {  // \t
-      if (*begin == '\t') {
-        return begin + 1;
-      }
-    } else if (characters_ == "\\n") {  // \n
-      if (*begin == '\n') {
-        return begin + 1;
-      }
-    } else if (characters_ == "\\r") {  // \r
-      if (*begin == '\r') {
-        return begin + 1;
-      }
-    } else if (characters_ == "\\v") {  // \v
-      if (*begin == '\v') {
-        return begin + 1;
-      }
-    } else if (characters_ == "\\f") {  // \f
-      if (*begin == '\f') {
-        return begin + 1;
-      }
-    } else if (characters_ == "\\0") {  // \0
-      if (*begin == '\0') {
-        return begin + 1;
-      }
-    } else {  // \\^ \\$ \\\\ \\. \\* \\+ \\? \\( \\) \\[ \\] \\{ \\} \\|
-      if (*begin == characters_[1]) {
-        return begin + 1;
+void AddSpecialPatternBytes(string_view characters, ByteSet &bytes) {
+  auto add_if = [&](auto predicate) {
+      for (int c = 0; c < 256; ++c) {
+        if (predicate(c)) {
+          bytes.Add(c);
+        }
       }
-    }
+  };
+
+  if (characters == ".") {  // not new line
+    add_if([](int c) { return c != '\n' && c != '\r'; });
+  } else if (characters == "\\d") {  // digit
+    add_if([](int c) { return isdigit(c); });
+  } else if (characters == "\\D") {  // not digit
+    add_if([](int c) { return !isdigit(c); });
+  } else if (characters == "\\s") {  // whitespace
+    add_if([](int c) { return isspace(c); });
+  } else if (characters == "\\S") {  // not whitespace
+    add_if([](int c) { return !isspace(c); });
+  } else if (characters == "\\w") {  // word
+    add_if([](int c) { return isalnum(c); });
+  } else if (characters == "\\W") {  // not word
+    add_if([](int c) { return !isalnum(c); });
+  } else if (characters == "\\t") {  // \t
+    bytes.Add('\t');
+  } else if (characters == "\\n") {  // \n
+    bytes.Add('\n');
+  } else if (characters == "\\r") {  // \r
+    bytes.Add('\r');
+  } else if (characters == "\\v") {  // \v
+    bytes.Add('\v');
+  } else if (characters == "\\f") {  // \f
+    bytes.Add('\f');
+  } else if (characters == "\\0") {  // \0
+    bytes.Add('\0');
+  } else if (characters.size() >= 2) {
+    // \\^ \\$ \\\\ \\. \\* \\+ \\? \\( \\) \\[ \\] \\{ \\} \\|
+    // A trailing '\\' matches nothing.
+    bytes.Add(characters[1]);
   }
   // TODO(dxy): \\c \\x \\u
+}
 
-  return begin;
+SpecialPatternNfa::SpecialPatternNfa(string_view characters) {
+  AddSpecialPatternBytes(characters, bytes_);
 }
 
-RangeNfa::RangeNfa(const string &regex) {
+RangeNfa::RangeNfa(string_view regex) {
   auto begin = regex.cbegin() + 1, end = regex.cend() - 1;
 
-  if (*begin == '^') {  // [^...]
-    except_ = true;
+  bool except = *begin == '^';  // [^...]
+  if (except) {
     begin++;
-  } else {
-    except_ = false;
   }
 
+  // bytes in [low, high], compared as chars
+  auto add_range = [&](char low, char high) {
+      for (int c = low; c <= high; ++c) {
+        bytes_.Add(static_cast<unsigned char>(c));
+      }
+  };
   while (begin != end) {
-    if (*begin == '\\') {  // skip special patterns
+    if (*begin == '\\') {  // special patterns
       auto tmp_it = SkipEscapeCharacters(begin, end);
-      special_patterns_.emplace_back(string(begin, tmp_it));
+      AddSpecialPatternBytes(string_view(begin, tmp_it), bytes_);
       begin = tmp_it;
     } else if (*begin == '.') {
-      special_patterns_.emplace_back(string(begin, begin + 1));
+      AddSpecialPatternBytes(".", bytes_);
       begin++;
     } else {
-      if (begin + 1 < end && *(begin + 1) == '-') {  // range
-        if (begin + 2 < end) {
-          ranges_.insert({*begin, *(begin + 2)});
-          begin += 3;
-        }
-      } else {  // single character
-        ranges_.insert({*begin, *(begin + 1)});
+      if (begin + 2 < end && *(begin + 1) == '-') {  // range
+        add_range(*begin, *(begin + 2));
+        begin += 3;
+      } else {  // single character, and '-' at the end is itself
+        add_range(*begin, *begin);
         begin++;
       }
     }
   }
-}
-
-StrConstIt RangeNfa::NextMatch(const State &state, StrConstIt str_end) {
-  auto begin = state.second;
-
-  if (begin == str_end) {  // no character to match
-    return begin;
-  }
-
-  if (except_) {
-    for (auto &range:ranges_) {
-      if (*begin >= range.first && *begin <= range.second) {
-        return begin;
-      }
-    }
-
-    for (auto special_pattern:special_patterns_) {
-      begin = special_pattern.NextMatch(state, str_end);
-      if (begin != state.second) {
-        return state.second;
-      }
-    }
-
-    return begin + 1;
-  } else {
-    for (auto &range:ranges_) {
-      if (*begin >= range.first && *begin <= range.second) {
-        return begin + 1;
-      }
-    }
 
-    for (auto special_pattern:special_patterns_) {
-      begin = special_pattern.NextMatch(state, str_end);
-      if (begin != state.second) {
-        return begin;
-      }
-    }
-
-    return begin;
+  if (except) {
+    bytes_.Invert();
   }
-}
\ No newline at end of file
+}
@@ -0,0 +1,129 @@
+//
+// Created by dxy on 2020/12/16.
+//
+
+#include "lex/scanner.h"
+
+using namespace CCompiler;
+using namespace std;
+
+namespace {
+/**
+ * Add the bytes matched by a character of a regex to bytes. Characters
+ * other than single bytes use the same matchers as the Nfa, see
+ * NfaBuilder::MakeCharacterNfa().
+ *
+ * @param characters
+ * @param bytes
+ */
+void AddCharacterBytes(string_view characters, bool (&bytes)[256]) {
+  if (characters.size() == 1 && characters != ".") {
+    bytes[static_cast<unsigned char>(characters[0])] = true;
+    return;
+  }
+
+  auto matched = characters[0] == '[' ? RangeNfa(characters).GetBytes() :
+                 SpecialPatternNfa(characters).GetBytes();
+  for (int c = 0; c < 256; ++c) {
+    bytes[c] = bytes[c] || matched.Contains(c);
+  }
+}
+
+/**
+ * Add the bytes that a non-empty match of node can begin with to bytes.
+ *
+ * @param ast
+ * @param node
+ * @param bytes
+ * @return whether node matches the empty string
+ */
+bool AddStartBytes(const RegexAst &ast, int node, bool (&bytes)[256]) {
+  if (node == RegexAst::kNoNode) {
+    return false;
+  }
+
+  auto &ast_node = ast.GetNode(node);
+  switch (ast_node.regex_type) {
+    case RegexPart::kChar:
+      AddCharacterBytes(ast_node.regex, bytes);
+      return false;
+    case RegexPart::kAlternative: {
+      auto left_empty = AddStartBytes(ast, ast_node.left_son, bytes);
+      auto right_empty = AddStartBytes(ast, ast_node.right_son, bytes);
+      return left_empty || right_empty;
+    }
+    case RegexPart::kAnd:
+      // the right son only begins a match when the left one can be empty
+      return AddStartBytes(ast, ast_node.left_son, bytes) &&
+             AddStartBytes(ast, ast_node.right_son, bytes);
+    case RegexPart::kQuantifier: {
+      auto left_empty = AddStartBytes(ast, ast_node.left_son, bytes);
+      return left_empty ||
+             NfaBuilder::ParseQuantifier(ast_node.regex).first == 0;
+    }
+    case RegexPart::kPassiveGroup:
+    case RegexPart::kError:
+      break;
+  }
+  return false;
+}
+}
+
+Scanner::Scanner(const map<string, TokenType> &regex_rules)
+        : nfa_(regex_rules),
+          lazy_dfa_(nfa_) {
+  RegexAst ast;
+  for (auto &regex_rule:regex_rules) {
+    ast.Clear();
+    AddStartBytes(ast, ast.Parse(regex_rule.first), start_bytes_);
+  }
+
+  for (int c = 0; c < 256; ++c) {
+    if (start_bytes_[c]) {
+      start_byte_count_++;
+      single_start_byte_ = static_cast<char>(c);
+    }
+  }
+  bool other_bytes[256];
+  for (int c = 0; c < 256; ++c) {
+    other_bytes[c] = !start_bytes_[c];
+  }
+  other_bytes_ = ByteRanges::FromBytes(other_bytes);
+}
+
+vector<Token> Scanner::FindAll(string_view text) {
+  vector<Token> tokens;
+  auto begin = text.cbegin(), end = text.cend();
+  // locations are scanned again by matches from earlier candidates
+  LazyDfa::FailureMemo memo;
+
+  while ((begin = NextCandidate(begin, end)) != end) {
+    auto match = lazy_dfa_.NextMatch(begin, end, &memo);
+    if (!match || match->second == begin) {
+      begin++;
+      continue;
+    }
+    tokens.emplace_back(string_view(begin, match->second), match->first,
+                        static_cast<uint32_t>(begin - text.cbegin()));
+    begin = match->second;
+  }
+  return tokens;
+}
+
+int Scanner::StartByteCount() const {
+  return start_byte_count_;
+}
+
+StrConstIt Scanner::NextCandidate(StrConstIt begin, StrConstIt end) const {
+  if (start_byte_count_ == 1) {
+    return FindByte(begin, end, single_start_byte_);
+  }
+  if (other_bytes_.count != 0) {
+    return SkipRanges(begin, end, other_bytes_);
+  }
+  // either every byte can begin a match or the others are too scattered
+  while (begin != end && !start_bytes_[static_cast<unsigned char>(*begin)]) {
+    ++begin;
+  }
+  return begin;
+}
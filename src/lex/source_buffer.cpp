@@ -0,0 +1,54 @@
+//
+// Created by dxy on 2020/12/13.
+//
+
+#include "lex/source_buffer.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "lex/byte_scan.h"
+
+using namespace CCompiler;
+using namespace std;
+
+shared_ptr<const SourceBuffer> SourceBuffer::Open(const string &path) {
+  auto file = MappedFile::Open(path);
+  if (file == nullptr) {
+    return nullptr;
+  }
+  return make_shared<const SourceBuffer>(std::move(file));
+}
+
+shared_ptr<const SourceBuffer> SourceBuffer::Read(istream &stream) {
+  string text;
+  stream.seekg(0, ios::end);
+  auto size = static_cast<streamoff>(stream.tellg());
+  stream.seekg(0, ios::beg);
+  if (size >= 0) {  // read the file at once to allocate the text only once
+    text.resize(size);
+    stream.read(text.data(), size);
+    text.resize(stream.gcount());
+  } else {
+    stream.clear();
+    text.assign(istreambuf_iterator<char>(stream),
+                istreambuf_iterator<char>());
+  }
+  return make_shared<const SourceBuffer>(std::move(text));
+}
+
+SourceLocation SourceBuffer::GetLocation(uint32_t offset) const {
+  call_once(line_starts_flag_, [this]() {
+      // a line starts at the beginning and after every '\n'
+      line_starts_.push_back(0);
+      FindAll(view_.cbegin(), view_.cend(), '\n', line_starts_);
+      for (size_t i = 1; i < line_starts_.size(); ++i) {
+        line_starts_[i]++;
+      }
+  });
+
+  auto line = upper_bound(line_starts_.cbegin(), line_starts_.cend(),
+                          offset) - line_starts_.cbegin();
+  return {static_cast<int>(line),
+          static_cast<int>(offset - line_starts_[line - 1])};
+}
@@ -0,0 +1,65 @@
+//
+// Created by dxy on 2020/12/14.
+//
+
+#include "lex/stream_buffer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+
+using namespace CCompiler;
+using namespace std;
+
+StreamBuffer::StreamBuffer(int fd, size_t capacity)
+        : fd_(fd),
+          capacity_(max(capacity, size_t{1})),
+          data_(make_unique<char[]>(capacity_)) {}
+
+size_t StreamBuffer::Refill(StrConstIt keep) {
+  auto text = GetText();
+  auto dropped = static_cast<size_t>(keep - text.cbegin());
+
+  // count the dropped lines so that later locations are right
+  for (auto it = FindByte(text.cbegin(), keep, '\n'); it != keep;
+       it = FindByte(it + 1, keep, '\n')) {
+    line_++;
+    line_start_ = GetOffset(it - text.cbegin()) + 1;
+  }
+  memmove(data_.get(), data_.get() + dropped, size_ - dropped);
+  size_ -= dropped;
+  offset_ += dropped;
+
+  while (size_ < capacity_ && !at_end_) {
+    auto count = read(fd_, data_.get() + size_, capacity_ - size_);
+    if (count > 0) {
+      size_ += count;
+    } else if (count == 0 || errno != EINTR) {
+      at_end_ = true;
+    }
+  }
+
+  return dropped;
+}
+
+void StreamBuffer::Grow() {
+  auto data = make_unique<char[]>(capacity_ * 2);
+  memcpy(data.get(), data_.get(), size_);
+  data_ = std::move(data);
+  capacity_ *= 2;
+}
+
+SourceLocation StreamBuffer::GetLocation(size_t position) const {
+  auto text = GetText();
+  auto line = line_;
+  auto line_start = line_start_;
+  auto end = text.cbegin() + position;
+  for (auto it = FindByte(text.cbegin(), end, '\n'); it != end;
+       it = FindByte(it + 1, end, '\n')) {
+    line++;
+    line_start = GetOffset(it - text.cbegin()) + 1;
+  }
+  return {line, static_cast<int>(GetOffset(position) - line_start)};
+}
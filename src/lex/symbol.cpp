@@ -0,0 +1,71 @@
+//
+// Created by dxy on 2020/12/17.
+//
+
+#include "lex/symbol.h"
+
+#include <mutex>
+
+using namespace CCompiler;
+using namespace std;
+
+Symbol::Symbol(string_view spelling)
+        : id_(SymbolTable::Global().Intern(spelling).id_) {}
+
+string_view Symbol::GetSpelling() const {
+  return SymbolTable::Global().GetSpelling(*this);
+}
+
+SymbolTable &SymbolTable::Global() {
+  static SymbolTable table;
+  return table;
+}
+
+Symbol SymbolTable::Intern(string_view spelling) {
+  Symbol symbol;
+  if (spelling.empty()) {
+    return symbol;
+  }
+
+  auto shard_index = hash<string_view>()(spelling) % kShardCount;
+  auto &shard = shards_[shard_index];
+  {
+    shared_lock lock(shard.mutex);
+    auto it = shard.ids.find(spelling);
+    if (it != shard.ids.end()) {
+      symbol.id_ = it->second;
+      return symbol;
+    }
+  }
+
+  unique_lock lock(shard.mutex);
+  // another thread may have added it between the locks
+  auto it = shard.ids.find(spelling);
+  if (it == shard.ids.end()) {
+    shard.spellings.emplace_back(spelling);
+    auto id = static_cast<uint32_t>(shard.spellings.size() << kShardBits |
+                                    shard_index);
+    it = shard.ids.insert({shard.spellings.back(), id}).first;
+  }
+  symbol.id_ = it->second;
+  return symbol;
+}
+
+string_view SymbolTable::GetSpelling(Symbol symbol) const {
+  if (symbol.Empty()) {
+    return {};
+  }
+
+  auto &shard = shards_[symbol.id_ & (kShardCount - 1)];
+  shared_lock lock(shard.mutex);
+  return shard.spellings[(symbol.id_ >> kShardBits) - 1];
+}
+
+size_t SymbolTable::Size() const {
+  size_t size = 0;
+  for (auto &shard:shards_) {
+    shared_lock lock(shard.mutex);
+    size += shard.spellings.size();
+  }
+  return size;
+}
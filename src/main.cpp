@@ -2,11 +2,9 @@
 // Created by dxy on 2020/8/13.
 //
 
-#include <fstream>
-#include <sstream>
-
 #include "environment.h"
 #include "lex/lexer.h"
+#include "lex/source_buffer.h"
 #include "lex/token.h"
 #include "parser/parser.h"
 
@@ -16,9 +14,13 @@ using namespace std;
 int main(int argc, char **argv) {
   Environment::EnvironmentInit();
 
+  auto source = SourceBuffer::Open(
+          "/mnt/e/cs_learning/project/CCompiler/test/source.c");
+  if (source == nullptr) {
+    return -1;
+  }
   for (int i = 0; i < 100; ++i) {
-    ifstream file("/mnt/e/cs_learning/project/CCompiler/test/source.c");
-    Parser parser(file);
+    Parser parser(source);
     parser.Parse();
   }
 
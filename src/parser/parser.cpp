@@ -15,8 +15,8 @@ using namespace std;
 int storage_spec = 0;
 
 TranslationUnit *Parser::Parse() {
-  while (!lexer_.Peek().Empty()) {
-    lexer_.Rollback(lexer_.Next());
+  while (!preprocessor_.Peek().Empty()) {
+    preprocessor_.Rollback(preprocessor_.Next());
     ParseTranslateUnit();
   }
 
@@ -26,7 +26,7 @@ TranslationUnit *Parser::Parse() {
 void Parser::ParseTranslateUnit() {
   auto type = ParseDeclSpec();
 
-  auto token = lexer_.Next();
+  auto token = preprocessor_.Next();
   if (token.GetType() == TokenType::kSemicolon) {
     // Struct, union, enum and typedef declaration. All other types will be
     // ignored.
@@ -37,10 +37,10 @@ void Parser::ParseTranslateUnit() {
               new TypeDecl(dynamic_cast<TypeDeclType *>(type)));
     }
   } else {
-    lexer_.Rollback(token);
+    preprocessor_.Rollback(token);
     auto ident = ParseDeclarator(type);
 
-    token = lexer_.Next();
+    token = preprocessor_.Next();
     if (token.GetType() == TokenType::kAssign) {  // initializer for object
       trans_unit_->AddExternalDef(new ObjectDecl(
               dynamic_cast<Object *>(ident),
@@ -67,20 +67,20 @@ void Parser::ParseTranslateUnit() {
       }
       return;
     } else {
-      lexer_.Rollback(token);
+      preprocessor_.Rollback(token);
     }
 
-    token = lexer_.Next();
+    token = preprocessor_.Next();
     if (token.GetType() == TokenType::kComma) {  // several object declarations
       for (auto &obj_decl:ParseList(
               function([this, type](int i) {
                   auto object = dynamic_cast<Object *>(ParseDeclarator(type));
 
-                  auto token = lexer_.Next();
+                  auto token = preprocessor_.Next();
                   if (token.GetType() == TokenType::kAssign) {
                     return new ObjectDecl(object, ParseInitializer(0));
                   } else {
-                    lexer_.Rollback(token);
+                    preprocessor_.Rollback(token);
                     return new ObjectDecl(object, nullptr);
                   }
               }),
@@ -98,7 +98,7 @@ Type *Parser::ParseDeclSpec() {
   Token token;
 
   // struct, union and enum
-  token = lexer_.Next();
+  token = preprocessor_.Next();
   if (token.GetType() == TokenType::kStruct) {
     return ParseStructOrUnion(true);
   } else if (token.GetType() == TokenType::kUnion) {
@@ -106,11 +106,11 @@ Type *Parser::ParseDeclSpec() {
   } else if (token.GetType() == TokenType::kEnum) {
     return ParseEnum();
   } else {
-    lexer_.Rollback(token);
+    preprocessor_.Rollback(token);
   }
 
   auto *type = new QualType();
-  while (!(token = lexer_.Next()).Empty()) {
+  while (!(token = preprocessor_.Next()).Empty()) {
     // storage class specifier
     if (token.GetType() == TokenType::kExtern) {
       storage_spec |= kExtern;
@@ -157,7 +157,7 @@ Type *Parser::ParseDeclSpec() {
     }
       // end of QualType
     else {
-      lexer_.Rollback(token);
+      preprocessor_.Rollback(token);
       break;
     }
   }
@@ -165,18 +165,18 @@ Type *Parser::ParseDeclSpec() {
 }
 
 StmtList Parser::ParseCompoundStmt() {
-  Token token = lexer_.Next();
+  Token token = preprocessor_.Next();
   if (token.GetType() == TokenType::kRightCurlyBracket) {
     return StmtList();
   } else {
     StmtList stmt_list;
 
-    lexer_.Rollback(token);
-    while (!(token = lexer_.Next()).Empty()) {
+    preprocessor_.Rollback(token);
+    while (!(token = preprocessor_.Next()).Empty()) {
       if (token.GetType() == TokenType::kRightCurlyBracket) {
         return stmt_list;
       } else {
-        lexer_.Rollback(token);
+        preprocessor_.Rollback(token);
         if (IsDeclSpec(token)) {
           for (auto &decl:ParseDecl()) {
             stmt_list.push_back(decl);
@@ -194,45 +194,46 @@ StmtList Parser::ParseCompoundStmt() {
 
 Identifier *Parser::ParseDeclarator(Type *type) {
   Identifier *ident;
-  string name;
+  Symbol name;
 
   // parse pointers
-  auto token = lexer_.Next();
+  auto token = preprocessor_.Next();
   if (token.GetType() == TokenType::kAsterisk) {
     type = ParsePointer(type);
   } else {
-    lexer_.Rollback(token);
+    preprocessor_.Rollback(token);
   }
 
-  token = lexer_.Next();
+  token = preprocessor_.Next();
   if (token.GetType() == TokenType::kIdentifier) {
-    name = token.GetToken();
+    name = Symbol(token.GetToken());
   } else {
     exit(-1);
   }
 
-  token = lexer_.Next();
+  token = preprocessor_.Next();
   if (token.GetType() == TokenType::kLeftParenthesis) {  // function prototype
     // parse params
-    token = lexer_.Next();
+    token = preprocessor_.Next();
     if (token.GetType() == TokenType::kRightParenthesis) {
       ident = new Function(type, Identifier::Linkage::kNone, name,
                            list<Identifier *>());
     } else {
-      lexer_.Rollback(token);
+      preprocessor_.Rollback(token);
       ident = new Function(
               type,
               Identifier::Linkage::kNone,
               name,
               ParseList(function([this](int i) {
                             auto type = ParseDeclSpec();
-                            auto token = lexer_.Next();
+                            auto token = preprocessor_.Next();
                             if (token.GetType() == TokenType::kComma ||
                                 token.GetType() ==
                                 TokenType::kRightParenthesis) {
-                              lexer_.Rollback(token);
+                              preprocessor_.Rollback(token);
                               return new Identifier(
-                                      type, Identifier::Linkage::kNone, "");
+                                      type, Identifier::Linkage::kNone,
+                                      Symbol());
                             }
                             return ParseDeclarator(type);
                         }),
@@ -241,7 +242,7 @@ Identifier *Parser::ParseDeclarator(Type *type) {
   } else if (token.GetType() == TokenType::kLeftBracket) {  // array
     type = new ArrayType(type, ParseIntConstExpr()->ToInt());
     Check(TokenType::kRightBracket);
-    while ((token = lexer_.Next()).GetType() == TokenType::kLeftBracket) {
+    while ((token = preprocessor_.Next()).GetType() == TokenType::kLeftBracket) {
       type = new ArrayType(type, ParseIntConstExpr()->ToInt());
       Check(TokenType::kRightBracket);
     }
@@ -249,20 +250,20 @@ Identifier *Parser::ParseDeclarator(Type *type) {
     ident = new Object(new Identifier(type, Identifier::Linkage::kNone, name),
                        storage_spec);
 
-    lexer_.Rollback(token);
+    preprocessor_.Rollback(token);
   } else {
     // TODO(dxy): determine linkage
     ident = new Object(new Identifier(type, Identifier::Linkage::kNone, name),
                        storage_spec);
 
-    lexer_.Rollback(token);
+    preprocessor_.Rollback(token);
   }
 
   return ident;
 }
 
 Initializer *Parser::ParseInitializer(Initializer::Element offset) {
-  Token token = lexer_.Next();
+  Token token = preprocessor_.Next();
   if (token.GetType() == TokenType::kLeftCurlyBracket) {  // for {} initializer
     return new InitializerList(
             std::move(offset), ParseList(function([this](int offset) {
@@ -273,7 +274,7 @@ Initializer *Parser::ParseInitializer(Initializer::Element offset) {
                 Initializer::Element designator_offset;
                 Token token;
                 bool designator = false;
-                while (!(token = lexer_.Next()).Empty()) {
+                while (!(token = preprocessor_.Next()).Empty()) {
                   if (token.GetType() == TokenType::kLeftBracket) {
                     designator = true;
                     designator_offset = ParseIntConstExpr()->ToInt();
@@ -286,14 +287,14 @@ Initializer *Parser::ParseInitializer(Initializer::Element offset) {
                   } else if (token.GetType() == TokenType::kDot) {
                     designator = true;
                     designator_offset =
-                            Check(TokenType::kIdentifier).GetToken();
+                            Symbol(Check(TokenType::kIdentifier).GetToken());
                     auto next_init = new InitializerList(
-                            get<string>(designator_offset));
+                            get<Symbol>(designator_offset));
                     cur_init->AddInit(next_init);
                     last_init = cur_init;
                     cur_init = next_init;
                   } else {
-                    lexer_.Rollback(token);
+                    preprocessor_.Rollback(token);
                     break;
                   }
                 }
@@ -308,7 +309,7 @@ Initializer *Parser::ParseInitializer(Initializer::Element offset) {
             }), TokenType::kRightCurlyBracket));
   } else {  // for single value initializer
     // TODO(dxy):
-    lexer_.Rollback(token);
+    preprocessor_.Rollback(token);
     return new BaseInitializer(offset, ParseConditionalExpr());
   }
 }
@@ -319,10 +320,10 @@ PointerType *Parser::ParsePointer(Type *type) {
   Token token;
 
   token = Check(TokenType::kAsterisk);
-  lexer_.Rollback(token);
+  preprocessor_.Rollback(token);
 
-  while ((token = lexer_.Next()).GetType() == TokenType::kAsterisk) {
-    token = lexer_.Next();
+  while ((token = preprocessor_.Next()).GetType() == TokenType::kAsterisk) {
+    token = preprocessor_.Next();
     if (token.GetType() == TokenType::kConst) {
       ptr_type = new PointerType(derived, Qualifier::kConst);
       derived = ptr_type;
@@ -338,16 +339,16 @@ PointerType *Parser::ParsePointer(Type *type) {
     } else {
       ptr_type = new PointerType(derived, Qualifier::kEmpty);
       derived = ptr_type;
-      lexer_.Rollback(token);
+      preprocessor_.Rollback(token);
     }
   }
-  lexer_.Rollback(token);
+  preprocessor_.Rollback(token);
 
   return ptr_type;
 }
 
 Token Parser::Check(TokenType type) {
-  auto token = lexer_.Next();
+  auto token = preprocessor_.Next();
 
   if (token.GetType() == type) {
     return token;
@@ -367,12 +368,12 @@ Expr *Parser::ParseConstExpr() {
 StructUnionType *Parser::ParseStructOrUnion(bool flag) {
   StructUnionType *type;
 
-  auto token = lexer_.Next();
+  auto token = preprocessor_.Next();
   if (token.GetType() == TokenType::kIdentifier) {
-    type = new StructUnionType(flag, token.GetToken());
-    token = lexer_.Next();
+    type = new StructUnionType(flag, Symbol(token.GetToken()));
+    token = preprocessor_.Next();
     if (token.GetType() != TokenType::kLeftCurlyBracket) {
-      lexer_.Rollback(token);
+      preprocessor_.Rollback(token);
       return type;
     }
   } else if (token.GetType() == TokenType::kLeftCurlyBracket) {
@@ -382,8 +383,8 @@ StructUnionType *Parser::ParseStructOrUnion(bool flag) {
   }
 
   // parse struct-declaration-list
-  while ((token = lexer_.Next()).GetType() != TokenType::kRightCurlyBracket) {
-    lexer_.Rollback(token);
+  while ((token = preprocessor_.Next()).GetType() != TokenType::kRightCurlyBracket) {
+    preprocessor_.Rollback(token);
     for (auto &element: ParseList(
             function(
                     [this](int i) { return ParseDeclarator(ParseDeclSpec()); }),
@@ -397,20 +398,19 @@ StructUnionType *Parser::ParseStructOrUnion(bool flag) {
 
 EnumType *Parser::ParseEnum() {
   Token token;
-  string ident;
   EnumType *enum_type;
 
-  token = lexer_.Next();
+  token = preprocessor_.Next();
   if (token.GetType() == TokenType::kIdentifier) {
-    enum_type = new EnumType(token.GetToken());
+    enum_type = new EnumType(Symbol(token.GetToken()));
 
-    token = lexer_.Next();
+    token = preprocessor_.Next();
     if (token.GetType() != TokenType::kLeftCurlyBracket) {
-      lexer_.Rollback(token);
+      preprocessor_.Rollback(token);
       return enum_type;
     }
   } else if (token.GetType() == TokenType::kLeftCurlyBracket) {
-    enum_type = new EnumType("");
+    enum_type = new EnumType(Symbol());
   } else {
     exit(-1);
   }
@@ -419,14 +419,14 @@ EnumType *Parser::ParseEnum() {
   for (auto &enumerator:ParseList(
           function([this](int i) {
               EnumType::Enumerator enumerator;
-              auto token = lexer_.Next();
+              auto token = preprocessor_.Next();
               if (token.GetType() == TokenType::kIdentifier) {
-                enumerator.ident_ = token.GetToken();
-                token = lexer_.Next();
+                enumerator.ident_ = Symbol(token.GetToken());
+                token = preprocessor_.Next();
                 if (token.GetType() == TokenType::kAssign) {
                   enumerator.value_ = ParseIntConstExpr()->ToInt();
                 } else {
-                  lexer_.Rollback(token);
+                  preprocessor_.Rollback(token);
                 }
               } else {
                 exit(-1);
@@ -449,10 +449,10 @@ Parser::ParseList(function<T(int)> ParseElement,
   int i = 0;
 
   elements.push_back(ParseElement(i++));
-  while ((token = lexer_.Next()).GetType() == delim) {
+  while ((token = preprocessor_.Next()).GetType() == delim) {
     elements.push_back(ParseElement(i++));
   }
-  lexer_.Rollback(token);
+  preprocessor_.Rollback(token);
 
   if (end != TokenType::kEmpty) {
     Check(end);
@@ -462,18 +462,18 @@ Parser::ParseList(function<T(int)> ParseElement,
 }
 
 StmtList Parser::ParseStmt() {
-  Token token = lexer_.Next();
+  Token token = preprocessor_.Next();
   if (token.GetType() == TokenType::kIdentifier) {
     auto ident = token;
-    token = lexer_.Next();
+    token = preprocessor_.Next();
     if (token.GetType() == TokenType::kColon) {  // identifier labeled statement
       return {new LabelStmt(LabelStmt::Label(new Identifier(nullptr,
                                                             Identifier::Linkage::kNone,
-                                                            ident.GetToken())),
+                                                            Symbol(ident.GetToken()))),
                             ParseStmt())};
     } else {  // expression statement started with ident
-      lexer_.Rollback(token);
-      lexer_.Rollback(ident);
+      preprocessor_.Rollback(token);
+      preprocessor_.Rollback(ident);
       auto *expr = ParseExpr();
       Check(TokenType::kSemicolon);
       return {new ExprStmt(expr)};
@@ -497,7 +497,7 @@ StmtList Parser::ParseStmt() {
     scope_ = if_scope;
     auto if_stmt = ParseStmt();
     scope_ = scope_->GetParent();
-    token = lexer_.Next();
+    token = preprocessor_.Next();
     if (token.GetType() == TokenType::kElse) {
       auto else_scope = new Scope(Scope::ScopeType::kBlock, scope_);
       scope_ = else_scope;
@@ -507,7 +507,7 @@ StmtList Parser::ParseStmt() {
                          condition,
                          new CompoundStmt(else_scope, else_stmt))};
     } else {
-      lexer_.Rollback(token);
+      preprocessor_.Rollback(token);
       return {new IfStmt(if_scope, if_stmt, condition)};
     }
   } else if (token.GetType() == TokenType::kSwitch) {
@@ -554,33 +554,33 @@ StmtList Parser::ParseStmt() {
     Check(TokenType::kLeftParenthesis);
 
     StmtList init;
-    token = lexer_.Next();
+    token = preprocessor_.Next();
     if (IsDeclSpec(token)) {  // declaration
-      lexer_.Rollback(token);
+      preprocessor_.Rollback(token);
       for (auto &decl:ParseDecl()) {
         init.push_back(decl);
       }
     } else if (token.GetType() != TokenType::kSemicolon) {  // expression
-      lexer_.Rollback(token);
+      preprocessor_.Rollback(token);
       init.push_back(new ExprStmt(ParseExpr()));
       Check(TokenType::kSemicolon);
     }
 
     Expr *condition = nullptr;
-    token = lexer_.Next();
+    token = preprocessor_.Next();
     if (token.GetType() != TokenType::kSemicolon) {
-      lexer_.Rollback(token);
+      preprocessor_.Rollback(token);
       condition = ParseExpr();
       Check(TokenType::kSemicolon);
     }
 
     Expr *after_loop = nullptr;
-    token = lexer_.Next();
+    token = preprocessor_.Next();
     if (token.GetType() != TokenType::kRightParenthesis) {
-      lexer_.Rollback(token);
+      preprocessor_.Rollback(token);
       after_loop = ParseExpr();
     } else {
-      lexer_.Rollback(token);
+      preprocessor_.Rollback(token);
     }
 
     Check(TokenType::kRightParenthesis);
@@ -594,7 +594,7 @@ StmtList Parser::ParseStmt() {
     // jump statement
   else if (token.GetType() == TokenType::kGoto) {
     Check(TokenType::kSemicolon);
-    auto ident = Check(TokenType::kIdentifier).GetToken();
+    auto ident = Symbol(Check(TokenType::kIdentifier).GetToken());
     return {new JumpStmt(JumpStmt::JumpType::kGoto, ident)};
   } else if (token.GetType() == TokenType::kContinue) {
     Check(TokenType::kSemicolon);
@@ -603,11 +603,11 @@ StmtList Parser::ParseStmt() {
     Check(TokenType::kSemicolon);
     return {new JumpStmt(JumpStmt::JumpType::kBreak)};
   } else if (token.GetType() == TokenType::kReturn) {
-    token = lexer_.Next();
+    token = preprocessor_.Next();
     if (token.GetType() == TokenType::kSemicolon) {
       return {new ReturnStmt(nullptr)};
     } else {
-      lexer_.Rollback(token);
+      preprocessor_.Rollback(token);
       auto return_value = ParseExpr();
       Check(TokenType::kSemicolon);
       return {new ReturnStmt(return_value)};
@@ -620,7 +620,7 @@ StmtList Parser::ParseStmt() {
 std::list<Decl *> Parser::ParseDecl() {
   auto type = ParseDeclSpec();
 
-  Token token = lexer_.Next();
+  Token token = preprocessor_.Next();
   if (token.GetType() == TokenType::kSemicolon) {  // type
     // Struct, union, enum and typedef declaration. All other types will be
     // ignored.
@@ -633,18 +633,18 @@ std::list<Decl *> Parser::ParseDecl() {
     }
     return {};
   } else {
-    lexer_.Rollback(token);
+    preprocessor_.Rollback(token);
     return ParseList(function([this, type](int i) {
         auto ident = ParseDeclarator(type);
 
-        auto token = lexer_.Next();
+        auto token = preprocessor_.Next();
         if (token.GetType() == TokenType::kAssign) {  // initialized object
           auto obj_decl = new ObjectDecl(dynamic_cast<Object *>(ident),
                                          ParseInitializer(0));
           scope_->AddIdent(obj_decl);
           return dynamic_cast<Decl *>(obj_decl);
         } else {  // uninitialized object
-          lexer_.Rollback(token);
+          preprocessor_.Rollback(token);
           if (typeid(*ident) == typeid(Object)) {
             auto obj_decl = new ObjectDecl(dynamic_cast<Object *>(ident),
                                            nullptr);
@@ -723,14 +723,14 @@ Expr *Parser::ParseAssignExpr() {
 Expr *Parser::ParseConditionalExpr() {
   auto expr = ParseLogicalOrExpr();
 
-  Token token = lexer_.Next();
+  Token token = preprocessor_.Next();
   if (token.GetType() == TokenType::kQuestion) {
     auto operand2 = ParseExpr();
     Check(TokenType::kColon);
     auto operand3 = ParseConditionalExpr();
     return new ConditionalExpr(TokenType::kQuestion, expr, operand2, operand3);
   } else {
-    lexer_.Rollback(token);
+    preprocessor_.Rollback(token);
     return expr;
   }
 }
@@ -804,47 +804,47 @@ T Parser::ParseBinaryExpr(function<T()> ParseOperand,
                           const list<TokenType> &types) {
   auto l_operand = ParseOperand();
 
-  auto token = lexer_.Next();
+  auto token = preprocessor_.Next();
   for (auto &type:types) {
     if (token.GetType() == type) {
       return new BinaryExpr(type, l_operand, ParseOperand());
     }
   }
-  lexer_.Rollback(token);
+  preprocessor_.Rollback(token);
 
   return l_operand;
 }
 
 Expr *Parser::ParseCastExpr() {
   // TODO(dxy):
-  /*Token token=lexer_.Next();
+  /*Token token=preprocessor_.Next();
   if (token.GetType()==TokenType::kLeftParenthesis){
-    token=lexer_.Next();
+    token=preprocessor_.Next();
     if (IsDeclSpec(token)){
-      lexer_.Rollback(token);
+      preprocessor_.Rollback(token);
       ParseDeclSpec();
     } else if (token.GetType()==TokenType::kIdentifier){
 
     }
   } else{
-    lexer_.Rollback(token);
+    preprocessor_.Rollback(token);
     return ParseUnaryExpr();
   }*/
   return ParseUnaryExpr();
 }
 
 Expr *Parser::ParseUnaryExpr() {
-  Token token = lexer_.Next();
+  Token token = preprocessor_.Next();
   if (token.GetType() == TokenType::kIncrement ||
       token.GetType() == TokenType::kDecrement) {
     return new UnaryExpr(token.GetType(), ParseUnaryExpr());
   } else if (token.GetType() == TokenType::kSizeof) {
-    token = lexer_.Next();
+    token = preprocessor_.Next();
     if (token.GetType() == TokenType::kLeftParenthesis) {
       // TODO(dxy):
 //      ParseTypeName();
     } else {
-      lexer_.Rollback(token);
+      preprocessor_.Rollback(token);
       return new UnaryExpr(TokenType::kSizeof, ParseUnaryExpr());
     }
   } else if (token.GetType() == TokenType::k_Alignof) {
@@ -857,7 +857,7 @@ Expr *Parser::ParseUnaryExpr() {
              token.GetType() == TokenType::kLogicalNot) {
     return new UnaryExpr(token.GetType(), ParseCastExpr());
   } else {
-    lexer_.Rollback(token);
+    preprocessor_.Rollback(token);
     return ParsePostfixExpr();
   }
 }
@@ -877,7 +877,7 @@ Expr *Parser::ParsePostfixExpr() {
 
   Token token;
   int i = 0;
-  while (!(token = lexer_.Next()).Empty()) {
+  while (!(token = preprocessor_.Next()).Empty()) {
     if (token.GetType() == TokenType::kLeftBracket) {  // array
       // check whether the object has been declared
       if (i == 0) {
@@ -901,11 +901,11 @@ Expr *Parser::ParsePostfixExpr() {
       }
 
       // parse parameters
-      token = lexer_.Next();
+      token = preprocessor_.Next();
       if (token.GetType() == TokenType::kRightParenthesis) {
         return new FuncCall(func, FuncCall::ParamList());
       } else {
-        lexer_.Rollback(token);
+        preprocessor_.Rollback(token);
         auto params = ParseList(function([this](int i) {
                                     return ParseAssignExpr();
                                 }),
@@ -930,7 +930,7 @@ Expr *Parser::ParsePostfixExpr() {
                             expr,
                             new Object(new Identifier(nullptr,
                                                       Identifier::Linkage::kNone,
-                                                      ident.GetToken()),
+                                                      Symbol(ident.GetToken())),
                                        0));
     } else if (token.GetType() == TokenType::kIncrement ||
                token.GetType() == TokenType::kDecrement) {
@@ -945,7 +945,7 @@ Expr *Parser::ParsePostfixExpr() {
 
       expr = new UnaryExpr(token.GetType(), expr, true);
     } else {
-      lexer_.Rollback(token);
+      preprocessor_.Rollback(token);
       break;
     }
 
@@ -955,27 +955,27 @@ Expr *Parser::ParsePostfixExpr() {
 }
 
 Expr *Parser::ParsePrimaryExpr() {
-  Token token = lexer_.Next();
+  Token token = preprocessor_.Next();
   if (token.GetType() == TokenType::kIdentifier) {  // object or func call
     // We don't distinguish between object and func call here. It uses a
     // temporary Object to wrap the token so we can use the same return type.
     return new Object(new Identifier(nullptr,
                                      Identifier::Linkage::kNone,
-                                     token.GetToken()),
+                                     Symbol(token.GetToken())),
                       0);
   } else if (token.GetType() == TokenType::kNumber) {
     // Since all floating constants must contain '.' and integer constants
     // contain no '.', we use '.' to distinguish between integer constants
     // and floating constants.
     if (token.GetToken().find('.') == string::npos) {
-      return new Constant(stoi(token.GetToken()));
+      return new Constant(stoi(string(token.GetToken())));
     }
-    return new Constant(stof(token.GetToken()));
+    return new Constant(stof(string(token.GetToken())));
   } else if (token.GetType() == TokenType::kCharacter) {
     return new Constant(token.GetToken()[0]);
   } else if (token.GetType() == TokenType::kString) {
-    return new Constant(
-            string(token.GetToken().begin() + 1, token.GetToken().end() - 1));
+    auto literal = token.GetToken();
+    return new Constant(Symbol(literal.substr(1, literal.size() - 2)));
   } else if (token.GetType() == TokenType::kLeftParenthesis) {
     auto expr = ParseExpr();
     Check(TokenType::kRightParenthesis);
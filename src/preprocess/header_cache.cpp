@@ -0,0 +1,167 @@
+//
+// Created by dxy on 2020/12/18.
+//
+
+#include "preprocess/header_cache.h"
+
+#include <algorithm>
+
+#include "lex/lexer.h"
+
+using namespace CCompiler;
+using namespace std;
+
+namespace {
+/**
+ * @param gap text between two tokens, which is made of white spaces,
+ * comments and characters dropped by the lexer
+ * @return whether a line ends in gap. A new line escaped by a backslash or
+ * in a block comment doesn't end a line.
+ */
+bool EndsLine(string_view gap) {
+  // most gaps are a few spaces
+  if (gap.find('\n') == string_view::npos) {
+    return false;
+  }
+
+  for (size_t i = 0; i < gap.size(); ++i) {
+    if (gap[i] == '\n') {
+      auto last = i;
+      if (last > 0 && gap[last - 1] == '\r') {
+        last--;
+      }
+      if (last == 0 || gap[last - 1] != '\\') {
+        return true;
+      }
+    } else if (gap.substr(i, 2) == "/*") {
+      i = gap.find("*/", i + 2);
+      if (i == string_view::npos) {
+        return false;
+      }
+      i++;
+    } else if (gap.substr(i, 2) == "//") {
+      // the comment ends at the new line, which is checked next
+      i = gap.find('\n', i + 2);
+      if (i == string_view::npos) {
+        return false;
+      }
+      i--;
+    }
+  }
+  return false;
+}
+}
+
+LexedFile::LexedFile(shared_ptr<const SourceBuffer> source, string path)
+        : path_(std::move(path)),
+          tokens_(Lexer(std::move(source)).TokenizeAll()) {
+  auto text = tokens_.GetSource()->GetText();
+  line_starts_.resize(Size());
+  names_.resize(Size());
+  size_t last_end = 0;
+  for (size_t i = 0; i < Size(); ++i) {
+    auto offset = tokens_.GetOffset(i);
+    line_starts_[i] = i == 0 ||
+                      EndsLine(text.substr(last_end, offset - last_end));
+    last_end = offset + tokens_.GetToken(i).size();
+    // keywords can be macro names too
+    if (GetType(i) <= TokenType::kIdentifier) {
+      names_[i] = Symbol(tokens_.GetToken(i));
+    }
+
+    if (line_starts_[i] && GetType(i) == TokenType::kNumberSign) {
+      directives_.push_back(i);
+    }
+  }
+
+  DetectGuard();
+}
+
+size_t LexedFile::LineEnd(size_t i) const {
+  for (i++; i < Size() && !line_starts_[i]; ++i) {}
+  return i;
+}
+
+size_t LexedFile::NextDirective(size_t i) const {
+  auto it = lower_bound(directives_.cbegin(), directives_.cend(), i);
+  return it == directives_.cend() ? Size() : *it;
+}
+
+void LexedFile::DetectGuard() {
+  if (directives_.empty() || directives_.front() != 0) {
+    return;
+  }
+
+  // "#ifndef guard", "#if !defined guard" or "#if !defined(guard)"
+  auto end = LineEnd(0);
+  auto is = [&](size_t i, string_view spelling) {
+      return i < end && GetToken(i) == spelling;
+  };
+  size_t guard = 0;
+  if (is(1, "ifndef") && end == 3) {
+    guard = 2;
+  } else if (is(1, "if") && is(2, "!") && is(3, "defined")) {
+    if (end == 5) {
+      guard = 4;
+    } else if (end == 7 && is(4, "(") && is(6, ")")) {
+      guard = 5;
+    }
+  }
+  if (guard == 0 || GetName(guard).Empty()) {
+    return;
+  }
+
+  // the matching #endif must be on the last line
+  int depth = 0;
+  for (auto directive:directives_) {
+    auto name = GetDirective(directive);
+    if (name == "if" || name == "ifdef" || name == "ifndef") {
+      depth++;
+    } else if (name == "elif" || name == "else") {
+      if (depth == 1) {
+        return;
+      }
+    } else if (name == "endif" && --depth == 0) {
+      if (LineEnd(directive) == Size()) {
+        guard_ = GetName(guard);
+      }
+      return;
+    }
+  }
+}
+
+HeaderCache &HeaderCache::Global() {
+  static HeaderCache cache;
+  return cache;
+}
+
+shared_ptr<const LexedFile> HeaderCache::Get(const string &path) {
+  {
+    lock_guard lock(mutex_);
+    auto it = files_.find(path);
+    if (it != files_.end()) {
+      return it->second;
+    }
+  }
+
+  // lex without the lock, so other threads can get other headers meanwhile
+  shared_ptr<const LexedFile> file;
+  auto source = SourceBuffer::Open(path);
+  if (source != nullptr) {
+    file = make_shared<const LexedFile>(std::move(source), path);
+  }
+
+  lock_guard lock(mutex_);
+  // another thread may have added it, and the first one is kept
+  return files_.emplace(path, std::move(file)).first->second;
+}
+
+size_t HeaderCache::Size() const {
+  lock_guard lock(mutex_);
+  return files_.size();
+}
+
+void HeaderCache::Clear() {
+  lock_guard lock(mutex_);
+  files_.clear();
+}
@@ -0,0 +1,86 @@
+//
+// Created by dxy on 2020/12/19.
+//
+
+#include "preprocess/hide_set.h"
+
+#include <algorithm>
+#include <iterator>
+
+using namespace CCompiler;
+using namespace std;
+
+bool HideSetTable::Contains(uint32_t set, Symbol name) const {
+  auto &names = sets_[set];
+  return binary_search(names.cbegin(), names.cend(), name);
+}
+
+uint32_t HideSetTable::Add(uint32_t set, Symbol name) {
+  auto key = uint64_t(set) << 32 | name.GetId();
+  auto it = adds_.find(key);
+  if (it != adds_.end()) {
+    return it->second;
+  }
+
+  uint32_t id = set;
+  if (!Contains(set, name)) {
+    auto names = sets_[set];
+    names.insert(upper_bound(names.cbegin(), names.cend(), name), name);
+    id = Intern(std::move(names));
+  }
+  adds_.insert({key, id});
+  return id;
+}
+
+uint32_t HideSetTable::Union(uint32_t a, uint32_t b) {
+  if (a == b || b == kEmpty) {
+    return a;
+  }
+  if (a == kEmpty) {
+    return b;
+  }
+  auto key = PairKey(a, b);
+  auto it = unions_.find(key);
+  if (it != unions_.end()) {
+    return it->second;
+  }
+
+  vector<Symbol> names;
+  set_union(sets_[a].cbegin(), sets_[a].cend(),
+            sets_[b].cbegin(), sets_[b].cend(), back_inserter(names));
+  auto id = Intern(std::move(names));
+  unions_.insert({key, id});
+  return id;
+}
+
+uint32_t HideSetTable::Intersect(uint32_t a, uint32_t b) {
+  if (a == b || b == kEmpty) {
+    return b;
+  }
+  if (a == kEmpty) {
+    return a;
+  }
+  auto key = PairKey(a, b);
+  auto it = intersections_.find(key);
+  if (it != intersections_.end()) {
+    return it->second;
+  }
+
+  vector<Symbol> names;
+  set_intersection(sets_[a].cbegin(), sets_[a].cend(),
+                   sets_[b].cbegin(), sets_[b].cend(), back_inserter(names));
+  auto id = Intern(std::move(names));
+  intersections_.insert({key, id});
+  return id;
+}
+
+uint32_t HideSetTable::Intern(vector<Symbol> set) {
+  auto it = ids_.find(set);
+  if (it != ids_.end()) {
+    return it->second;
+  }
+  auto id = static_cast<uint32_t>(sets_.size());
+  sets_.push_back(set);
+  ids_.insert({std::move(set), id});
+  return id;
+}
@@ -0,0 +1,94 @@
+//
+// Created by dxy on 2020/12/19.
+//
+
+#include "preprocess/macro.h"
+
+#include <algorithm>
+
+using namespace CCompiler;
+using namespace std;
+
+namespace {
+/**
+ * @param file
+ * @param i
+ * @return whether token i + 1 follows token i without white spaces
+ */
+bool Adjacent(const LexedFile &file, size_t i) {
+  auto first = file.GetToken(i), second = file.GetToken(i + 1);
+  return first.data() + first.size() == second.data();
+}
+}
+
+Macro::Macro(const LexedFile &file, size_t name, size_t end) : file_(&file) {
+  auto i = name + 1;
+  vector<Symbol> params;
+  if (i < end && file.GetType(i) == TokenType::kLeftParenthesis &&
+      Adjacent(file, name)) {
+    // "()" or "(a, b)" or "(a, ...)"
+    if (++i < end && file.GetType(i) != TokenType::kRightParenthesis) {
+      while (i < end) {
+        if (file.GetType(i) == TokenType::kEllipsis) {
+          params.push_back(Symbol("__VA_ARGS__"));
+          variadic_ = true;
+        } else if (!file.GetName(i).Empty()) {
+          params.push_back(file.GetName(i));
+        } else {
+          exit(-1);
+        }
+        if (++i == end || file.GetType(i) != TokenType::kComma ||
+            variadic_) {
+          break;
+        }
+        i++;
+      }
+    }
+    if (i >= end || file.GetType(i) != TokenType::kRightParenthesis) {
+      exit(-1);
+    }
+    i++;
+    param_count_ = static_cast<int>(params.size());
+  }
+
+  auto find_param = [&](size_t j) {
+      auto it = find(params.cbegin(), params.cend(), file.GetName(j));
+      return file.GetName(j).Empty() || it == params.cend()
+             ? -1 : static_cast<int>(it - params.cbegin());
+  };
+  for (; i < end; ++i) {
+    auto param = find_param(i);
+    if (file.GetType(i) != TokenType::kNumberSign) {
+      body_.push_back({param < 0 ? ItemType::kToken : ItemType::kParam,
+                       static_cast<uint32_t>(param < 0 ? i : param)});
+    } else if (i + 1 < end && file.GetType(i + 1) == TokenType::kNumberSign &&
+               Adjacent(file, i)) {
+      // "##" is between two items
+      if (body_.empty() || body_.back().type == ItemType::kPaste ||
+          i + 2 == end) {
+        exit(-1);
+      }
+      body_.push_back({ItemType::kPaste, 0});
+      i++;
+    } else if (IsFunctionLike()) {
+      // '#' must be followed by a parameter
+      param = i + 1 < end ? find_param(i + 1) : -1;
+      if (param < 0) {
+        exit(-1);
+      }
+      body_.push_back({ItemType::kStringize, static_cast<uint32_t>(param)});
+      i++;
+    } else {
+      body_.push_back({ItemType::kToken, static_cast<uint32_t>(i)});
+    }
+  }
+
+  // arguments next to "##" aren't expanded
+  for (size_t k = 0; k < body_.size(); ++k) {
+    if (body_[k].type == ItemType::kParam &&
+        ((k > 0 && body_[k - 1].type == ItemType::kPaste) ||
+         (k + 1 < body_.size() && body_[k + 1].type == ItemType::kPaste))) {
+      body_[k].type = ItemType::kRawParam;
+    }
+  }
+}
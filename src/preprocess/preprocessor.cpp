@@ -0,0 +1,790 @@
+//
+// Created by dxy on 2020/12/18.
+//
+
+#include "preprocess/preprocessor.h"
+
+#include <charconv>
+#include <filesystem>
+#include <iterator>
+#include <optional>
+
+#include "lex/lexer.h"
+
+using namespace CCompiler;
+using namespace std;
+
+namespace {
+/**
+ * Evaluate the tokens of a #if whose "defined" operators have been replaced
+ * by 1 or 0 and whose macros have been expanded. Identifiers left are 0.
+ */
+class ConditionEvaluator {
+ public:
+  explicit ConditionEvaluator(const vector<Token> &tokens) : tokens_(tokens) {}
+
+  /**
+   * @return If the tokens aren't an integer constant expression, it returns
+   * nullopt.
+   */
+  optional<intmax_t> Evaluate() {
+    auto value = ParseConditional(true);
+    if (i_ != tokens_.size()) {
+      return nullopt;
+    }
+    return value;
+  }
+
+ private:
+  /**
+   * Operands that aren't evaluated, like the right operand of "0 &&", are
+   * parsed with live false, so dividing by 0 there isn't an error.
+   *
+   * @param live whether the value is used
+   * @return
+   */
+  optional<intmax_t> ParseConditional(bool live) {
+    auto condition = ParseBinary(1, live);
+    if (!condition || !Accept(TokenType::kQuestion)) {
+      return condition;
+    }
+
+    auto first = ParseConditional(live && *condition != 0);
+    if (!first || !Accept(TokenType::kColon)) {
+      return nullopt;
+    }
+    auto second = ParseConditional(live && *condition == 0);
+    if (!second) {
+      return nullopt;
+    }
+    return *condition != 0 ? first : second;
+  }
+
+  /**
+   * @param min_precedence
+   * @param live
+   * @return the value of binary operators whose precedence isn't less than
+   * min_precedence
+   */
+  optional<intmax_t> ParseBinary(int min_precedence, bool live) {
+    auto left = ParseUnary(live);
+    while (left && i_ != tokens_.size()) {
+      auto type = tokens_[i_].GetType();
+      auto precedence = GetPrecedence(type);
+      if (precedence < min_precedence) {
+        break;
+      }
+      i_++;
+
+      auto right_live = live &&
+                        !(type == TokenType::kLogicalAnd && *left == 0) &&
+                        !(type == TokenType::kLogicalOr && *left != 0);
+      auto right = ParseBinary(precedence + 1, right_live);
+      if (!right) {
+        return nullopt;
+      }
+      left = Apply(type, *left, *right, right_live);
+    }
+    return left;
+  }
+
+  optional<intmax_t> ParseUnary(bool live) {
+    if (i_ == tokens_.size()) {
+      return nullopt;
+    }
+
+    auto token = tokens_[i_++];
+    optional<intmax_t> value;
+    switch (token.GetType()) {
+      case TokenType::kLeftParenthesis:
+        value = ParseConditional(live);
+        if (!Accept(TokenType::kRightParenthesis)) {
+          return nullopt;
+        }
+        return value;
+      case TokenType::kLogicalNot:
+        value = ParseUnary(live);
+        return value ? optional<intmax_t>(*value == 0) : nullopt;
+      case TokenType::kMinus:
+        value = ParseUnary(live);
+        return value ? optional<intmax_t>(0 - static_cast<uintmax_t>(*value))
+                     : nullopt;
+      case TokenType::kPlus:
+        return ParseUnary(live);
+      case TokenType::kTilde:
+        value = ParseUnary(live);
+        return value ? optional<intmax_t>(~*value) : nullopt;
+      case TokenType::kNumber:
+        return ParseNumber(token.GetToken());
+      case TokenType::kCharacter:
+        return ParseCharacter(token.GetToken());
+      default:
+        // keywords are identifiers to the preprocessor
+        if (token.GetType() <= TokenType::kIdentifier) {
+          return 0;
+        }
+        return nullopt;
+    }
+  }
+
+  bool Accept(TokenType type) {
+    if (i_ != tokens_.size() && tokens_[i_].GetType() == type) {
+      i_++;
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * @param type
+   * @return the precedence of a binary operator starting from 1 for "||",
+   * or 0 if it isn't a binary operator
+   */
+  static int GetPrecedence(TokenType type) {
+    switch (type) {
+      case TokenType::kAsterisk:
+      case TokenType::kDivide:
+      case TokenType::kModulo:
+        return 10;
+      case TokenType::kPlus:
+      case TokenType::kMinus:
+        return 9;
+      case TokenType::kLeftShift:
+      case TokenType::kRightShift:
+        return 8;
+      case TokenType::kLess:
+      case TokenType::kMore:
+      case TokenType::kLessEqual:
+      case TokenType::kMoreEqual:
+        return 7;
+      case TokenType::kEqual:
+      case TokenType::kNotEqual:
+        return 6;
+      case TokenType::kBitAnd:
+        return 5;
+      case TokenType::kBitXor:
+        return 4;
+      case TokenType::kBitOr:
+        return 3;
+      case TokenType::kLogicalAnd:
+        return 2;
+      case TokenType::kLogicalOr:
+        return 1;
+      default:
+        return 0;
+    }
+  }
+
+  /**
+   * Arithmetic wraps around instead of overflowing.
+   *
+   * @param type a binary operator
+   * @param left
+   * @param right
+   * @param live
+   * @return If a live operand is divided by 0, it returns nullopt.
+   */
+  static optional<intmax_t> Apply(TokenType type, intmax_t left,
+                                  intmax_t right, bool live) {
+    auto u_left = static_cast<uintmax_t>(left);
+    auto u_right = static_cast<uintmax_t>(right);
+    switch (type) {
+      case TokenType::kAsterisk:
+        return static_cast<intmax_t>(u_left * u_right);
+      case TokenType::kDivide:
+      case TokenType::kModulo:
+        if (right == 0) {
+          return live ? nullopt : optional<intmax_t>(0);
+        }
+        if (right == -1) {  // INTMAX_MIN / -1 overflows
+          return type == TokenType::kDivide
+                 ? static_cast<intmax_t>(0 - u_left) : 0;
+        }
+        return type == TokenType::kDivide ? left / right : left % right;
+      case TokenType::kPlus:
+        return static_cast<intmax_t>(u_left + u_right);
+      case TokenType::kMinus:
+        return static_cast<intmax_t>(u_left - u_right);
+      case TokenType::kLeftShift:
+        return u_right < 64 ? static_cast<intmax_t>(u_left << u_right) : 0;
+      case TokenType::kRightShift:
+        return u_right < 64 ? left >> u_right : (left < 0 ? -1 : 0);
+      case TokenType::kLess:
+        return left < right;
+      case TokenType::kMore:
+        return left > right;
+      case TokenType::kLessEqual:
+        return left <= right;
+      case TokenType::kMoreEqual:
+        return left >= right;
+      case TokenType::kEqual:
+        return left == right;
+      case TokenType::kNotEqual:
+        return left != right;
+      case TokenType::kBitAnd:
+        return left & right;
+      case TokenType::kBitXor:
+        return left ^ right;
+      case TokenType::kBitOr:
+        return left | right;
+      case TokenType::kLogicalAnd:
+        return left != 0 && right != 0;
+      case TokenType::kLogicalOr:
+        return left != 0 || right != 0;
+      default:
+        return nullopt;
+    }
+  }
+
+  /**
+   * @param number like "0x1fu" or "017"
+   * @return
+   */
+  static optional<intmax_t> ParseNumber(string_view number) {
+    while (!number.empty() && (number.back() == 'u' || number.back() == 'U' ||
+                               number.back() == 'l' || number.back() == 'L')) {
+      number.remove_suffix(1);
+    }
+    int base = 10;
+    if (number.size() > 2 && (number.substr(0, 2) == "0x" ||
+                              number.substr(0, 2) == "0X")) {
+      base = 16;
+      number.remove_prefix(2);
+    } else if (number.size() > 1 && number[0] == '0') {
+      base = 8;
+    }
+
+    uintmax_t value;
+    auto end = number.data() + number.size();
+    auto result = from_chars(number.data(), end, value, base);
+    if (result.ec != errc() || result.ptr != end) {
+      return nullopt;  // like a floating number
+    }
+    return static_cast<intmax_t>(value);
+  }
+
+  /**
+   * @param character like 'a' or '\n'
+   * @return
+   */
+  static optional<intmax_t> ParseCharacter(string_view character) {
+    auto s = character.substr(1, character.size() - 2);
+    if (s.empty()) {
+      return nullopt;
+    }
+    if (s[0] != '\\') {
+      return static_cast<unsigned char>(s[0]);
+    }
+    if (s.size() < 2) {
+      return nullopt;
+    }
+
+    unsigned value = 0;
+    switch (s[1]) {
+      case 'a':
+        return '\a';
+      case 'b':
+        return '\b';
+      case 'f':
+        return '\f';
+      case 'n':
+        return '\n';
+      case 'r':
+        return '\r';
+      case 't':
+        return '\t';
+      case 'v':
+        return '\v';
+      case 'x':
+        from_chars(s.data() + 2, s.data() + s.size(), value, 16);
+        return static_cast<unsigned char>(value);
+      default:
+        if (s[1] >= '0' && s[1] <= '7') {
+          from_chars(s.data() + 1, s.data() + s.size(), value, 8);
+          return static_cast<unsigned char>(value);
+        }
+        return static_cast<unsigned char>(s[1]);
+    }
+  }
+
+  const vector<Token> &tokens_;
+  size_t i_{0};
+};
+}
+
+Preprocessor::Preprocessor(shared_ptr<const SourceBuffer> source, string path,
+                           vector<string> include_dirs, HeaderCache &cache)
+        : cache_(&cache),
+          include_dirs_(std::move(include_dirs)) {
+  auto file = make_shared<const LexedFile>(std::move(source),
+                                           std::move(path));
+  files_.insert(file);
+  frames_.push_back({file, 0, 0});
+}
+
+Token Preprocessor::Next() {
+  if (tokens_.empty()) {
+    return NextToken();
+  } else {
+    auto token = tokens_.front();
+    tokens_.erase(tokens_.cbegin());
+    return token;
+  }
+}
+
+Token Preprocessor::Peek() {
+  auto token = NextToken();
+  if (!token.Empty()) {
+    tokens_.push_back(token);
+  }
+  return token;
+}
+
+void Preprocessor::Rollback(const Token &token) {
+  tokens_.insert(tokens_.cbegin(), token);
+}
+
+Token Preprocessor::NextToken() {
+  while (true) {
+    auto token = NextUnexpanded();
+    if (!Expand(token)) {
+      return token.token;
+    }
+  }
+}
+
+Preprocessor::MacroToken Preprocessor::NextUnexpanded() {
+  if (pending_.size() > pending_floor_) {
+    auto token = pending_.back();
+    pending_.pop_back();
+    return token;
+  }
+  if (expanding_all_) {
+    return MacroToken();
+  }
+  return ReadToken();
+}
+
+Preprocessor::MacroToken Preprocessor::ReadToken() {
+  while (!frames_.empty()) {
+    auto &frame = frames_.back();
+    auto &file = *frame.file;
+    if (Skipping()) {
+      // only directives can end a skipped group
+      frame.index = file.NextDirective(frame.index);
+    }
+
+    if (frame.index == file.Size()) {
+      if (conditionals_.size() != frame.conditional_depth) {
+        exit(-1);  // lack of #endif
+      }
+      frames_.pop_back();
+    } else if (file.AtLineStart(frame.index) &&
+               file.GetType(frame.index) == TokenType::kNumberSign) {
+      RunDirective();
+    } else {
+      auto i = frame.index++;
+      return {file.At(i), file.GetName(i), HideSetTable::kEmpty};
+    }
+  }
+  return MacroToken();
+}
+
+bool Preprocessor::Expand(const MacroToken &token) {
+  if (token.name.Empty()) {
+    return false;
+  }
+  auto it = macros_.find(token.name);
+  if (it == macros_.end() || hide_sets_.Contains(token.hide_set, token.name)) {
+    return false;
+  }
+
+  // a directive among the arguments may undefine or redefine the macro
+  auto macro = it->second;
+  if (!macro.IsFunctionLike()) {
+    Substitute(macro, {}, {}, hide_sets_.Add(token.hide_set, token.name));
+    return true;
+  }
+
+  // the name of a function-like macro without '(' isn't a call
+  auto next = NextUnexpanded();
+  if (next.token.GetType() != TokenType::kLeftParenthesis) {
+    if (!next.token.Empty()) {
+      pending_.push_back(next);
+    }
+    return false;
+  }
+
+  // split arguments by the commas out of parentheses, but the variadic
+  // argument takes all commas left
+  auto param_count = static_cast<size_t>(macro.GetParamCount());
+  vector<MacroToken> tokens;
+  vector<Argument> args;
+  size_t begin = 0;
+  int depth = 0;
+  while (true) {
+    next = NextUnexpanded();
+    auto type = next.token.GetType();
+    if (next.token.Empty()) {
+      exit(-1);  // lack of ')'
+    }
+    if (depth == 0 && (type == TokenType::kRightParenthesis ||
+                       (type == TokenType::kComma &&
+                        !(macro.IsVariadic() &&
+                          args.size() + 1 == param_count)))) {
+      args.emplace_back(begin, tokens.size());
+      begin = tokens.size();
+      if (type == TokenType::kRightParenthesis) {
+        break;
+      }
+      continue;
+    }
+
+    if (type == TokenType::kLeftParenthesis) {
+      depth++;
+    } else if (type == TokenType::kRightParenthesis) {
+      depth--;
+    }
+    tokens.push_back(next);
+  }
+
+  // "()" passes an empty argument, which is no argument for f(), and the
+  // variadic argument may be left out
+  if (param_count == 0 && args.size() == 1 && tokens.empty()) {
+    args.clear();
+  } else if (macro.IsVariadic() && args.size() + 1 == param_count) {
+    args.emplace_back(tokens.size(), tokens.size());
+  }
+  if (args.size() != param_count) {
+    exit(-1);
+  }
+
+  // names hiding both the name and ')' still hide the expansion
+  auto hide_set = hide_sets_.Add(
+          hide_sets_.Intersect(token.hide_set, next.hide_set), token.name);
+  Substitute(macro, tokens, args, hide_set);
+  return true;
+}
+
+void Preprocessor::Substitute(const Macro &macro,
+                              const vector<MacroToken> &tokens,
+                              const vector<Argument> &args,
+                              uint32_t hide_set) {
+  auto &file = macro.GetFile();
+  // arguments are expanded on their first use and then reused
+  vector<MacroToken> expanded;
+  vector<optional<Argument>> expanded_args(args.size());
+
+  vector<MacroToken> result;
+  // where the tokens of the last item begin
+  size_t item_begin = 0;
+  auto &body = macro.GetBody();
+  for (size_t k = 0; k < body.size(); ++k) {
+    auto paste = body[k].type == Macro::ItemType::kPaste;
+    auto item = body[paste ? ++k : k];
+    auto begin = result.size();
+    auto arg_begin = item.type == Macro::ItemType::kToken
+                     ? nullptr : tokens.data() + args[item.index].first;
+    auto arg_end = item.type == Macro::ItemType::kToken
+                   ? nullptr : tokens.data() + args[item.index].second;
+    switch (item.type) {
+      case Macro::ItemType::kToken:
+        result.push_back({file.At(item.index), file.GetName(item.index),
+                          HideSetTable::kEmpty});
+        break;
+      case Macro::ItemType::kParam: {
+        auto &arg = expanded_args[item.index];
+        if (!arg) {
+          auto expanded_begin = expanded.size();
+          ExpandAll(arg_begin, arg_end, expanded);
+          arg = Argument(expanded_begin, expanded.size());
+        }
+        result.insert(result.cend(), expanded.cbegin() + arg->first,
+                      expanded.cbegin() + arg->second);
+        break;
+      }
+      case Macro::ItemType::kRawParam:
+        result.insert(result.cend(), arg_begin, arg_end);
+        break;
+      case Macro::ItemType::kStringize:
+        result.push_back(Stringize(arg_begin, arg_end));
+        break;
+      default:
+        break;
+    }
+
+    if (!paste) {
+      item_begin = begin;
+    } else if (begin != item_begin && begin != result.size()) {
+      // paste the tokens around "##" unless either side is an empty argument
+      result[begin - 1] = Paste(result[begin - 1], result[begin]);
+      result.erase(result.cbegin() + begin);
+    }
+  }
+
+  for (auto &token:result) {
+    token.hide_set = hide_sets_.Union(token.hide_set, hide_set);
+  }
+  // the first token is read first
+  pending_.insert(pending_.cend(), result.crbegin(), result.crend());
+}
+
+void Preprocessor::ExpandAll(const MacroToken *begin, const MacroToken *end,
+                             vector<MacroToken> &expanded) {
+  auto pending_floor = pending_floor_;
+  auto expanding_all = expanding_all_;
+  pending_floor_ = pending_.size();
+  expanding_all_ = true;
+
+  pending_.insert(pending_.cend(), make_reverse_iterator(end),
+                  make_reverse_iterator(begin));
+  while (pending_.size() > pending_floor_) {
+    auto token = NextUnexpanded();
+    if (!Expand(token)) {
+      expanded.push_back(token);
+    }
+  }
+
+  pending_floor_ = pending_floor;
+  expanding_all_ = expanding_all;
+}
+
+Preprocessor::MacroToken Preprocessor::Stringize(const MacroToken *begin,
+                                                 const MacroToken *end) {
+  string spelling = "\"";
+  for (auto it = begin; it != end; ++it) {
+    auto token = it->token.GetToken();
+    // white spaces between tokens become a space
+    if (it != begin) {
+      auto last = (it - 1)->token.GetToken();
+      if (last.data() + last.size() != token.data()) {
+        spelling += ' ';
+      }
+    }
+
+    auto literal = it->token.GetType() == TokenType::kString ||
+                   it->token.GetType() == TokenType::kCharacter;
+    for (auto c:token) {
+      if (literal && (c == '"' || c == '\\')) {
+        spelling += '\\';
+      }
+      spelling += c;
+    }
+  }
+  spelling += '"';
+
+  // the symbol table keeps the spelling
+  return {Token(Symbol(spelling).GetSpelling(), TokenType::kString), Symbol(),
+          HideSetTable::kEmpty};
+}
+
+Preprocessor::MacroToken Preprocessor::Paste(const MacroToken &left,
+                                             const MacroToken &right) {
+  auto spelling = string(left.token.GetToken()) +
+                  string(right.token.GetToken());
+  if (spelling == "##") {
+    // '#' pasted with '#' isn't a token of the lexer. Operators are found
+    // when a macro is defined, so it is never an operator when rescanned.
+    return {Token(Symbol(spelling).GetSpelling(), TokenType::kNumberSign),
+            Symbol(), left.hide_set};
+  }
+  // only the new spelling is lexed
+  auto token = Lexer(spelling).Next();
+  if (token.GetToken().size() != spelling.size()) {
+    exit(-1);  // not a token
+  }
+
+  auto symbol = Symbol(spelling);
+  auto type = token.GetType();
+  return {Token(symbol.GetSpelling(), type),
+          type <= TokenType::kIdentifier ? symbol : Symbol(), left.hide_set};
+}
+
+void Preprocessor::RunDirective() {
+  // the frame may be popped or moved by an #include
+  auto file = frames_.back().file;
+  auto begin = frames_.back().index;
+  auto end = file->LineEnd(begin);
+  auto conditional_depth = frames_.back().conditional_depth;
+  frames_.back().index = end;
+
+  auto name = file->GetDirective(begin);
+  // tokens after the name of the directive
+  auto args = begin + 2;
+  if (name == "if" || name == "ifdef" || name == "ifndef") {
+    if (Skipping()) {
+      // groups in a skipped group are skipped in whole
+      conditionals_.push_back({false, true, false});
+      return;
+    }
+    bool value;
+    if (name == "if") {
+      value = Evaluate(*file, args, end);
+    } else {
+      value = IsDefined(GetMacroName(*file, args, end)) == (name == "ifdef");
+    }
+    conditionals_.push_back({value, value, false});
+  } else if (name == "elif" || name == "else" || name == "endif") {
+    if (conditionals_.size() == conditional_depth) {
+      exit(-1);  // lack of #if
+    }
+    auto &conditional = conditionals_.back();
+    if (name == "endif") {
+      conditionals_.pop_back();
+    } else if (conditional.seen_else) {
+      exit(-1);  // a group after #else
+    } else {
+      conditional.taking = !conditional.taken &&
+                           (name == "else" || Evaluate(*file, args, end));
+      conditional.taken |= conditional.taking;
+      conditional.seen_else = name == "else";
+    }
+  } else if (Skipping()) {
+    return;
+  } else if (name == "include") {
+    Include(*file, args, end);
+  } else if (name == "define") {
+    macros_.insert_or_assign(GetMacroName(*file, args, end),
+                             Macro(*file, args, end));
+  } else if (name == "undef") {
+    macros_.erase(GetMacroName(*file, args, end));
+  } else if (name == "pragma") {
+    if (args < end && file->GetToken(args) == "once") {
+      once_files_.insert(file.get());
+    }
+  } else if (name == "error") {
+    exit(-1);
+  }
+  // other directives like #line and the null directive are ignored
+}
+
+void Preprocessor::Include(const LexedFile &file, size_t begin, size_t end) {
+  // "name" is a string, and <name> is lexed as tokens between '<' and '>'
+  string_view name;
+  string expanded_name;
+  bool quoted = false;
+  if (end - begin == 1 && file.GetType(begin) == TokenType::kString) {
+    name = file.GetToken(begin);
+    name = name.substr(1, name.size() - 2);
+    quoted = true;
+  } else if (end - begin >= 3 && file.GetType(begin) == TokenType::kLess &&
+             file.GetType(end - 1) == TokenType::kMore) {
+    auto first = file.GetToken(begin), last = file.GetToken(end - 1);
+    name = string_view(first.data() + 1, last.data() - first.data() - 1);
+  } else {
+    // #include MACRO, which must expand to one of the forms above
+    vector<MacroToken> tokens, expanded;
+    for (auto i = begin; i < end; ++i) {
+      tokens.push_back({file.At(i), file.GetName(i), HideSetTable::kEmpty});
+    }
+    ExpandAll(tokens.data(), tokens.data() + tokens.size(), expanded);
+    if (expanded.size() == 1 &&
+        expanded[0].token.GetType() == TokenType::kString) {
+      name = expanded[0].token.GetToken();
+      name = name.substr(1, name.size() - 2);
+      quoted = true;
+    } else if (expanded.size() >= 3 &&
+               expanded.front().token.GetType() == TokenType::kLess &&
+               expanded.back().token.GetType() == TokenType::kMore) {
+      // the spellings between '<' and '>', where white spaces become a space
+      for (auto it = expanded.cbegin() + 1; it + 1 != expanded.cend(); ++it) {
+        auto last = (it - 1)->token.GetToken(), token = it->token.GetToken();
+        if (it != expanded.cbegin() + 1 &&
+            last.data() + last.size() != token.data()) {
+          expanded_name += ' ';
+        }
+        expanded_name += token;
+      }
+      name = expanded_name;
+    } else {
+      exit(-1);
+    }
+  }
+
+  auto header = FindHeader(file, name, quoted);
+  if (header == nullptr) {
+    exit(-1);  // the header isn't found
+  }
+
+  // the header would expand to nothing
+  if (once_files_.count(header.get()) != 0 ||
+      (!header->GetGuard().Empty() && IsDefined(header->GetGuard()))) {
+    skipped_include_count_++;
+    return;
+  }
+  if (frames_.size() >= kMaxIncludeDepth) {
+    exit(-1);
+  }
+  files_.insert(header);
+  frames_.push_back({std::move(header), 0, conditionals_.size()});
+}
+
+shared_ptr<const LexedFile> Preprocessor::FindHeader(
+        const LexedFile &includer, string_view name, bool quoted) {
+  filesystem::path header(name);
+  if (header.is_absolute()) {
+    return cache_->Get(header.lexically_normal().string());
+  }
+
+  if (quoted) {
+    auto directory = filesystem::path(includer.GetPath()).parent_path();
+    auto file = cache_->Get((directory / header).lexically_normal().string());
+    if (file != nullptr) {
+      return file;
+    }
+  }
+  for (auto &directory:include_dirs_) {
+    auto file = cache_->Get(
+            (filesystem::path(directory) / header).lexically_normal().string());
+    if (file != nullptr) {
+      return file;
+    }
+  }
+  return nullptr;
+}
+
+bool Preprocessor::Evaluate(const LexedFile &file, size_t begin,
+                            size_t end) {
+  // replace "defined name" and "defined(name)" by 1 or 0 before expansion
+  vector<MacroToken> tokens;
+  for (auto i = begin; i < end; ++i) {
+    if (file.GetToken(i) != "defined") {
+      tokens.push_back({file.At(i), file.GetName(i), HideSetTable::kEmpty});
+      continue;
+    }
+
+    bool parenthesis = i + 1 < end &&
+                       file.GetType(i + 1) == TokenType::kLeftParenthesis;
+    auto name = GetMacroName(file, i + 1 + parenthesis, end);
+    if (parenthesis && (i + 3 >= end ||
+                        file.GetType(i + 3) != TokenType::kRightParenthesis)) {
+      exit(-1);
+    }
+    tokens.push_back({Token(IsDefined(name) ? "1" : "0", TokenType::kNumber),
+                      Symbol(), HideSetTable::kEmpty});
+    i += 1 + 2 * parenthesis;
+  }
+
+  vector<MacroToken> expanded;
+  ExpandAll(tokens.data(), tokens.data() + tokens.size(), expanded);
+  vector<Token> condition;
+  condition.reserve(expanded.size());
+  for (auto &token:expanded) {
+    condition.push_back(token.token);
+  }
+
+  auto value = ConditionEvaluator(condition).Evaluate();
+  if (!value) {
+    exit(-1);  // not an integer constant expression
+  }
+  return *value != 0;
+}
+
+Symbol Preprocessor::GetMacroName(const LexedFile &file, size_t i,
+                                  size_t end) {
+  // keywords can be macro names too
+  if (i >= end || file.GetName(i).Empty()) {
+    exit(-1);
+  }
+  return file.GetName(i);
+}
@@ -0,0 +1,116 @@
+//
+// Created by dxy on 2020/12/16.
+//
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include "bench_util.h"
+#include "environment.h"
+#include "lex/dfa.h"
+#include "lex/lazy_dfa.h"
+#include "lex/lexer.h"
+#include "lex/nfa.h"
+#include "lex/scanner.h"
+#include "lex/token.h"
+
+using namespace CCompiler;
+using namespace std;
+
+/**
+ * Pathological inputs for the regex engines. Every case is run on an input
+ * and on one kGrowth times as long, and the time must at most grow
+ * kMaxScaling times. It is twice the growth of linear time and half of
+ * quadratic time, so short runs with noisy timing don't fail.
+ */
+const int kGrowth = 4;
+const double kMaxScaling = 8.0;
+
+/**
+ * @tparam F
+ * @param run run(size) builds an input of size bytes and matches it
+ * @param size
+ * @return the ratio of the time for kGrowth * size bytes to the time for
+ * size bytes. Each time is the best of a few runs.
+ */
+template<class F>
+double Scaling(F run, size_t size) {
+  const int kRounds = 3;
+  auto best_seconds = [&](size_t bytes) {
+      double best = 1e9;
+      for (int i = 0; i < kRounds; ++i) {
+        best = min(best, Seconds([&]() { run(bytes); }));
+      }
+      cout << bytes << " bytes MB/s: " << bytes / best / 1e6 << endl;
+      return best;
+  };
+  return best_seconds(kGrowth * size) / best_seconds(size);
+}
+
+TEST(AdversarialBench, LongIdentifier) {
+  Nfa nfa(Environment::GetRegexRules());
+  Dfa dfa(nfa);
+  LazyDfa lazy_dfa(nfa);
+
+  auto match = [&](auto &engine) {
+      return [&](size_t size) {
+          string identifier(size, 'a');
+          string_view s(identifier);
+          auto accept = engine.NextMatch(s.cbegin(), s.cend());
+          EXPECT_TRUE(accept && accept->second == s.cend());
+      };
+  };
+  cout << "Nfa" << endl;
+  EXPECT_LT(Scaling(match(nfa), 1 << 16), kMaxScaling);
+  cout << "Dfa" << endl;
+  EXPECT_LT(Scaling(match(dfa), 1 << 20), kMaxScaling);
+  cout << "LazyDfa" << endl;
+  EXPECT_LT(Scaling(match(lazy_dfa), 1 << 20), kMaxScaling);
+}
+
+TEST(AdversarialBench, NestedQuantifiers) {
+  // a backtracking engine takes exponential time on these
+  map<string, TokenType> rules{{"(?:a*)*b",         TokenType::kIdentifier},
+                               {"(?:a|aa)*c",       TokenType::kNumber},
+                               {"(?:(?:a+)+a)+d",   TokenType::kString}};
+  Nfa nfa(rules);
+
+  cout << "Nfa" << endl;
+  EXPECT_LT(Scaling([&](size_t size) {
+      string text(size, 'a');
+      string_view s(text);
+      auto accept = nfa.NextMatch(s.cbegin(), s.cend());
+      EXPECT_EQ(accept, nullptr);
+  }, 1 << 14), kMaxScaling);
+
+  // every location begins a scan to the end of the input
+  cout << "Scanner" << endl;
+  Scanner scanner(rules);
+  EXPECT_LT(Scaling([&](size_t size) {
+      EXPECT_TRUE(scanner.FindAll(string(size, 'a')).empty());
+  }, 1 << 14), kMaxScaling);
+}
+
+TEST(AdversarialBench, LongRuns) {
+  Environment::EnvironmentInit();
+  auto count_tokens = [](const string &source) {
+      Lexer lexer(source);
+      int tokens = 0;
+      while (!lexer.Next().Empty()) {
+        tokens++;
+      }
+      return tokens;
+  };
+
+  cout << "white spaces" << endl;
+  EXPECT_LT(Scaling([&](size_t size) {
+      EXPECT_EQ(count_tokens("int" + string(size, ' ') + "a;"), 3);
+  }, 1 << 20), kMaxScaling);
+
+  // digits in the quantified group of the number rule, which is accepting
+  // after every digit, so the scan never backtracks
+  cout << "numbers" << endl;
+  EXPECT_LT(Scaling([&](size_t size) {
+      EXPECT_EQ(count_tokens(string(size, '1') + "e+;"), 4);
+  }, 1 << 20), kMaxScaling);
+}
@@ -0,0 +1,151 @@
+//
+// Created by dxy on 2020/12/4.
+//
+
+#ifndef CCOMPILER_BENCH_UTIL_H
+#define CCOMPILER_BENCH_UTIL_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#ifdef __linux__
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#endif
+
+#ifdef __GLIBC__
+
+#include <malloc.h>
+
+#endif
+
+namespace CCompiler {
+/**
+ * Generate a C source in the style of test/source.c. It is made up of small
+ * functions with declarations, loops, comments and literals.
+ *
+ * @param bytes minimum size of the generated source
+ * @return
+ */
+inline std::string GenerateSource(std::size_t bytes) {
+  std::string source;
+  for (int i = 0; source.size() < bytes; ++i) {
+    auto n = std::to_string(i);
+    source += "//\n"
+              "// Created by dxy on 2020/8/27.\n"
+              "//\n"
+              "int func_" + n + "(int arg_" + n + ", char *name) {\n"
+              "  int res = 0x" + n + "u;  /* result */\n"
+              "  for (int i = 0; i < " + n + "; ++i) {\n"
+              "    res += arg_" + n + " * i - (res >> 2);\n"
+              "  }\n"
+              "  if (res != 0 && name[0] == 'a') {\n"
+              "    return res;\n"
+              "  }\n"
+              "  const char *s = \"func_" + n + "\";\n"
+              "  return 0;\n"
+              "}\n";
+  }
+  return source;
+}
+
+/**
+ * @tparam F
+ * @param f
+ * @return seconds spent on calling f
+ */
+template<class F>
+double Seconds(F f) {
+  auto begin = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - begin).count();
+}
+
+/**
+ * @return bytes of heap memory in use or 0 if it is unknown. Large blocks
+ * allocated by mmap() are included.
+ */
+inline std::size_t HeapBytes() {
+#ifdef __GLIBC__
+  auto info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+#else
+  return 0;
+#endif
+}
+
+/**
+ * Count hardware cache misses of the current thread with perf_event_open().
+ * It is only available on Linux and may be forbidden by the kernel, so
+ * callers should check Available() before reading the result.
+ */
+class CacheMissCounter {
+ public:
+  CacheMissCounter() {
+#ifdef __linux__
+    perf_event_attr attr{};
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+  }
+
+  CacheMissCounter(const CacheMissCounter &) = delete;
+
+  CacheMissCounter &operator=(const CacheMissCounter &) = delete;
+
+  ~CacheMissCounter() {
+#ifdef __linux__
+    if (fd_ != -1) {
+      close(fd_);
+    }
+#endif
+  }
+
+  [[nodiscard]] bool Available() const {
+    return fd_ != -1;
+  }
+
+  /**
+   * @tparam F
+   * @param f
+   * @return cache misses when calling f or 0 if the counter is unavailable
+   */
+  template<class F>
+  std::uint64_t Count(F f) {
+    if (!Available()) {
+      f();
+      return 0;
+    }
+
+    std::uint64_t count = 0;
+#ifdef __linux__
+    ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    f();
+    ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd_, &count, sizeof(count)) != sizeof(count)) {
+      count = 0;
+    }
+#endif
+    return count;
+  }
+
+ private:
+  int fd_{-1};
+};
+}
+
+#endif // CCOMPILER_BENCH_UTIL_H
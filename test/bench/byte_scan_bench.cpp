@@ -0,0 +1,76 @@
+//
+// Created by dxy on 2020/12/12.
+//
+
+#include "gtest/gtest.h"
+#include "lex/byte_scan.h"
+
+#include "bench_util.h"
+#include "environment.h"
+#include "lex/lexer.h"
+#include "lex/token.h"
+
+using namespace CCompiler;
+using namespace std;
+
+/**
+ * Generate a source in the style of vendored headers, where most bytes are
+ * in comments and indentation.
+ *
+ * @param bytes minimum size of the generated source
+ * @return
+ */
+string GenerateHeader(size_t bytes) {
+  string source;
+  for (int i = 0; source.size() < bytes; ++i) {
+    auto n = to_string(i);
+    source += "/**\n"
+              " * Return the value of the field " + n + " of the object. The\n"
+              " * returned value is only valid until the next call, so copy\n"
+              " * it if it should be kept. See the manual for details.\n"
+              " */\n"
+              "extern                      int\n"
+              "                            get_field_" + n + "(void *object);"
+              "  // may be inlined\n\n";
+  }
+  return source;
+}
+
+TEST(ByteScanBench, SkipRanges) {
+  auto ranges = ByteRanges::FromRanges({{'0', '9'},
+                                        {'A', 'Z'},
+                                        {'_', '_'},
+                                        {'a', 'z'}});
+  string text(1 << 24, 'a');
+  string_view s(text);
+  vector<pair<SimdLevel, string>> levels{{SimdLevel::kScalar, "scalar"},
+                                         {SimdLevel::kSse2,   "sse2"},
+                                         {SimdLevel::kAvx2,   "avx2"}};
+
+  for (auto &[level, name]:levels) {
+    if (level > BestSimdLevel()) {
+      continue;
+    }
+    StrConstIt result{};
+    auto seconds = Seconds([&]() {
+        result = SkipRanges(s.cbegin(), s.cend(), ranges, level);
+    });
+    EXPECT_EQ(result, s.cend());
+    cout << name << " MB/s: " << s.size() / seconds / 1e6 << endl;
+  }
+}
+
+TEST(ByteScanBench, HeaderTokens) {
+  Environment::EnvironmentInit();
+  auto source = GenerateHeader(1 << 24);
+
+  int tokens = 0;
+  auto seconds = Seconds([&]() {
+      Lexer lexer(source);
+      while (!lexer.Next().Empty()) {
+        tokens++;
+      }
+  });
+  cout << "tokens: " << tokens
+       << "\nlexer MB/s: " << source.size() / seconds / 1e6 << endl;
+}
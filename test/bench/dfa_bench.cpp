@@ -0,0 +1,200 @@
+//
+// Created by dxy on 2020/12/4.
+//
+
+#include "gtest/gtest.h"
+#include "lex/dfa.h"
+
+#include "bench_util.h"
+#include "environment.h"
+#include "lex/generated_scanner.h"
+#include "lex/lazy_dfa.h"
+#include "lex/nfa.h"
+#include "lex/token.h"
+
+using namespace CCompiler;
+using namespace std;
+
+/**
+ * Match every token in source.
+ *
+ * @tparam F
+ * @param next_match work like Dfa::NextMatch()
+ * @param source
+ * @return number of matched tokens
+ */
+template<class F>
+int MatchAll(F next_match, string_view source) {
+  int tokens = 0;
+  auto begin = source.cbegin(), end = source.cend();
+
+  while (begin != end) {
+    auto match = next_match(begin, end);
+    if (!match || match->second == begin) {
+      begin++;
+    } else {
+      begin = match->second;
+      tokens++;
+    }
+  }
+
+  return tokens;
+}
+
+TEST(DfaBench, Minimize) {
+  Nfa nfa(Environment::GetRegexRules());
+  Dfa dfa(nfa);
+  Dfa min_dfa(dfa);
+  min_dfa.Minimize();
+  auto source = GenerateSource(1 << 24);
+
+  int tokens = 0, min_tokens = 0;
+  CacheMissCounter counter;
+  double seconds = 0, min_seconds = 0;
+  auto misses = counter.Count([&]() {
+      seconds = Seconds([&]() {
+          tokens = MatchAll([&](auto begin, auto end) {
+              return dfa.NextMatch(begin, end);
+          }, source);
+      });
+  });
+  auto min_misses = counter.Count([&]() {
+      min_seconds = Seconds([&]() {
+          min_tokens = MatchAll([&](auto begin, auto end) {
+              return min_dfa.NextMatch(begin, end);
+          }, source);
+      });
+  });
+  EXPECT_EQ(tokens, min_tokens);
+
+  cout << "states: " << dfa.StateCount() << " -> " << min_dfa.StateCount()
+       << "\nbyte classes: " << dfa.ClassCount() << " -> "
+       << min_dfa.ClassCount()
+       << "\ntable bytes: " << dfa.TableSize() << " -> "
+       << min_dfa.TableSize()
+       << "\nMB/s: " << source.size() / seconds / 1e6 << " -> "
+       << source.size() / min_seconds / 1e6 << endl;
+  if (counter.Available()) {
+    cout << "cache misses: " << misses << " -> " << min_misses << endl;
+  }
+}
+
+TEST(DfaBench, Keywords) {
+  auto &regex_rules = Environment::GetRegexRules();
+  Dfa dfa{Nfa(regex_rules, false)};
+  dfa.Minimize();
+  Dfa keyword_dfa{Nfa(regex_rules)};
+  keyword_dfa.Minimize();
+
+  // identifier-heavy code
+  string source;
+  for (int i = 0; source.size() < (1 << 24); ++i) {
+    auto n = to_string(i);
+    source += "static unsigned long counter_" + n + " register_" + n +
+              " const volatile while_" + n + " return if else do double\n";
+  }
+
+  int tokens = 0, keyword_tokens = 0;
+  auto seconds = Seconds([&]() {
+      tokens = MatchAll([&](auto begin, auto end) {
+          return dfa.NextMatch(begin, end);
+      }, source);
+  });
+  auto keyword_seconds = Seconds([&]() {
+      keyword_tokens = MatchAll([&](auto begin, auto end) {
+          return keyword_dfa.NextMatch(begin, end);
+      }, source);
+  });
+  EXPECT_EQ(tokens, keyword_tokens);
+
+  cout << "states: " << dfa.StateCount() << " -> "
+       << keyword_dfa.StateCount()
+       << "\ntable bytes: " << dfa.TableSize() << " -> "
+       << keyword_dfa.TableSize()
+       << "\nMB/s: " << source.size() / seconds / 1e6 << " -> "
+       << source.size() / keyword_seconds / 1e6 << endl;
+}
+
+TEST(DfaBench, LazyDfa) {
+  // C rules, where the lazy DFA should run at DFA speed once it is warm
+  Nfa nfa(Environment::GetRegexRules());
+  auto source = GenerateSource(1 << 24);
+  Dfa dfa;
+  auto build_seconds = Seconds([&]() {
+      dfa = Dfa(nfa);
+  });
+  LazyDfa lazy_dfa(nfa);
+
+  int tokens = 0, lazy_tokens = 0;
+  auto seconds = Seconds([&]() {
+      tokens = MatchAll([&](auto begin, auto end) {
+          return dfa.NextMatch(begin, end);
+      }, source);
+  });
+  auto lazy_seconds = Seconds([&]() {
+      lazy_tokens = MatchAll([&](auto begin, auto end) {
+          return lazy_dfa.NextMatch(begin, end);
+      }, source);
+  });
+  EXPECT_EQ(tokens, lazy_tokens);
+
+  cout << "C states: " << dfa.StateCount() << " -> "
+       << lazy_dfa.StateCount()
+       << "\nC build ms: " << build_seconds * 1e3 << " -> 0"
+       << "\nC MB/s: " << source.size() / seconds / 1e6 << " -> "
+       << source.size() / lazy_seconds / 1e6 << endl;
+
+  // a rule whose full DFA has 2^15 states, most of which this input never
+  // reaches
+  Nfa explosive_nfa({{"[ab]*a[ab]{14}", TokenType::kIdentifier}});
+  string ab;
+  for (int i = 0; ab.size() < (1 << 16); ++i) {
+    ab += (i * 2654435761u >> 7) % 3 == 0 ? 'a' : 'b';
+  }
+  int explosive_tokens = 0, lazy_explosive_tokens = 0;
+  int explosive_states = 0;
+  auto explosive_seconds = Seconds([&]() {
+      Dfa explosive_dfa(explosive_nfa);
+      explosive_states = explosive_dfa.StateCount();
+      explosive_tokens = MatchAll([&](auto begin, auto end) {
+          return explosive_dfa.NextMatch(begin, end);
+      }, ab);
+  });
+  LazyDfa lazy_explosive_dfa(explosive_nfa);
+  auto lazy_explosive_seconds = Seconds([&]() {
+      lazy_explosive_tokens = MatchAll([&](auto begin, auto end) {
+          return lazy_explosive_dfa.NextMatch(begin, end);
+      }, ab);
+  });
+  EXPECT_EQ(explosive_tokens, lazy_explosive_tokens);
+
+  cout << "explosive states: " << explosive_states << " -> "
+       << lazy_explosive_dfa.StateCount()
+       << "\nexplosive build and match ms: " << explosive_seconds * 1e3
+       << " -> " << lazy_explosive_seconds * 1e3 << endl;
+}
+
+#ifdef CCOMPILER_GENERATED_SCANNER
+
+TEST(DfaBench, GeneratedScanner) {
+  Dfa dfa{Nfa(Environment::GetRegexRules())};
+  dfa.Minimize();
+  auto source = GenerateSource(1 << 24);
+
+  int tokens = 0, generated_tokens = 0;
+  auto seconds = Seconds([&]() {
+      tokens = MatchAll([&](auto begin, auto end) {
+          return dfa.NextMatch(begin, end);
+      }, source);
+  });
+  auto generated_seconds = Seconds([&]() {
+      generated_tokens = MatchAll(GeneratedNextMatch, source);
+  });
+  EXPECT_EQ(tokens, generated_tokens);
+
+  cout << "table MB/s: " << source.size() / seconds / 1e6
+       << "\ngenerated MB/s: " << source.size() / generated_seconds / 1e6
+       << endl;
+}
+
+#endif
@@ -0,0 +1,142 @@
+//
+// Created by dxy on 2020/12/13.
+//
+
+#include "gtest/gtest.h"
+#include "lex/lexer.h"
+
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include "bench_util.h"
+#include "environment.h"
+#include "lex/source_buffer.h"
+#include "lex/token.h"
+
+using namespace CCompiler;
+using namespace std;
+
+/**
+ * @param lexer
+ * @return number of tokens left in lexer
+ */
+int LexAll(Lexer &lexer) {
+  int tokens = 0;
+  while (!lexer.Next().Empty()) {
+    tokens++;
+  }
+  return tokens;
+}
+
+TEST(LexerBench, MappedFile) {
+  Environment::EnvironmentInit();
+  auto path = (filesystem::temp_directory_path() / "lexer_bench.c").string();
+  auto size = 1 << 24;
+  {
+    ofstream file(path, ios::binary);
+    file << GenerateSource(size);
+  }
+
+  int tokens = 0, mapped_tokens = 0;
+  size_t heap_bytes = HeapBytes(), mapped_heap_bytes = 0;
+  auto seconds = Seconds([&]() {
+      ifstream file(path, ios::binary);
+      Lexer lexer(file);
+      heap_bytes = HeapBytes() - heap_bytes;
+      tokens = LexAll(lexer);
+  });
+
+  mapped_heap_bytes = HeapBytes();
+  auto mapped_seconds = Seconds([&]() {
+      Lexer lexer(SourceBuffer::Open(path));
+      mapped_heap_bytes = HeapBytes() - mapped_heap_bytes;
+      mapped_tokens = LexAll(lexer);
+  });
+  EXPECT_EQ(tokens, mapped_tokens);
+  filesystem::remove(path);
+
+  cout << "tokens: " << tokens
+       << "\nheap bytes: " << heap_bytes << " -> " << mapped_heap_bytes
+       << "\nMB/s: " << size / seconds / 1e6 << " -> "
+       << size / mapped_seconds / 1e6 << endl;
+}
+
+TEST(LexerBench, Stream) {
+  Environment::EnvironmentInit();
+  auto path = (filesystem::temp_directory_path() / "lexer_bench.c").string();
+  auto size = 1 << 24;
+  {
+    ofstream file(path, ios::binary);
+    file << GenerateSource(size);
+  }
+
+  int tokens = 0, stream_tokens = 0;
+  size_t heap_bytes = HeapBytes(), stream_heap_bytes = 0;
+  auto seconds = Seconds([&]() {
+      ifstream file(path, ios::binary);
+      Lexer lexer(file);
+      heap_bytes = HeapBytes() - heap_bytes;
+      tokens = LexAll(lexer);
+  });
+
+  stream_heap_bytes = HeapBytes();
+  auto stream_seconds = Seconds([&]() {
+      auto fd = open(path.c_str(), O_RDONLY);
+      Lexer lexer(fd);
+      stream_heap_bytes = HeapBytes() - stream_heap_bytes;
+      stream_tokens = LexAll(lexer);
+      close(fd);
+  });
+  EXPECT_EQ(tokens, stream_tokens);
+  filesystem::remove(path);
+
+  cout << "tokens: " << tokens
+       << "\nheap bytes: " << heap_bytes << " -> " << stream_heap_bytes
+       << "\nMB/s: " << size / seconds / 1e6 << " -> "
+       << size / stream_seconds / 1e6 << endl;
+}
+
+TEST(LexerBench, LexParallel) {
+  Environment::EnvironmentInit();
+  auto source = make_shared<const SourceBuffer>(GenerateSource(1 << 24));
+  auto thread_count = max(static_cast<int>(thread::hardware_concurrency()), 1);
+
+  size_t tokens = 0, parallel_tokens = 0;
+  auto seconds = Seconds([&]() {
+      tokens = Lexer::LexParallel(source, 1).size();
+  });
+  auto parallel_seconds = Seconds([&]() {
+      parallel_tokens = Lexer::LexParallel(source, thread_count).size();
+  });
+  EXPECT_EQ(tokens, parallel_tokens);
+
+  auto size = source->GetText().size();
+  cout << "threads: " << thread_count
+       << "\nMB/s: " << size / seconds / 1e6 << " -> "
+       << size / parallel_seconds / 1e6 << endl;
+}
+
+TEST(LexerBench, TokenizeAll) {
+  Environment::EnvironmentInit();
+  auto source = make_shared<const SourceBuffer>(GenerateSource(1 << 24));
+
+  vector<Token> tokens;
+  auto seconds = Seconds([&]() {
+      Lexer lexer(source);
+      Token token;
+      while (!(token = lexer.Next()).Empty()) {
+        tokens.push_back(token);
+      }
+  });
+  size_t stream_size = 0;
+  auto stream_seconds = Seconds([&]() {
+      stream_size = Lexer(source).TokenizeAll().Size();
+  });
+  EXPECT_EQ(tokens.size(), stream_size);
+
+  cout << "tokens: " << tokens.size()
+       << "\nmillion tokens/s: " << tokens.size() / seconds / 1e6 << " -> "
+       << stream_size / stream_seconds / 1e6 << endl;
+}
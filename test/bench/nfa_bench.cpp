@@ -0,0 +1,105 @@
+//
+// Created by dxy on 2020/12/10.
+//
+
+#include "gtest/gtest.h"
+#include "lex/nfa.h"
+
+#include <optional>
+#include "bench_util.h"
+#include "environment.h"
+#include "lex/token.h"
+
+using namespace CCompiler;
+using namespace std;
+
+TEST(NfaBench, Build) {
+  auto &regex_rules = Environment::GetRegexRules();
+  const int kRounds = 20;
+
+  optional<Nfa> nfa;
+  auto heap_bytes = HeapBytes();
+  auto seconds = Seconds([&]() {
+      for (int i = 0; i < kRounds; ++i) {
+        nfa.reset();
+        nfa.emplace(regex_rules);
+      }
+  });
+  heap_bytes = HeapBytes() - heap_bytes;
+
+  EXPECT_FALSE(nfa->Empty());
+  cout << "rules: " << regex_rules.size()
+       << "\nstates: " << nfa->StateCount()
+       << "\nbuild ms: " << seconds / kRounds * 1e3
+       << "\nheap bytes: " << heap_bytes << endl;
+}
+
+/**
+ * @param count
+ * @return count different rules like "r12_[a-z]+(x|y)?[0-9]{2}"
+ */
+map<string, TokenType> SyntheticRules(int count) {
+  map<string, TokenType> rules;
+  for (int i = 0; i < count; ++i) {
+    rules.insert({"r" + to_string(i) + "_[a-z]+(x|y)?[0-9]{2}",
+                  static_cast<TokenType>(i)});
+  }
+  return rules;
+}
+
+TEST(NfaBench, BuildManyRules) {
+  for (auto count:{1000, 10000}) {
+    auto rules = SyntheticRules(count);
+    optional<Nfa> nfa;
+    auto heap_bytes = HeapBytes();
+    auto seconds = Seconds([&]() {
+        nfa.emplace(rules);
+    });
+    heap_bytes = HeapBytes() - heap_bytes;
+
+    string_view s = "r42_abcx17";
+    auto match = nfa->NextMatch(s.cbegin(), s.cend());
+    ASSERT_NE(match, nullptr);
+    EXPECT_EQ(match->second, s.cend());
+    cout << "rules: " << count
+         << "\nstates: " << nfa->StateCount()
+         << "\nbuild ms: " << seconds * 1e3
+         << "\nheap bytes: " << heap_bytes << endl;
+  }
+}
+
+TEST(NfaBench, NextMatch) {
+  Nfa nfa(Environment::GetRegexRules());
+  auto source = GenerateSource(1 << 16);
+  // a single token whose length is proportional to the input
+  auto identifier_text = string(1 << 14, 'a');
+  string_view identifier(identifier_text);
+
+  int tokens = 0;
+  auto heap_bytes = HeapBytes();
+  auto seconds = Seconds([&]() {
+      string_view view(source);
+      auto begin = view.cbegin(), end = view.cend();
+      while (begin != end) {
+        auto match = nfa.NextMatch(begin, end);
+        if (match == nullptr || match->second == begin) {
+          begin++;
+        } else {
+          begin = match->second;
+          tokens++;
+        }
+      }
+  });
+  unique_ptr<AcceptState> match;
+  auto identifier_seconds = Seconds([&]() {
+      match = nfa.NextMatch(identifier.cbegin(), identifier.cend());
+  });
+  heap_bytes = HeapBytes() - heap_bytes;
+
+  ASSERT_NE(match, nullptr);
+  EXPECT_EQ(match->second, identifier.cend());
+  cout << "tokens: " << tokens
+       << "\nMB/s: " << source.size() / seconds / 1e6
+       << "\n16 KB identifier ms: " << identifier_seconds * 1e3
+       << "\nheap bytes after matching: " << heap_bytes << endl;
+}
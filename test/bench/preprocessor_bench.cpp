@@ -0,0 +1,119 @@
+//
+// Created by dxy on 2020/12/18.
+//
+
+#include "gtest/gtest.h"
+#include "preprocess/preprocessor.h"
+
+#include <filesystem>
+#include <fstream>
+#include "bench_util.h"
+#include "environment.h"
+#include "lex/source_buffer.h"
+#include "preprocess/header_cache.h"
+
+using namespace CCompiler;
+using namespace std;
+
+/**
+ * Write headers 0 to count - 1, where header i includes headers i / 2 and
+ * i - 1, like headers of a project that include each other. Every header
+ * is included by about three others.
+ *
+ * @param directory
+ * @param count
+ * @param detectable whether the include guards can be detected. Otherwise
+ * an empty group after the guard hides it, and every inclusion is read to
+ * the end.
+ */
+void WriteHeaders(const filesystem::path &directory, int count,
+                  bool detectable) {
+  filesystem::create_directories(directory);
+  for (int i = 0; i < count; ++i) {
+    auto guard = "HEADER_" + to_string(i) + "_H";
+    ofstream file(directory / ("header_" + to_string(i) + ".h"),
+                  ios::binary);
+    file << "#ifndef " << guard << "\n#define " << guard << "\n";
+    for (auto include:{i / 2, i - 1}) {
+      if (include >= 0 && include != i) {
+        file << "#include \"header_" << include << ".h\"\n";
+      }
+    }
+    // the same declarations in every header like the real ones
+    file << GenerateSource(1 << 12) << "#endif\n";
+    if (!detectable) {
+      file << "#if 0\n#endif\n";
+    }
+  }
+
+  ofstream file(directory / "main.c", ios::binary);
+  for (int i = 0; i < count; ++i) {
+    file << "#include \"header_" << i << ".h\"\n";
+  }
+}
+
+TEST(PreprocessorBench, Headers) {
+  Environment::EnvironmentInit();
+  const int kHeaders = 256;
+  auto directory = filesystem::temp_directory_path() / "preprocessor_bench";
+
+  for (auto detectable:{true, false}) {
+    WriteHeaders(directory, kHeaders, detectable);
+    auto path = (directory / "main.c").string();
+    HeaderCache cache;
+    int tokens = 0, skipped = 0;
+    auto preprocess = [&]() {
+        Preprocessor preprocessor(SourceBuffer::Open(path), path, {}, cache);
+        tokens = 0;
+        while (!preprocessor.Next().Empty()) {
+          tokens++;
+        }
+        skipped = preprocessor.SkippedIncludeCount();
+    };
+
+    // the first translation unit lexes every header
+    auto cold_seconds = Seconds(preprocess);
+    auto warm_seconds = Seconds(preprocess);
+    filesystem::remove_all(directory);
+
+    // all but the first inclusion of every header
+    EXPECT_EQ(skipped, detectable ? 2 * kHeaders - 2 : 0);
+    cout << "detectable guards: " << detectable
+         << "\ntokens: " << tokens
+         << "\nskipped includes: " << skipped
+         << "\ncold ms: " << cold_seconds * 1e3
+         << "\ncached ms: " << warm_seconds * 1e3 << endl;
+  }
+}
+
+TEST(PreprocessorBench, Macros) {
+  Environment::EnvironmentInit();
+  string source = "#define MIN(a, b) ((a) < (b) ? (a) : (b))\n"
+                  "#define SQUARE(x) ((x) * (x))\n"
+                  "#define CALL(f, ...) f(__VA_ARGS__)\n"
+                  "#define NAME(n) value_ ## n\n"
+                  "#define ONE 1\n";
+  const int kLines = 1 << 14;
+  for (int i = 0; i < kLines; ++i) {
+    auto n = to_string(i);
+    source += "int NAME(" + n + ") = MIN(SQUARE(" + n + "), CALL(g, " + n +
+              ", MIN(ONE, x)));\n";
+  }
+
+  HeaderCache cache;
+  Preprocessor preprocessor(make_shared<const SourceBuffer>(source), "", {},
+                            cache);
+  int tokens = 0;
+  auto seconds = Seconds([&]() {
+      while (!preprocessor.Next().Empty()) {
+        tokens++;
+      }
+  });
+
+  // 79 tokens per line after expansion
+  EXPECT_EQ(tokens, kLines * 79);
+  cout << "lines: " << kLines
+       << "\ntokens after expansion: " << tokens
+       << "\nMB/s: " << source.size() / seconds / 1e6
+       << "\nmillion tokens/s: " << tokens / seconds / 1e6 << endl;
+}
@@ -0,0 +1,105 @@
+//
+// Created by dxy on 2020/12/16.
+//
+
+#include "gtest/gtest.h"
+#include "lex/scanner.h"
+
+#include "bench_util.h"
+#include "lex/lazy_dfa.h"
+#include "lex/nfa.h"
+#include "lex/token.h"
+
+using namespace CCompiler;
+using namespace std;
+
+/**
+ * @param bytes minimum size of the log
+ * @return a log where one line of 64 has an error or a warning
+ */
+string GenerateLog(size_t bytes) {
+  string log;
+  for (int i = 0; log.size() < bytes; ++i) {
+    auto n = to_string(i);
+    log += "2020-12-16 12:00:" + to_string(i % 60) + " INFO request id=" +
+           n + " path=/api/v1/items took " + to_string(i % 97) + "ms\n";
+    if (i % 64 == 0) {
+      log += "2020-12-16 12:00:00 ERROR " + n + " connection reset\n";
+    } else if (i % 64 == 32) {
+      log += "2020-12-16 12:00:00 WARN SLOW request id=" + n + "\n";
+    }
+  }
+  return log;
+}
+
+/**
+ * Find matches by trying NextMatch() at every location, as the Scanner does
+ * without a prefilter.
+ *
+ * @tparam F
+ * @param next_match work like Dfa::NextMatch()
+ * @param text
+ * @return number of matches
+ */
+template<class F>
+int MatchEveryLocation(F next_match, string_view text) {
+  int matches = 0;
+  auto begin = text.cbegin(), end = text.cend();
+  while (begin != end) {
+    auto match = next_match(begin, end);
+    if (!match || match->second == begin) {
+      begin++;
+    } else {
+      begin = match->second;
+      matches++;
+    }
+  }
+  return matches;
+}
+
+TEST(ScannerBench, FindAll) {
+  auto log = GenerateLog(1 << 22);
+  vector<map<string, TokenType>> rule_sets{
+          // a single start byte is found by memchr()
+          {{"ERROR [0-9]+",  TokenType::kNumber}},
+          // the other bytes are a few ranges for SkipRanges()
+          {{"ERROR [0-9]+",  TokenType::kNumber},
+                  {"WARN [A-Z]+", TokenType::kIdentifier}},
+          // digits are common in the log, so few bytes are skipped
+          {{"ERROR [0-9]+",  TokenType::kNumber},
+                  {"[0-9]+ms", TokenType::kIdentifier}}};
+
+  for (auto &rules:rule_sets) {
+    Scanner scanner(rules);
+    Nfa nfa(rules);
+    LazyDfa lazy_dfa(nfa);
+
+    vector<Token> tokens;
+    auto seconds = Seconds([&]() {
+        tokens = scanner.FindAll(log);
+    });
+    int lazy_matches = 0;
+    auto lazy_seconds = Seconds([&]() {
+        lazy_matches = MatchEveryLocation([&](auto begin, auto end) {
+            return lazy_dfa.NextMatch(begin, end);
+        }, log);
+    });
+    int nfa_matches = 0;
+    auto nfa_seconds = Seconds([&]() {
+        nfa_matches = MatchEveryLocation([&](auto begin, auto end) {
+            return nfa.NextMatch(begin, end);
+        }, log);
+    });
+
+    EXPECT_EQ(tokens.size(), nfa_matches);
+    EXPECT_EQ(lazy_matches, nfa_matches);
+    cout << "rules: " << rules.size()
+         << "\nstart bytes: " << scanner.StartByteCount()
+         << "\nmatches: " << tokens.size()
+         << "\nFindAll MB/s: " << log.size() / seconds / 1e6
+         << "\nLazyDfa at every location MB/s: "
+         << log.size() / lazy_seconds / 1e6
+         << "\nNfa at every location MB/s: "
+         << log.size() / nfa_seconds / 1e6 << endl;
+  }
+}
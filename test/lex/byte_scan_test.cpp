@@ -0,0 +1,143 @@
+//
+// Created by dxy on 2020/12/12.
+//
+
+#include "gtest/gtest.h"
+#include "lex/byte_scan.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace CCompiler;
+using namespace std;
+
+/**
+ * @return levels supported by the running CPU
+ */
+vector<SimdLevel> SupportedLevels() {
+  vector<SimdLevel> levels{SimdLevel::kScalar};
+  if (BestSimdLevel() != SimdLevel::kScalar) {
+    levels.push_back(SimdLevel::kSse2);
+  }
+  if (BestSimdLevel() == SimdLevel::kAvx2) {
+    levels.push_back(SimdLevel::kAvx2);
+  }
+  return levels;
+}
+
+TEST(ByteScan, FromBytes) {
+  bool bytes[256]{};
+  for (int c = '0'; c <= '9'; ++c) {
+    bytes[c] = true;
+  }
+  bytes['_'] = true;
+  bytes[0xff] = true;
+
+  auto ranges = ByteRanges::FromBytes(bytes);
+  ASSERT_EQ(ranges.count, 3);
+  EXPECT_EQ(ranges.lows[0], '0');
+  EXPECT_EQ(ranges.highs[0], '9');
+  EXPECT_EQ(ranges.lows[1], '_');
+  EXPECT_EQ(ranges.highs[1], '_');
+  EXPECT_EQ(ranges.lows[2], 0xff);
+  EXPECT_EQ(ranges.highs[2], 0xff);
+  for (int c = 0; c < 256; ++c) {
+    EXPECT_EQ(ranges.Contains(c), bytes[c]);
+  }
+
+  bytes['a'] = bytes['c'] = true;
+  EXPECT_EQ(ByteRanges::FromBytes(bytes).count, 0);
+}
+
+TEST(ByteScan, FromRanges) {
+  constexpr auto kRanges = ByteRanges::FromRanges({{'\t', '\n'},
+                                                   {' ',  ' '}});
+  bool bytes[256]{};
+  bytes['\t'] = bytes['\n'] = bytes[' '] = true;
+
+  auto ranges = ByteRanges::FromBytes(bytes);
+  EXPECT_EQ(kRanges.count, ranges.count);
+  for (int c = 0; c < 256; ++c) {
+    EXPECT_EQ(kRanges.Contains(c), bytes[c]);
+  }
+}
+
+TEST(ByteScan, SkipRanges) {
+  auto ranges = ByteRanges::FromRanges({{'0', '9'},
+                                        {'A', 'Z'},
+                                        {'_', '_'},
+                                        {'a', 'z'}});
+  mt19937 random(12);
+  string alphabet("az_09AZ \n+\x80\xff");
+
+  // runs of every length up to a few vectors at every alignment
+  for (int length = 0; length < 100; ++length) {
+    for (int offset = 0; offset < 32; ++offset) {
+      string s(offset, ' ');
+      for (int i = 0; i < length; ++i) {
+        s += alphabet[random() % 7];
+      }
+      s += alphabet[7 + random() % (alphabet.size() - 7)];
+      s += "abc";
+
+      string_view view(s);
+      auto begin = view.cbegin() + offset, end = view.cend();
+      for (auto level:SupportedLevels()) {
+        EXPECT_EQ(SkipRanges(begin, end, ranges, level), begin + length);
+        EXPECT_EQ(SkipRanges(begin, begin + length, ranges, level),
+                  begin + length);
+      }
+      EXPECT_EQ(SkipRanges(begin, end, ranges), begin + length);
+    }
+  }
+}
+
+TEST(ByteScan, FindPair) {
+  for (int length = 0; length < 100; ++length) {
+    for (int offset = 0; offset < 32; ++offset) {
+      // the first '*' isn't followed by '/' and the last '/' isn't after '*'
+      string s = string(offset, '/') + string(length, '*') + "*/" + "/";
+      string_view view(s);
+      auto begin = view.cbegin() + offset, end = view.cend();
+
+      for (auto level:SupportedLevels()) {
+        EXPECT_EQ(FindPair(begin, end, '*', '/', level), begin + length);
+        EXPECT_EQ(FindPair(begin, begin + length + 1, '*', '/', level),
+                  begin + length + 1);
+      }
+    }
+  }
+}
+
+TEST(ByteScan, FindByte) {
+  string_view s("int i;  // comment\nint j;");
+  EXPECT_EQ(FindByte(s.cbegin(), s.cend(), '\n'), s.cbegin() + 18);
+  EXPECT_EQ(FindByte(s.cbegin(), s.cend(), '@'), s.cend());
+}
+
+TEST(ByteScan, FindAll) {
+  mt19937 random(14);
+  for (int length = 0; length < 100; ++length) {
+    string s;
+    for (int i = 0; i < length; ++i) {
+      s += random() % 4 == 0 ? '\n' : 'a';
+    }
+    vector<uint32_t> expected;
+    for (int i = 0; i < length; ++i) {
+      if (s[i] == '\n') {
+        expected.push_back(i);
+      }
+    }
+
+    string_view view(s);
+    for (auto level:SupportedLevels()) {
+      vector<uint32_t> offsets{42};
+      FindAll(view.cbegin(), view.cend(), '\n', offsets, level);
+      ASSERT_EQ(offsets.size(), expected.size() + 1);
+      EXPECT_EQ(offsets[0], 42);
+      EXPECT_TRUE(equal(expected.cbegin(), expected.cend(),
+                        offsets.cbegin() + 1));
+    }
+  }
+}
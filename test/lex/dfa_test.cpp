@@ -0,0 +1,185 @@
+//
+// Created by dxy on 2020/12/2.
+//
+
+#include "gtest/gtest.h"
+#include "lex/dfa.h"
+
+#include <filesystem>
+#include <fstream>
+#include "lex/nfa.h"
+#include "lex/token.h"
+
+using namespace CCompiler;
+using namespace std;
+
+/**
+ * Check that the DFA compiled from rules finds the same match as the NFA at
+ * every location of s.
+ *
+ * @param rules
+ * @param s
+ */
+void SameAsNfa(const map<string, TokenType> &rules, string_view s) {
+  Nfa nfa(rules);
+  Dfa dfa(nfa);
+
+  for (auto begin = s.cbegin(); begin != s.cend(); ++begin) {
+    auto nfa_match = nfa.NextMatch(begin, s.cend());
+    auto dfa_match = dfa.NextMatch(begin, s.cend());
+    ASSERT_EQ(nfa_match == nullptr, !dfa_match.has_value());
+    if (nfa_match != nullptr) {
+      EXPECT_EQ(nfa_match->first, dfa_match->first);
+      EXPECT_EQ(nfa_match->second, dfa_match->second);
+    }
+  }
+}
+
+TEST(Dfa, LongestMatch) {
+  Dfa dfa(Nfa({{"a",   TokenType::kEmpty},
+               {"ab+", TokenType::kEmpty}}));
+  string_view s = "abbbc";
+  auto begin = s.cbegin(), end = s.cend();
+
+  auto match_end = dfa.NextMatch(begin, end)->second;
+  EXPECT_EQ(string(begin, match_end), "abbb");
+
+  begin = match_end;
+  EXPECT_FALSE(dfa.NextMatch(begin, end).has_value());
+}
+
+TEST(Dfa, Priority) {
+  Dfa dfa(Nfa({{"while",                  TokenType::kWhile},
+               {"[a-zA-Z_][a-zA-Z0-9_]*", TokenType::kIdentifier}}));
+
+  string_view s = "while";
+  auto match = dfa.NextMatch(s.cbegin(), s.cend());
+  EXPECT_EQ(string(s.cbegin(), match->second), "while");
+  EXPECT_EQ(match->first, TokenType::kWhile);
+
+  s = "while1";
+  match = dfa.NextMatch(s.cbegin(), s.cend());
+  EXPECT_EQ(string(s.cbegin(), match->second), "while1");
+  EXPECT_EQ(match->first, TokenType::kIdentifier);
+}
+
+TEST(Dfa, EmptyMatch) {
+  Dfa dfa(Nfa({{"[a-c]?", TokenType::kEmpty}}));
+  string_view s = "d";
+
+  auto match = dfa.NextMatch(s.cbegin(), s.cend());
+  ASSERT_TRUE(match.has_value());
+  EXPECT_EQ(match->second, s.cbegin());
+}
+
+TEST(Dfa, InvalidRegex) {
+  Dfa dfa(Nfa({{"a|b|", TokenType::kEmpty}}));
+  string_view s = "a";
+
+  EXPECT_FALSE(dfa.NextMatch(s.cbegin(), s.cend()).has_value());
+}
+
+TEST(Dfa, SameAsNfa) {
+  map<string, TokenType> rules{
+          {"int",                                  TokenType::kInt},
+          {"[a-zA-Z_][a-zA-Z0-9_]*",               TokenType::kIdentifier},
+          {"(?:0|[1-9][0-9]*|(?:0x|0X)[0-9a-fA-F]+|0[0-7]+)(?:u|U|l|L)*",
+                                                   TokenType::kNumber},
+          {"\\+",                                  TokenType::kPlus},
+          {"\\+\\+",                               TokenType::kIncrement},
+          {"\\+=",                                 TokenType::kPlusAssign},
+          {"[^abc\\d]",                            TokenType::kDelim},
+          {"\\.",                                  TokenType::kDot},
+          {R"(\.\.\.)",                            TokenType::kEllipsis},
+          {"//|/\\*|\\*/",                         TokenType::kComment}};
+
+  SameAsNfa(rules, "int i = 0x1fUL + 017;i++ ... /* int2 */a+=b.c\t\n");
+}
+
+TEST(Dfa, Minimize) {
+  // 'ab|cb' has separate states for 'a' and 'c' that are equivalent
+  Nfa nfa({{"ab|cb", TokenType::kEmpty},
+           {"[0-9]+", TokenType::kNumber}});
+  Dfa dfa(nfa);
+  Dfa min_dfa(dfa);
+  min_dfa.Minimize();
+  EXPECT_LT(min_dfa.StateCount(), dfa.StateCount());
+  EXPECT_LT(min_dfa.TableSize(), dfa.TableSize());
+
+  string_view s = "ab cb 0123 ac";
+  for (auto begin = s.cbegin(); begin != s.cend(); ++begin) {
+    EXPECT_EQ(dfa.NextMatch(begin, s.cend()),
+              min_dfa.NextMatch(begin, s.cend()));
+  }
+}
+
+TEST(Dfa, ByteClasses) {
+  Dfa dfa(Nfa({{"[a-z]+", TokenType::kIdentifier},
+               {"[0-9]+", TokenType::kNumber},
+               {"\\s",    TokenType::kDelim}}));
+  dfa.Minimize();
+  // letters, digits, white spaces and the rest
+  EXPECT_EQ(dfa.ClassCount(), 4);
+  EXPECT_EQ(dfa.GetNextState(dfa.GetStartState(), 'a'),
+            dfa.GetNextState(dfa.GetStartState(), 'z'));
+  EXPECT_EQ(dfa.GetNextState(dfa.GetStartState(), '\x80'), Dfa::kDeadState);
+
+  string_view s = "abc 123\tq";
+  SameAsNfa({{"[a-z]+", TokenType::kIdentifier},
+             {"[0-9]+", TokenType::kNumber},
+             {"\\s",    TokenType::kDelim}}, s);
+}
+
+TEST(Dfa, MinimizeNoMatch) {
+  Dfa dfa(Nfa({{"a|b|", TokenType::kEmpty}}));
+  dfa.Minimize();
+  string_view s = "a";
+
+  EXPECT_TRUE(dfa.Empty());
+  EXPECT_FALSE(dfa.NextMatch(s.cbegin(), s.cend()).has_value());
+}
+
+TEST(Dfa, SaveAndLoad) {
+  map<string, TokenType> rules{{"while",                  TokenType::kWhile},
+                               {"[a-zA-Z_][a-zA-Z0-9_]*", TokenType::kIdentifier}};
+  auto path = (filesystem::temp_directory_path() / "dfa_test.dfa").string();
+  Dfa dfa(Nfa{rules});
+  dfa.Minimize();
+  ASSERT_TRUE(dfa.Save(path, Dfa::Fingerprint(rules)));
+
+  auto loaded = Dfa::Load(path, Dfa::Fingerprint(rules));
+  ASSERT_TRUE(loaded.has_value());
+  EXPECT_EQ(loaded->StateCount(), dfa.StateCount());
+  string_view s = "while while1 _a";
+  for (auto begin = s.cbegin(); begin != s.cend(); ++begin) {
+    EXPECT_EQ(dfa.NextMatch(begin, s.cend()),
+              loaded->NextMatch(begin, s.cend()));
+  }
+
+  // rules are changed
+  rules.erase("while");
+  EXPECT_FALSE(Dfa::Load(path, Dfa::Fingerprint(rules)).has_value());
+
+  filesystem::remove(path);
+  EXPECT_FALSE(Dfa::Load(path, Dfa::Fingerprint(rules)).has_value());
+}
+
+TEST(Dfa, LoadCorruptedFile) {
+  map<string, TokenType> rules{{"[0-9]+", TokenType::kNumber}};
+  auto path = (filesystem::temp_directory_path() / "dfa_test.dfa").string();
+  ASSERT_TRUE(Dfa(Nfa{rules}).Save(path, Dfa::Fingerprint(rules)));
+
+  {
+    fstream file(path, ios::binary | ios::in | ios::out);
+    file.seekp(-1, ios::end);
+    file.put('\x7f');
+  }
+  EXPECT_FALSE(Dfa::Load(path, Dfa::Fingerprint(rules)).has_value());
+
+  // a table with a valid checksum but no such token type
+  rules = {{"[0-9]+", static_cast<TokenType>(1 << 20)}};
+  ASSERT_TRUE(Dfa(Nfa{rules}).Save(path, Dfa::Fingerprint(rules)));
+  EXPECT_FALSE(Dfa::Load(path, Dfa::Fingerprint(rules)).has_value());
+
+  filesystem::remove(path);
+}
@@ -0,0 +1,37 @@
+//
+// Created by dxy on 2020/12/9.
+//
+
+#include "gtest/gtest.h"
+#include "lex/generated_scanner.h"
+
+#include "environment.h"
+#include "lex/dfa.h"
+#include "lex/token.h"
+
+using namespace CCompiler;
+using namespace std;
+
+#ifdef CCOMPILER_GENERATED_SCANNER
+
+TEST(GeneratedScanner, Fingerprint) {
+  EXPECT_EQ(kGeneratedScannerFingerprint,
+            Dfa::Fingerprint(Environment::GetRegexRules()));
+}
+
+TEST(GeneratedScanner, SameAsDfa) {
+  Dfa dfa{Nfa(Environment::GetRegexRules())};
+  string_view s = "int main() {\r\n"
+             "  /* comment */ char *s = \"abc\"; // x\n"
+             "  unsigned long i = 0x1fUL + 017 - 9;\n"
+             "  while (i-- >= 0 && s[i] != '\\0') i <<= 2; ...\n"
+             "  _Static_assert $ @\x80\xff\n"
+             "}";
+
+  for (auto begin = s.cbegin(); begin != s.cend(); ++begin) {
+    EXPECT_EQ(GeneratedNextMatch(begin, s.cend()),
+              dfa.NextMatch(begin, s.cend()));
+  }
+}
+
+#endif
@@ -0,0 +1,78 @@
+//
+// Created by dxy on 2020/12/11.
+//
+
+#include "gtest/gtest.h"
+#include "lex/keyword_table.h"
+
+#include "lex/token.h"
+
+using namespace CCompiler;
+using namespace std;
+
+TEST(KeywordTable, Extract) {
+  map<string, TokenType> rules{
+          {"while",                  TokenType::kWhile},
+          {"_Bool",                  TokenType::k_Bool},
+          {"[a-zA-Z_][a-zA-Z0-9_]*", TokenType::kIdentifier},
+          {"->",                     TokenType::kArrow},
+          {"\\.",                    TokenType::kDot}};
+  auto keywords = KeywordTable::Extract(rules);
+
+  // only literals hosted by the identifier rule are extracted
+  EXPECT_EQ(rules.size(), 3);
+  EXPECT_FALSE(rules.contains("while"));
+  EXPECT_FALSE(rules.contains("_Bool"));
+  EXPECT_TRUE(rules.contains("->"));
+  EXPECT_EQ(keywords.GetHosts(),
+            vector<int>{static_cast<int>(TokenType::kIdentifier)});
+
+  string_view s = "while";
+  EXPECT_EQ(keywords.Classify(TokenType::kIdentifier, s.cbegin(), s.cend()),
+            TokenType::kWhile);
+  // only matches of the host are classified
+  EXPECT_EQ(keywords.Classify(TokenType::kNumber, s.cbegin(), s.cend()),
+            TokenType::kNumber);
+  s = "while1";
+  EXPECT_EQ(keywords.Classify(TokenType::kIdentifier, s.cbegin(), s.cend()),
+            TokenType::kIdentifier);
+  s = "_Bool";
+  EXPECT_EQ(keywords.Classify(TokenType::kIdentifier, s.cbegin(), s.cend()),
+            TokenType::k_Bool);
+}
+
+TEST(KeywordTable, LowerPriorityLiteral) {
+  // The identifier rule wins on "id", so "id" isn't a keyword.
+  map<string, TokenType> rules{
+          {"id",       TokenType::kNumber},
+          {"[a-z]+",   TokenType::kIdentifier},
+          {"int",      TokenType::kInt}};
+  auto keywords = KeywordTable::Extract(rules);
+
+  EXPECT_TRUE(rules.contains("id"));
+  EXPECT_FALSE(rules.contains("int"));
+  string_view s = "id";
+  EXPECT_EQ(keywords.Classify(TokenType::kIdentifier, s.cbegin(), s.cend()),
+            TokenType::kIdentifier);
+}
+
+TEST(KeywordTable, Serialize) {
+  map<string, TokenType> rules{
+          {"if",                     TokenType::kIf},
+          {"int",                    TokenType::kInt},
+          {"[a-zA-Z_][a-zA-Z0-9_]*", TokenType::kIdentifier}};
+  auto keywords = KeywordTable::Extract(rules);
+  auto data = keywords.Serialize();
+
+  auto loaded = KeywordTable::Deserialize(data.data(), data.size());
+  ASSERT_TRUE(loaded.has_value());
+  EXPECT_EQ(loaded->GetSpellings(), keywords.GetSpellings());
+  string_view s = "int";
+  EXPECT_EQ(loaded->Classify(TokenType::kIdentifier, s.cbegin(), s.cend()),
+            TokenType::kInt);
+
+  EXPECT_FALSE(KeywordTable::Deserialize(data.data(), data.size() - 1));
+  // the same keyword twice
+  data += data;
+  EXPECT_FALSE(KeywordTable::Deserialize(data.data(), data.size()));
+}
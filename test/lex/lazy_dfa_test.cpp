@@ -0,0 +1,138 @@
+//
+// Created by dxy on 2020/12/15.
+//
+
+#include "gtest/gtest.h"
+#include "lex/lazy_dfa.h"
+
+#include <random>
+#include "environment.h"
+#include "lex/dfa.h"
+#include "lex/nfa.h"
+#include "lex/token.h"
+
+using namespace CCompiler;
+using namespace std;
+
+/**
+ * Check that lazy_dfa finds the same match as nfa at every location of s.
+ *
+ * @param nfa
+ * @param lazy_dfa
+ * @param s
+ */
+void SameAsNfa(const Nfa &nfa, LazyDfa &lazy_dfa, string_view s) {
+  for (auto begin = s.cbegin(); begin != s.cend(); ++begin) {
+    auto nfa_match = nfa.NextMatch(begin, s.cend());
+    auto lazy_match = lazy_dfa.NextMatch(begin, s.cend());
+    ASSERT_EQ(nfa_match == nullptr, !lazy_match.has_value());
+    if (nfa_match != nullptr) {
+      EXPECT_EQ(nfa_match->first, lazy_match->first);
+      EXPECT_EQ(nfa_match->second, lazy_match->second);
+    }
+  }
+}
+
+/**
+ * @param size
+ * @return random 'a' and 'b'
+ */
+string RandomAb(int size) {
+  mt19937 engine(2020);
+  string s;
+  for (int i = 0; i < size; ++i) {
+    s += "ab"[engine() % 2];
+  }
+  return s;
+}
+
+TEST(LazyDfa, Rules) {
+  Nfa nfa(Environment::GetRegexRules());
+  LazyDfa lazy_dfa(nfa);
+  string_view s = "int main() {\n"
+                  "  char *s = \"while\\\"\";  /* comment */\n"
+                  "  return 0x1fu + 'a' >>= 2.5e-3;  // while1\n"
+                  "}";
+
+  SameAsNfa(nfa, lazy_dfa, s);
+  EXPECT_EQ(lazy_dfa.FlushCount(), 0);
+  // only states reached by s are built
+  EXPECT_LT(lazy_dfa.StateCount(), Dfa(nfa).StateCount());
+}
+
+TEST(LazyDfa, Flush) {
+  Nfa nfa(Environment::GetRegexRules());
+  // room for only a few states
+  LazyDfa lazy_dfa(nfa, 1);
+  string_view s = "int a = 1;\n";
+  string text;
+  for (int i = 0; i < 64; ++i) {
+    text += s;
+  }
+
+  SameAsNfa(nfa, lazy_dfa, text);
+  EXPECT_GT(lazy_dfa.FlushCount(), 0);
+}
+
+TEST(LazyDfa, Explosion) {
+  // the full DFA needs 2^13 states to remember the last 13 characters
+  Nfa nfa({{"[ab]*a[ab]{12}", TokenType::kIdentifier}});
+  EXPECT_TRUE(Dfa(nfa, 1000).Empty());
+
+  LazyDfa lazy_dfa(nfa);
+  SameAsNfa(nfa, lazy_dfa, RandomAb(256));
+  EXPECT_FALSE(lazy_dfa.Thrashing());
+}
+
+TEST(LazyDfa, Thrashing) {
+  Nfa nfa({{"[ab]*a[ab]{12}", TokenType::kIdentifier}});
+  LazyDfa lazy_dfa(nfa, 4096);
+
+  SameAsNfa(nfa, lazy_dfa, RandomAb(256));
+  EXPECT_TRUE(lazy_dfa.Thrashing());
+}
+
+/**
+ * Check that matches searched from left to right are the same with and
+ * without a LazyDfa::FailureMemo.
+ *
+ * @param nfa
+ * @param memory_limit
+ * @param s
+ */
+void SameWithMemo(const Nfa &nfa, size_t memory_limit, string_view s) {
+  LazyDfa lazy_dfa(nfa, memory_limit), memo_lazy_dfa(nfa, memory_limit);
+  LazyDfa::FailureMemo memo;
+
+  for (auto begin = s.cbegin(); begin != s.cend();) {
+    auto match = lazy_dfa.NextMatch(begin, s.cend());
+    auto memo_match = memo_lazy_dfa.NextMatch(begin, s.cend(), &memo);
+    ASSERT_EQ(match.has_value(), memo_match.has_value());
+    if (!match || match->second == begin) {
+      begin++;
+      continue;
+    }
+    EXPECT_EQ(match->first, memo_match->first);
+    ASSERT_EQ(match->second, memo_match->second);
+    begin = match->second;
+  }
+}
+
+TEST(LazyDfa, FailureMemo) {
+  // every 'a' starts a scan to the next 'c' or the end
+  Nfa nfa({{"a[ab]*c",   TokenType::kIdentifier},
+           {"(?:ab)+",   TokenType::kNumber},
+           {"b",         TokenType::kString}});
+  auto text = RandomAb(512);
+  SameWithMemo(nfa, LazyDfa::kDefaultMemoryLimit, text);
+  SameWithMemo(nfa, LazyDfa::kDefaultMemoryLimit, text + "c" + text);
+
+  Nfa rules(Environment::GetRegexRules());
+  string source = "int main() {\n"
+                  "  char *s = \"while\\\"\";  /* comment */\n"
+                  "  return 0x1fu + 'a' >>= 2.5e-3;  // while1\n"
+                  "}";
+  SameWithMemo(rules, LazyDfa::kDefaultMemoryLimit, source);
+  // failures are dropped with flushed states
+  SameWithMemo(rules, 1, source);
+}
@@ -5,7 +5,14 @@
 #include "gtest/gtest.h"
 #include "lex/lexer.h"
 
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
 #include "environment.h"
+#include "lex/source_buffer.h"
 #include "lex/token.h"
 
 using namespace CCompiler;
@@ -68,6 +75,48 @@ TEST(Lexer, BlockComment) {
   NextStream(tokens, source);
 }
 
+TEST(Lexer, MultiLineComment) {
+  string source("int a; /*/ int b;\r\n"
+                "   * int c; ** /\r\n"
+                "   */ int d; /**/ int e;");
+  vector<string> tokens{{"int", "a", ";", "int", "d", ";", "int", "e", ";"}};
+
+  NextStream(tokens, source);
+}
+
+TEST(Lexer, MultiLineString) {
+  string source("char *s = \"ab\\\ncd\\\r\n\";\n"
+                "char *t = \"ef\n"
+                "int i = 'g;\n"
+                "char c = '\\n';");
+  vector<string> tokens{{"char", "*", "s", "=", "\"ab\\\ncd\\\r\n\"", ";",
+                                "char", "*", "t", "=",
+                                "int", "i", "=",
+                                "char", "c", "=", "'\\n'", ";"}};
+
+  NextStream(tokens, source);
+}
+
+TEST(Lexer, Location) {
+  Lexer lexer(string("int a;\r\n"
+                     "/* comment\n"
+                     " */  char $b;\n"
+                     "\n"
+                     "  \"s\""));
+  vector<tuple<string, int, int>> locations{
+          {"int", 1, 0}, {"a", 1, 4}, {";", 1, 5},
+          {"char", 3, 5}, {"b", 3, 11}, {";", 3, 12},
+          {"\"s\"", 5, 2}};
+
+  for (auto &[token, line, column]:locations) {
+    auto next = lexer.Next();
+    EXPECT_EQ(next.GetToken(), token);
+    EXPECT_EQ(lexer.GetLocation(next).line, line);
+    EXPECT_EQ(lexer.GetLocation(next).column, column);
+  }
+  EXPECT_TRUE(lexer.Next().Empty());
+}
+
 TEST(Lexer, InvalidToken) {
   string source("int $i;");
   vector<string> tokens{{"int", "i", ";"}};
@@ -98,4 +147,194 @@ TEST(Lexer, Rollback) {
 
   lexer.Rollback(token);
   EXPECT_EQ(token.GetToken(), ";");
-}
\ No newline at end of file
+}
+
+TEST(Lexer, MappedFile) {
+  auto path = (filesystem::temp_directory_path() / "lexer_test.c").string();
+  {
+    ofstream file(path, ios::binary);
+    file << "int main() {\n"
+            "  return 'a'; /* comment\n"
+            "*/}";
+  }
+  auto source = SourceBuffer::Open(path);
+  ASSERT_NE(source, nullptr);
+  filesystem::remove(path);
+
+  Lexer lexer(source);
+  auto text = source->GetText();
+  vector<string> tokens{{"int", "main", "(", ")", "{",
+                                "return", "'a'", ";", "}"}};
+  Token token;
+  while (!(token = lexer.Next()).Empty()) {
+    // tokens are views into the mapped file
+    EXPECT_GE(token.GetToken().data(), text.data());
+    EXPECT_LE(token.GetToken().data() + token.GetToken().size(),
+              text.data() + text.size());
+    EXPECT_EQ(token.GetToken(), tokens.front());
+    tokens.erase(tokens.cbegin());
+  }
+  EXPECT_TRUE(tokens.empty());
+  EXPECT_EQ(SourceBuffer::Open(path), nullptr);
+}
+
+TEST(Lexer, Stream) {
+  string text;
+  for (int i = 0; i < 128; ++i) {
+    auto n = to_string(i);
+    text += "int a" + n + " = " + n + ";  /* " + string(i % 3, '\n') +
+            "*/ int b" + n + ";\r\n" +
+            "// int c" + n + ";\n" +
+            "char *s" + n + " = \"x\\\n" + string(i % 5, 'y') + "\";\n";
+  }
+  text += "int end; /* unclosed";
+  auto path = (filesystem::temp_directory_path() / "lexer_test.c").string();
+  {
+    ofstream file(path, ios::binary);
+    file << text;
+  }
+
+  Lexer lexer(text);
+  vector<Token> expected;
+  vector<SourceLocation> locations;
+  Token token;
+  while (!(token = lexer.Next()).Empty()) {
+    expected.push_back(token);
+    locations.push_back(lexer.GetLocation(token));
+  }
+
+  // windows shorter than some lexemes together with their lines
+  for (auto buffer_size:{40, 41, 64, 100, 1 << 16}) {
+    auto fd = open(path.c_str(), O_RDONLY);
+    ASSERT_NE(fd, -1);
+    Lexer stream_lexer(fd, buffer_size);
+    for (int i = 0; i < expected.size(); ++i) {
+      // peeked tokens stay valid when the window is refilled
+      auto peeked = stream_lexer.Peek();
+      token = stream_lexer.Next();
+      EXPECT_EQ(peeked.GetToken(), expected[i].GetToken());
+      EXPECT_EQ(token.GetToken(), expected[i].GetToken());
+      EXPECT_EQ(token.GetType(), expected[i].GetType());
+      EXPECT_EQ(token.GetOffset(), expected[i].GetOffset());
+      EXPECT_EQ(stream_lexer.GetLocation(token).line, locations[i].line);
+      EXPECT_EQ(stream_lexer.GetLocation(token).column, locations[i].column);
+    }
+    EXPECT_TRUE(stream_lexer.Next().Empty());
+    close(fd);
+  }
+
+  // tokens peeked across many refills grow the window
+  auto fd = open(path.c_str(), O_RDONLY);
+  ASSERT_NE(fd, -1);
+  Lexer stream_lexer(fd, 40);
+  for (int i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(stream_lexer.Peek().GetToken(), expected[i].GetToken());
+  }
+  EXPECT_TRUE(stream_lexer.Peek().Empty());
+  for (int i = 0; i < expected.size(); ++i) {
+    token = stream_lexer.Next();
+    EXPECT_EQ(token.GetToken(), expected[i].GetToken());
+    EXPECT_EQ(token.GetOffset(), expected[i].GetOffset());
+  }
+  EXPECT_TRUE(stream_lexer.Next().Empty());
+  close(fd);
+  filesystem::remove(path);
+}
+
+/**
+ * @param lexer
+ * @return the remaining tokens of lexer
+ */
+vector<string> LexAll(Lexer &lexer) {
+  vector<string> tokens;
+  Token token;
+  while (!(token = lexer.Next()).Empty()) {
+    tokens.emplace_back(token.GetToken());
+  }
+  return tokens;
+}
+
+TEST(Lexer, IndependentInstances) {
+  // an unclosed comment and a half-read line are left in the first lexer
+  Lexer first("int a; /* comment\nint b;");
+  Lexer second("int c; /* */ d;");
+
+  EXPECT_EQ(first.Next().GetToken(), "int");
+  EXPECT_EQ(second.Next().GetToken(), "int");
+  EXPECT_EQ(first.Next().GetToken(), "a");
+  EXPECT_EQ(LexAll(second), (vector<string>{"c", ";", "d", ";"}));
+  EXPECT_EQ(LexAll(first), (vector<string>{";"}));
+
+  Lexer third("int e;");
+  EXPECT_EQ(LexAll(third), (vector<string>{"int", "e", ";"}));
+}
+
+TEST(Lexer, ConcurrentLexers) {
+  vector<string> sources;
+  vector<vector<string>> expected;
+  for (int i = 0; i < 16; ++i) {
+    string source;
+    for (int j = 0; j <= i; ++j) {
+      auto n = to_string(j);
+      source += "int f" + n + "(int a) {  /* body\n"
+                "of f" + n + " */\n"
+                "  return a * " + n + "; // end\n"
+                "}\n"
+                "const char *s" + n + " = \"/* not a comment\";\n";
+    }
+    sources.push_back(source);
+    Lexer lexer(source);
+    expected.push_back(LexAll(lexer));
+  }
+
+  atomic<int> mismatches = 0;
+  vector<thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&, i]() {
+        for (int round = 0; round < 32; ++round) {
+          auto k = (i + round) % sources.size();
+          Lexer lexer(sources[k]);
+          if (LexAll(lexer) != expected[k]) {
+            mismatches++;
+          }
+        }
+    });
+  }
+  for (auto &thread:threads) {
+    thread.join();
+  }
+  EXPECT_EQ(mismatches, 0);
+}
+
+TEST(Lexer, LexParallel) {
+  string text;
+  for (int i = 0; i < 64; ++i) {
+    auto n = to_string(i);
+    // comments of different lengths cover chunk boundaries
+    text += "int a" + n + " = " + n + ";  /*" + string(i % 7, '\n') +
+            "int hidden" + n + "; */ int b" + n + ";\n" +
+            "// int c" + n + ";\n" +
+            "\n" +
+            "char *s" + n + " = \"/*\\\n" + string(i % 5, '\n') +
+            "\";\n";
+  }
+  auto source = make_shared<const SourceBuffer>(text);
+
+  Lexer lexer(source);
+  vector<Token> expected;
+  Token token;
+  while (!(token = lexer.Next()).Empty()) {
+    expected.push_back(token);
+  }
+
+  for (int chunk_count = 1; chunk_count <= 32; ++chunk_count) {
+    auto tokens = Lexer::LexParallel(source, chunk_count);
+    ASSERT_EQ(tokens.size(), expected.size());
+    for (int i = 0; i < tokens.size(); ++i) {
+      EXPECT_EQ(tokens[i].GetToken().data(), expected[i].GetToken().data());
+      EXPECT_EQ(tokens[i].GetToken(), expected[i].GetToken());
+      EXPECT_EQ(tokens[i].GetType(), expected[i].GetType());
+      EXPECT_EQ(tokens[i].GetOffset(), expected[i].GetOffset());
+    }
+  }
+}
@@ -4,6 +4,9 @@
 
 #include "gtest/gtest.h"
 #include "lex/nfa.h"
+
+#include <optional>
+#include <thread>
 #include "lex/token.h"
 
 using namespace CCompiler;
@@ -11,7 +14,7 @@ using namespace std;
 
 TEST(Nfa, Alternative) {
   Nfa nfa({{"a|b", TokenType::kEmpty}});
-  string s = "ab";
+  string_view s = "ab";
   auto begin = s.cbegin(), end = s.cend();
 
   auto match_end = nfa.NextMatch(begin, end)->second;
@@ -27,7 +30,7 @@ TEST(Nfa, Alternative) {
 
 TEST(Nfa, And) {
   Nfa nfa({{"ab", TokenType::kEmpty}});
-  string s = "abc";
+  string_view s = "abc";
   auto begin = s.cbegin(), end = s.cend();
 
   auto match_end = nfa.NextMatch(begin, end)->second;
@@ -39,7 +42,7 @@ TEST(Nfa, And) {
 
 TEST(Nfa, Range) {
   Nfa nfa({{"[a-c]", TokenType::kEmpty}});
-  string s = "abc";
+  string_view s = "abc";
   auto begin = s.cbegin(), end = s.cend();
 
   auto match_end = nfa.NextMatch(begin, end)->second;
@@ -59,7 +62,7 @@ TEST(Nfa, Range) {
 
 TEST(Nfa, Quantifier_0Or1) {
   Nfa nfa({{"[a-c]?", TokenType::kEmpty}});
-  string s = "abc";
+  string_view s = "abc";
   auto begin = s.cbegin(), end = s.cend();
 
   auto match_end = nfa.NextMatch(begin, end)->second;
@@ -80,7 +83,7 @@ TEST(Nfa, Quantifier_0Or1) {
 
 TEST(Nfa, Quantifier_0OrMore) {
   Nfa nfa({{"[a-c]*", TokenType::kEmpty}});
-  string s = "abc";
+  string_view s = "abc";
   auto begin = s.cbegin(), end = s.cend();
 
   auto match_end = nfa.NextMatch(begin, end)->second;
@@ -93,7 +96,7 @@ TEST(Nfa, Quantifier_0OrMore) {
 
 TEST(Nfa, Quantifier_1OrMore) {
   Nfa nfa{{{"[a-c]+", TokenType::kEmpty}}};
-  string s = "abcd";
+  string_view s = "abcd";
   auto begin = s.cbegin(), end = s.cend();
 
   auto match_end = nfa.NextMatch(begin, end)->second;
@@ -105,7 +108,7 @@ TEST(Nfa, Quantifier_1OrMore) {
 
 TEST(Nfa, Quantifier_Exact) {
   Nfa nfa({{"[a-c]{2}", TokenType::kEmpty}});
-  string s = "abcd";
+  string_view s = "abcd";
   auto begin = s.cbegin(), end = s.cend();
 
   auto match_end = nfa.NextMatch(begin, end)->second;
@@ -117,7 +120,7 @@ TEST(Nfa, Quantifier_Exact) {
 
 TEST(Nfa, Quantifier_nOrMore) {
   Nfa nfa({{"[a-c]{2,}", TokenType::kEmpty}});
-  string s = "abcd";
+  string_view s = "abcd";
   auto begin = s.cbegin(), end = s.cend();
 
   auto match_end = nfa.NextMatch(begin, end)->second;
@@ -129,7 +132,7 @@ TEST(Nfa, Quantifier_nOrMore) {
 
 TEST(Nfa, Quantifier_mTon) {
   Nfa nfa({{"[a-c]{2,4}", TokenType::kEmpty}});
-  string s = "abcabd";
+  string_view s = "abcabd";
   auto begin = s.cbegin(), end = s.cend();
 
   auto match_end = nfa.NextMatch(begin, end)->second;
@@ -141,7 +144,7 @@ TEST(Nfa, Quantifier_mTon) {
 
 TEST(Nfa, PassiveGroup) {
   Nfa nfa({{"(?:aa)ab", TokenType::kEmpty}});
-  string s = "aaabc";
+  string_view s = "aaabc";
   auto begin = s.cbegin(), end = s.cend();
 
   auto match_end = nfa.NextMatch(begin, end)->second;
@@ -153,7 +156,7 @@ TEST(Nfa, PassiveGroup) {
 
 TEST(Nfa, EscapeCharacter) {
   Nfa nfa({{"\\(a+\\)", TokenType::kEmpty}});
-  string s = "(a)";
+  string_view s = "(a)";
   auto begin = s.cbegin(), end = s.cend();
 
   auto match_end = nfa.NextMatch(begin, end)->second;
@@ -165,7 +168,7 @@ TEST(Nfa, EscapeCharacter) {
 
 TEST(Nfa, NotNewLine) {
   Nfa nfa({{"...", TokenType::kEmpty}});
-  string s = "(a)";
+  string_view s = "(a)";
   auto begin = s.cbegin(), end = s.cend();
 
   auto match_end = nfa.NextMatch(begin, end)->second;
@@ -177,7 +180,7 @@ TEST(Nfa, NotNewLine) {
 
 TEST(Nfa, SpecialPatternInRange) {
   Nfa nfa({{"[\\w]", TokenType::kEmpty}});
-  string s = "a1";
+  string_view s = "a1";
   auto begin = s.cbegin(), end = s.cend();
 
   auto match_end = nfa.NextMatch(begin, end)->second;
@@ -193,7 +196,7 @@ TEST(Nfa, SpecialPatternInRange) {
 
 TEST(Nfa, ExceptRange) {
   Nfa nfa({{"[^abc\\d]", TokenType::kEmpty}});
-  string s = "d";
+  string_view s = "d";
   auto begin = s.cbegin(), end = s.cend();
 
   auto match_end = nfa.NextMatch(begin, end)->second;
@@ -203,16 +206,61 @@ TEST(Nfa, ExceptRange) {
   EXPECT_EQ(nfa.NextMatch(begin, end), nullptr);
 }
 
+TEST(Nfa, RangeBytes) {
+  // ranges and special patterns are folded into one set
+  auto bytes = RangeNfa("[a-c_\\d\\n]").GetBytes();
+  string members = "abc_0123456789\n";
+  for (int c = 0; c < 256; ++c) {
+    bool member = members.find(static_cast<char>(c)) != string::npos;
+    EXPECT_EQ(bytes.Contains(c), member);
+  }
+
+  auto except_bytes = RangeNfa("[^a-c\\s]").GetBytes();
+  for (int c = 0; c < 256; ++c) {
+    bool member = (c < 'a' || c > 'c') && !isspace(c);
+    EXPECT_EQ(except_bytes.Contains(c), member);
+  }
+  // bytes beyond ASCII are only matched by negated ranges
+  EXPECT_TRUE(except_bytes.Contains(0xe4));
+  EXPECT_FALSE(RangeNfa("[\\w]").GetBytes().Contains(0xe4));
+
+  // a trailing '-' is a literal
+  auto dash_bytes = RangeNfa("[a-]").GetBytes();
+  for (int c = 0; c < 256; ++c) {
+    EXPECT_EQ(dash_bytes.Contains(c), c == 'a' || c == '-');
+  }
+}
+
 TEST(Nfa, InvalidRegex) {
   Nfa nfa{{{"a|b|", TokenType::kEmpty}}};
   EXPECT_TRUE(nfa.Empty());
 }
 
+TEST(Nfa, CutEscape) {
+  // a trailing '\\' is itself
+  Nfa trailing{{{"a\\", TokenType::kIdentifier}}};
+  string_view s = "a\\x4";
+  auto match = trailing.NextMatch(s.cbegin(), s.cend());
+  ASSERT_NE(match, nullptr);
+  EXPECT_EQ(string(s.cbegin(), match->second), "a\\");
+
+  // escapes cut short end with the regex
+  for (auto regex:{"\\x4", "\\u12"}) {
+    Nfa nfa{{{regex, TokenType::kIdentifier}}};
+    EXPECT_FALSE(nfa.Empty());
+    EXPECT_EQ(nfa.NextMatch(s.cbegin() + 1, s.cend()), nullptr);
+  }
+  // and so do the groups holding them
+  for (auto regex:{"(a\\", "[a\\", "[\\x]"}) {
+    EXPECT_TRUE(Nfa({{regex, TokenType::kIdentifier}}).Empty());
+  }
+}
+
 TEST(Nfa, MultiRegex) {
   Nfa nfa({{"while",                  TokenType::kWhile},
            {"[a-zA-Z_][a-zA-Z0-9_]*", TokenType::kIdentifier}});
 
-  string s = "while";
+  string_view s = "while";
   auto begin = s.cbegin(), end = s.cend();
 
   auto match = nfa.NextMatch(begin, end);
@@ -231,4 +279,92 @@ TEST(Nfa, MultiRegex) {
 
   begin = match->second;
   EXPECT_EQ(nfa.NextMatch(begin, end), nullptr);
-}
\ No newline at end of file
+}
+TEST(Nfa, InvalidRegexAmongRules) {
+  Nfa nfa({{"a|b|", TokenType::kEmpty},
+           {"c+",   TokenType::kIdentifier}});
+  EXPECT_FALSE(nfa.Empty());
+
+  string_view s = "cca";
+  auto match = nfa.NextMatch(s.cbegin(), s.cend());
+  ASSERT_NE(match, nullptr);
+  EXPECT_EQ(string(s.cbegin(), match->second), "cc");
+  EXPECT_EQ(match->first, TokenType::kIdentifier);
+  EXPECT_EQ(nfa.NextMatch(match->second, s.cend()), nullptr);
+}
+
+TEST(Nfa, LongToken) {
+  Nfa nfa({{"[a-zA-Z_][a-zA-Z0-9_]*", TokenType::kIdentifier},
+           {"/\\*|\\*/",              TokenType::kComment}});
+  string text = string(1 << 16, 'a') + "*/";
+  string_view s(text);
+
+  auto match = nfa.NextMatch(s.cbegin(), s.cend());
+  ASSERT_NE(match, nullptr);
+  EXPECT_EQ(match->first, TokenType::kIdentifier);
+  EXPECT_EQ(match->second, s.cend() - 2);
+
+  match = nfa.NextMatch(match->second, s.cend());
+  ASSERT_NE(match, nullptr);
+  EXPECT_EQ(match->first, TokenType::kComment);
+  EXPECT_EQ(match->second, s.cend());
+}
+
+TEST(Nfa, ConcurrentBuild) {
+  map<string, TokenType> rules{
+          {"[a-zA-Z_][a-zA-Z0-9_]*", TokenType::kIdentifier},
+          {"0x[0-9a-f]+|[0-9]+",     TokenType::kNumber},
+          {"\"(\\\\.|[^\"])*\"",     TokenType::kString}};
+  Nfa expected(rules);
+  string_view s = "0x1f";
+
+  // states are numbered by each NFA, so builds don't share any counter
+  vector<optional<Nfa>> nfas(8);
+  vector<thread> threads;
+  for (auto &nfa:nfas) {
+    threads.emplace_back([&]() {
+        nfa.emplace(rules);
+    });
+  }
+  for (auto &thread:threads) {
+    thread.join();
+  }
+
+  for (auto &nfa:nfas) {
+    EXPECT_EQ(nfa->StateCount(), expected.StateCount());
+    auto match = nfa->NextMatch(s.cbegin(), s.cend());
+    ASSERT_NE(match, nullptr);
+    EXPECT_EQ(match->first, TokenType::kNumber);
+    EXPECT_EQ(match->second, s.cend());
+  }
+}
+
+TEST(Nfa, RegexAst) {
+  RegexAst ast;
+  string_view regex = "a(?:b(?:c|d)e)+f";
+  auto head = ast.Parse(regex);
+  ASSERT_NE(head, RegexAst::kNoNode);
+
+  // a & (b & (c | d) & e)+ & f, with nodes viewing into regex
+  auto &root = ast.GetNode(head);
+  EXPECT_EQ(root.regex_type, RegexPart::kAnd);
+  EXPECT_EQ(ast.GetNode(root.right_son).regex, "f");
+  EXPECT_EQ(ast.GetNode(root.right_son).regex.data(), regex.data() + 15);
+  auto &left = ast.GetNode(root.left_son);
+  EXPECT_EQ(left.regex_type, RegexPart::kAnd);
+  EXPECT_EQ(ast.GetNode(left.left_son).regex, "a");
+  auto &group = ast.GetNode(left.right_son);
+  EXPECT_EQ(group.regex_type, RegexPart::kQuantifier);
+  EXPECT_EQ(group.regex, "+");
+  EXPECT_EQ(ast.GetNode(group.left_son).regex_type, RegexPart::kAnd);
+
+  // an invalid group is an empty son, and nothing is left on the stacks
+  head = ast.Parse("a(?:b|)");
+  ASSERT_NE(head, RegexAst::kNoNode);
+  EXPECT_EQ(ast.GetNode(head).right_son, RegexAst::kNoNode);
+  EXPECT_EQ(ast.Parse("a|"), RegexAst::kNoNode);
+  ast.Clear();
+  head = ast.Parse("x|y");
+  ASSERT_EQ(head, 1);
+  EXPECT_EQ(ast.GetNode(ast.GetNode(head).right_son).regex, "y");
+}
@@ -0,0 +1,98 @@
+//
+// Created by dxy on 2020/12/16.
+//
+
+#include "gtest/gtest.h"
+#include "lex/scanner.h"
+
+#include "environment.h"
+#include "lex/nfa.h"
+#include "lex/token.h"
+
+using namespace CCompiler;
+using namespace std;
+
+/**
+ * Check that scanner finds the same matches as Nfa::NextMatch() at every
+ * location of s.
+ *
+ * @param rules
+ * @param scanner
+ * @param s
+ */
+void SameAsNextMatch(const map<string, TokenType> &rules, Scanner &scanner,
+                     string_view s) {
+  Nfa nfa(rules);
+  vector<Token> expected;
+  for (auto begin = s.cbegin(); begin != s.cend();) {
+    auto match = nfa.NextMatch(begin, s.cend());
+    if (match == nullptr || match->second == begin) {
+      begin++;
+      continue;
+    }
+    expected.emplace_back(string_view(begin, match->second), match->first,
+                          begin - s.cbegin());
+    begin = match->second;
+  }
+
+  auto tokens = scanner.FindAll(s);
+  ASSERT_EQ(tokens.size(), expected.size());
+  for (int i = 0; i < tokens.size(); ++i) {
+    EXPECT_EQ(tokens[i].GetToken(), expected[i].GetToken());
+    EXPECT_EQ(tokens[i].GetType(), expected[i].GetType());
+    EXPECT_EQ(tokens[i].GetOffset(), expected[i].GetOffset());
+  }
+}
+
+TEST(Scanner, Literal) {
+  map<string, TokenType> rules{{"ERROR [0-9]+", TokenType::kNumber},
+                               {"E(?:RR)?!",    TokenType::kString}};
+  Scanner scanner(rules);
+  EXPECT_EQ(scanner.StartByteCount(), 1);
+
+  string_view s = "INFO 1\nERROR 42\nERROR x\nEE!ERR!ERROR 7";
+  auto tokens = scanner.FindAll(s);
+  ASSERT_EQ(tokens.size(), 4);
+  EXPECT_EQ(tokens[0].GetToken(), "ERROR 42");
+  EXPECT_EQ(tokens[0].GetType(), TokenType::kNumber);
+  EXPECT_EQ(tokens[0].GetOffset(), 7);
+  EXPECT_EQ(tokens[1].GetToken(), "E!");
+  EXPECT_EQ(tokens[2].GetToken(), "ERR!");
+  EXPECT_EQ(tokens[2].GetType(), TokenType::kString);
+  EXPECT_EQ(tokens[3].GetToken(), "ERROR 7");
+  SameAsNextMatch(rules, scanner, s);
+}
+
+TEST(Scanner, StartBytes) {
+  // optional and repeated heads let later parts begin a match
+  map<string, TokenType> rules{{"a*b?c",           TokenType::kIdentifier},
+                               {"(?:x{0,2}|y)[0-3]", TokenType::kNumber},
+                               {"\\d\\.",          TokenType::kString}};
+  Scanner scanner(rules);
+  // a b c x y and digits
+  EXPECT_EQ(scanner.StartByteCount(), 15);
+  SameAsNextMatch(rules, scanner,
+                  "zzaac bc c xx2 y3 xxx1 9. 4 aab zc 0 x");
+
+  // scattered bytes aren't ranges
+  map<string, TokenType> scattered{{"[acegikmoqs]z", TokenType::kIdentifier}};
+  Scanner scattered_scanner(scattered);
+  EXPECT_EQ(scattered_scanner.StartByteCount(), 10);
+  SameAsNextMatch(scattered, scattered_scanner, "abz cz zz sz qqz k");
+}
+
+TEST(Scanner, Rules) {
+  auto &rules = Environment::GetRegexRules();
+  Scanner scanner(rules);
+  SameAsNextMatch(rules, scanner,
+                  "int main() {\n"
+                  "  char *s = \"while\\\"\";  /* comment */ $ @\n"
+                  "  return 0x1fu + 'a' >>= 2.5e-3;  // while1\n"
+                  "}");
+}
+
+TEST(Scanner, InvalidRules) {
+  map<string, TokenType> rules{{"a|b|", TokenType::kIdentifier}};
+  Scanner scanner(rules);
+  EXPECT_TRUE(scanner.FindAll("aabb").empty());
+}
@@ -0,0 +1,63 @@
+//
+// Created by dxy on 2020/12/17.
+//
+
+#include "gtest/gtest.h"
+#include "lex/symbol.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace CCompiler;
+using namespace std;
+
+TEST(Symbol, Intern) {
+  SymbolTable table;
+  auto main = table.Intern("main");
+  string spelling = "main";
+  EXPECT_EQ(table.Intern(spelling), main);
+  EXPECT_NE(table.Intern("mai"), main);
+  EXPECT_EQ(table.GetSpelling(main), "main");
+  // the spelling is copied into the table
+  EXPECT_NE(table.GetSpelling(main).data(), spelling.data());
+
+  EXPECT_TRUE(table.Intern("").Empty());
+  EXPECT_EQ(table.GetSpelling(Symbol()), "");
+  EXPECT_EQ(table.Size(), 2);
+}
+
+TEST(Symbol, Global) {
+  Symbol symbol("global_symbol");
+  EXPECT_EQ(symbol, SymbolTable::Global().Intern("global_symbol"));
+  EXPECT_EQ(symbol.GetSpelling(), "global_symbol");
+  EXPECT_TRUE(Symbol("").Empty());
+}
+
+TEST(Symbol, ConcurrentIntern) {
+  SymbolTable table;
+  const int kSpellings = 1000;
+
+  // every thread interns the same spellings in a different order
+  vector<vector<Symbol>> symbols(8, vector<Symbol>(kSpellings));
+  vector<thread> threads;
+  for (int i = 0; i < symbols.size(); ++i) {
+    threads.emplace_back([&, i]() {
+        for (int j = 0; j < kSpellings; ++j) {
+          auto k = (j * 7 + i * 131) % kSpellings;
+          symbols[i][k] = table.Intern("ident_" + to_string(k));
+        }
+    });
+  }
+  for (auto &thread:threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(table.Size(), kSpellings);
+  for (int k = 0; k < kSpellings; ++k) {
+    for (auto &thread_symbols:symbols) {
+      EXPECT_EQ(thread_symbols[k], symbols[0][k]);
+    }
+    EXPECT_EQ(table.GetSpelling(symbols[0][k]), "ident_" + to_string(k));
+  }
+}
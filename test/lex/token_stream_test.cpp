@@ -0,0 +1,54 @@
+//
+// Created by dxy on 2020/12/14.
+//
+
+#include "gtest/gtest.h"
+#include "lex/token_stream.h"
+
+#include "lex/lexer.h"
+#include "lex/source_buffer.h"
+
+using namespace CCompiler;
+using namespace std;
+
+TEST(TokenStream, SameAsNext) {
+  auto source = make_shared<const SourceBuffer>(
+          "int main() {\r\n"
+          "  /* comment\n"
+          "  */ char *s = \"abc\";  // comment\n"
+          "\n"
+          "  return s[0] == 'a';\n"
+          "}");
+  Lexer lexer(source), stream_lexer(source);
+  auto stream = stream_lexer.TokenizeAll();
+
+  Token token;
+  size_t i = 0;
+  while (!(token = lexer.Next()).Empty()) {
+    ASSERT_LT(i, stream.Size());
+    EXPECT_EQ(stream.GetToken(i), token.GetToken());
+    EXPECT_EQ(stream.GetType(i), token.GetType());
+    EXPECT_EQ(stream.GetOffset(i), token.GetOffset());
+    EXPECT_EQ(stream.GetLocation(i).line, lexer.GetLocation(token).line);
+    EXPECT_EQ(stream.GetLocation(i).column, lexer.GetLocation(token).column);
+    EXPECT_EQ(stream.At(i).GetToken(), token.GetToken());
+    i++;
+  }
+  EXPECT_EQ(i, stream.Size());
+  EXPECT_TRUE(stream_lexer.Next().Empty());
+}
+
+TEST(TokenStream, AfterPeek) {
+  Lexer lexer(string("int a = 1;"));
+  EXPECT_EQ(lexer.Next().GetToken(), "int");
+  EXPECT_EQ(lexer.Peek().GetToken(), "a");
+
+  auto stream = lexer.TokenizeAll();
+  ASSERT_EQ(stream.Size(), 4);
+  EXPECT_EQ(stream.GetToken(0), "a");
+  EXPECT_EQ(stream.GetType(0), TokenType::kIdentifier);
+  EXPECT_EQ(stream.GetOffset(0), 4);
+  EXPECT_EQ(stream.GetToken(3), ";");
+  EXPECT_EQ(stream.GetLocation(3).line, 1);
+  EXPECT_EQ(stream.GetLocation(3).column, 9);
+}
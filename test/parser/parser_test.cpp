@@ -25,7 +25,7 @@ TEST(Parser, EmptyMain) {
   trans_unit->AddExternalDef(new FuncDecl(
           new Function(new QualType(QualType::Specifier::kInt, 0),
                        Identifier::Linkage::kNone,
-                       "main",
+                       Symbol("main"),
                        Function::ParamList(),
                        new CompoundStmt(new Scope(Scope::ScopeType::kBlock,
                                                   trans_unit->GetScope())))));
@@ -33,6 +33,24 @@ TEST(Parser, EmptyMain) {
   TestAst("int main() {}", trans_unit);
 }
 
+TEST(Parser, Directives) {
+  auto trans_unit = new TranslationUnit();
+  trans_unit->AddExternalDef(new FuncDecl(
+          new Function(new QualType(QualType::Specifier::kInt, 0),
+                       Identifier::Linkage::kNone,
+                       Symbol("main"),
+                       Function::ParamList(),
+                       new CompoundStmt(new Scope(Scope::ScopeType::kBlock,
+                                                  trans_unit->GetScope())))));
+
+  TestAst("#define MAIN\n"
+          "#ifndef MAIN\n"
+          "int other() {}\n"
+          "#endif\n"
+          "int main() {}",
+          trans_unit);
+}
+
 TEST(Parser, UninitializedObj) {
   auto trans_unit = new TranslationUnit();
   trans_unit->AddExternalDef(new ObjectDecl(
@@ -41,7 +59,7 @@ TEST(Parser, UninitializedObj) {
                                QualType::Specifier::kUnsigned,
                                0),
                   Identifier::Linkage::kNone,
-                  "i"),
+                  Symbol("i")),
                      0),
           nullptr));
 
@@ -56,7 +74,7 @@ TEST(Parser, InitializedObj) {
                   new Identifier(new QualType(QualType::Specifier::kInt,
                                               Qualifier::kEmpty),
                                  CCompiler::Identifier::Linkage::kNone,
-                                 "i"),
+                                 Symbol("i")),
                   0),
           new BaseInitializer(0, new Constant(0))));
 
@@ -69,13 +87,14 @@ class FuncBodyTest : public ::testing::Test {
  protected:
   void SetUp() override {
     tu_ = new TranslationUnit();
+    body_ = new CompoundStmt(new Scope(Scope::ScopeType::kBlock,
+                                       tu_->GetScope()));
     tu_->AddExternalDef(new FuncDecl(
             new Function(new QualType(QualType::Specifier::kInt, 0),
                          Identifier::Linkage::kNone,
-                         "main",
+                         Symbol("main"),
                          Function::ParamList(),
-                         new CompoundStmt(new Scope(Scope::ScopeType::kBlock,
-                                                    tu_->GetScope())))));
+                         body_)));
   }
 
   TranslationUnit *tu_;
@@ -87,7 +106,7 @@ class FuncBodyTest : public ::testing::Test {
 TEST_F(FuncBodyTest, ForStmt) {
   auto obj = new Object(
           new Identifier(new QualType(QualType::Specifier::kInt, 0),
-                         Identifier::Linkage::kNone, "i"),
+                         Identifier::Linkage::kNone, Symbol("i")),
           0);
   auto obj_decl = new ObjectDecl(obj, new BaseInitializer(0, new Constant(0)));
   auto for_scope = new Scope(Scope::ScopeType::kBlock, body_->GetOwnedScope());
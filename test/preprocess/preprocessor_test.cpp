@@ -0,0 +1,342 @@
+//
+// Created by dxy on 2020/12/18.
+//
+
+#include "gtest/gtest.h"
+#include "preprocess/preprocessor.h"
+
+#include <filesystem>
+#include <fstream>
+#include "lex/source_buffer.h"
+#include "preprocess/header_cache.h"
+#include "preprocess/hide_set.h"
+
+using namespace CCompiler;
+using namespace std;
+
+/**
+ * @param preprocessor
+ * @return spellings of all tokens left joined by ' '
+ */
+string Preprocess(Preprocessor &preprocessor) {
+  string text;
+  Token token;
+  while (!(token = preprocessor.Next()).Empty()) {
+    text += (text.empty() ? "" : " ") + string(token.GetToken());
+  }
+  return text;
+}
+
+/**
+ * @param source
+ * @return spellings of the tokens of source after preprocessing
+ */
+string Preprocess(const string &source) {
+  HeaderCache cache;
+  Preprocessor preprocessor(make_shared<const SourceBuffer>(source), "", {},
+                            cache);
+  return Preprocess(preprocessor);
+}
+
+/**
+ * @param source
+ * @return the include guard of source
+ */
+string GetGuard(const string &source) {
+  LexedFile file(make_shared<const SourceBuffer>(source));
+  return string(file.GetGuard().GetSpelling());
+}
+
+TEST(LexedFile, LineStarts) {
+  LexedFile file(make_shared<const SourceBuffer>(
+          "#define X \\\n"
+          "  1 /* comment\n"
+          "*/ 2 // comment\n"
+          "  # if\r\n"
+          "x"));
+  vector<bool> line_starts{true, false, false, false, false,
+                           true, false, true};
+  ASSERT_EQ(file.Size(), line_starts.size());
+  for (size_t i = 0; i < file.Size(); ++i) {
+    EXPECT_EQ(file.AtLineStart(i), line_starts[i]) << i;
+  }
+
+  EXPECT_EQ(file.LineEnd(0), 5);
+  EXPECT_EQ(file.GetDirective(0), "define");
+  EXPECT_EQ(file.NextDirective(1), 5);
+  EXPECT_EQ(file.NextDirective(6), file.Size());
+}
+
+TEST(LexedFile, Guard) {
+  EXPECT_EQ(GetGuard("#ifndef A_H\n#define A_H\nint a;\n#endif\n"), "A_H");
+  EXPECT_EQ(GetGuard("/* license */\n#if !defined(B_H)\n#endif // B_H"),
+            "B_H");
+  EXPECT_EQ(GetGuard("#if !defined C_H\n#if X\n#else\n#endif\n#endif"),
+            "C_H");
+
+  // the whole file isn't in the group
+  EXPECT_EQ(GetGuard("int a;\n#ifndef A_H\n#endif\n"), "");
+  EXPECT_EQ(GetGuard("#ifndef A_H\n#endif\nint a;\n"), "");
+  EXPECT_EQ(GetGuard("#ifndef A_H\n#else\n#endif\n"), "");
+  EXPECT_EQ(GetGuard("#ifndef A_H\n#endif\n#ifndef B_H\n#endif\n"), "");
+  EXPECT_EQ(GetGuard("#if !defined A_H || 1\n#endif\n"), "");
+  EXPECT_EQ(GetGuard("#ifndef A_H\n"), "");
+}
+
+TEST(Preprocessor, Conditionals) {
+  EXPECT_EQ(Preprocess("#define A\n"
+                       "#ifdef A\n a\n#else\n b\n#endif\n"
+                       "#ifndef A\n c\n#elif 1\n d\n#else\n e\n#endif\n"
+                       "#undef A\n"
+                       "#if defined(A) || !defined B\n f\n#endif\n"),
+            "a d f");
+
+  // nested groups of a skipped group are skipped, whatever they are
+  EXPECT_EQ(Preprocess("#if 0\n"
+                       "#if 1\n a\n#else\n b\n#endif\n"
+                       "#elif 0\n c\n"
+                       "#else\n"
+                       "#if 0\n#elif 1\n d\n#endif\n"
+                       "#endif\n"
+                       "# /* null directive */\n e"),
+            "d e");
+}
+
+TEST(Preprocessor, Expressions) {
+  auto check = [](const string &condition, bool value) {
+      EXPECT_EQ(Preprocess("#if " + condition + "\nyes\n#else\nno\n#endif"),
+                value ? "yes" : "no") << condition;
+  };
+  check("1 + 2 * 3 == 7", true);
+  check("(1 + 2) * 3 == 7", false);
+  check("0x10 == 16 && 010 == 8 && 10u == 10L", true);
+  check("-1 < 0 && ~0 == -1 && !0", true);
+  check("1 << 4 >> 2 == 4", true);
+  check("7 / 2 == 3 && 7 % 2 == 1", true);
+  check("(1 ? 2 : 3) == 3", false);
+  check("0 ? 1 : 2 == 2", true);
+  check("'a' == 97 && '\\n' == 10 && '\\0' == 0", true);
+  check("UNDEFINED == 0 && int == 0", true);
+  // the division isn't evaluated
+  check("0 && 1 / 0", false);
+  check("1 || 1 % 0", true);
+}
+
+TEST(Preprocessor, ObjectLikeMacros) {
+  EXPECT_EQ(Preprocess("#define N 10\n"
+                       "#define M N + N\n"
+                       "M;\n"
+                       "#undef N\n"
+                       "M;\n"
+                       "#define N 20\n"
+                       "M;"),
+            "10 + 10 ; N + N ; 20 + 20 ;");
+
+  // a macro doesn't expand itself
+  EXPECT_EQ(Preprocess("#define x x + 1\nx"), "x + 1");
+  EXPECT_EQ(Preprocess("#define a b\n#define b a\na b"), "a b");
+  EXPECT_EQ(Preprocess("#define int long\nint i;"), "long i ;");
+}
+
+TEST(Preprocessor, FunctionLikeMacros) {
+  EXPECT_EQ(Preprocess("#define max(a, b) ((a) > (b) ? (a) : (b))\n"
+                       "max(1, f(2, 3))"),
+            "( ( 1 ) > ( f ( 2 , 3 ) ) ? ( 1 ) : ( f ( 2 , 3 ) ) )");
+  // a name without '(' isn't a call
+  EXPECT_EQ(Preprocess("#define f(x) x\nf + f(1)"), "f + 1");
+  // "f (" is an object-like macro
+  EXPECT_EQ(Preprocess("#define f (x) x\nf(1)"), "( x ) x ( 1 )");
+  EXPECT_EQ(Preprocess("#define f(x) g(x)\n"
+                       "#define g(x) x * 2\n"
+                       "f(f(1)) f\n"
+                       "(\n"
+                       "1)"),
+            "1 * 2 * 2 1 * 2");
+  EXPECT_EQ(Preprocess("#define f() 1\n#define g(x) [x]\nf() g()"),
+            "1 [ ]");
+  EXPECT_EQ(Preprocess("#define log(format, ...) printf(format, __VA_ARGS__)\n"
+                       "log(\"%d %d\", 1, (2, 3)) log(\"\",)"),
+            "printf ( \"%d %d\" , 1 , ( 2 , 3 ) ) printf ( \"\" , )");
+  // the macro is expanded as it was defined before its arguments
+  EXPECT_EQ(Preprocess("#define f(x) [x]\n"
+                       "f(1\n"
+                       "#undef f\n"
+                       ") f(2)"),
+            "[ 1 ] f ( 2 )");
+  EXPECT_EQ(Preprocess("#define f(x) [x]\n"
+                       "f(1\n"
+                       "#undef f\n"
+                       "#define f(x, y) x + y\n"
+                       ") f(2, 3)"),
+            "[ 1 ] 2 + 3");
+}
+
+TEST(Preprocessor, MacroOperators) {
+  EXPECT_EQ(Preprocess("#define str(x) #x\n"
+                       "str(a  +  \"b\\n\") str() str(f(x,y))"),
+            "\"a + \\\"b\\\\n\\\"\" \"\" \"f(x,y)\"");
+  EXPECT_EQ(Preprocess("#define cat(a, b) a ## b\n"
+                       "cat(x, 1) cat(, y) cat(x,) cat(1, 2) cat(+, =)"),
+            "x1 y x 12 +=");
+
+  // arguments of "##" aren't expanded, but the result is
+  EXPECT_EQ(Preprocess("#define cat(a, b) a##b\n"
+                       "#define A no\n"
+                       "#define AB yes\n"
+                       "cat(A, B) cat(A,)"),
+            "yes no");
+  EXPECT_EQ(Preprocess("#define cat3(a, b, c) a ## b ## c\ncat3(x, , z)"),
+            "xz");
+}
+
+TEST(Preprocessor, StandardExample) {
+  // the example of C11 6.10.3.5
+  string definitions = "#define x 3\n"
+                       "#define f(a) f(x * (a))\n"
+                       "#undef x\n"
+                       "#define x 2\n"
+                       "#define g f\n"
+                       "#define z z[0]\n"
+                       "#define h g(~\n"
+                       "#define m(a) a(w)\n"
+                       "#define w 0,1\n"
+                       "#define t(a) a\n"
+                       "#define p() int\n"
+                       "#define q(x) x\n"
+                       "#define r(x,y) x ## y\n";
+  EXPECT_EQ(Preprocess(definitions +
+                       "f(y+1) + f(f(z)) % t(t(g)(0) + t)(1);\n"
+                       "g(x+(3,4)-w) | h 5) & m\n"
+                       "(f)^m(m);\n"
+                       "p() i[q()] = { q(1), r(2,3), r(4,), r(,5), r(,) };"),
+            Preprocess("f(2 * (y+1)) + f(2 * (f(2 * (z[0])))) % "
+                       "f(2 * (0)) + t(1);\n"
+                       "f(2 * (2+(3,4)-0,1)) | f(2 * (~ 5)) & "
+                       "f(2 * (0,1))^m(0,1);\n"
+                       "int i[] = { 1, 23, 4, 5, };"));
+
+  // the example of C11 6.10.3.3, where "##" pasted isn't an operator
+  EXPECT_EQ(Preprocess("#define hash_hash # ## #\n"
+                       "#define mkstr(a) # a\n"
+                       "#define in_between(a) mkstr(a)\n"
+                       "#define join(c, d) in_between(c hash_hash d)\n"
+                       "char p[] = join(x, y);"),
+            "char p [ ] = \"x ## y\" ;");
+}
+
+TEST(Preprocessor, MacrosInConditions) {
+  EXPECT_EQ(Preprocess("#define V 3\n"
+                       "#define F(x) (x + 1)\n"
+                       "#if F(V) * 2 == 8 && defined F\n"
+                       "yes\n"
+                       "#endif"),
+            "yes");
+}
+
+TEST(HideSetTable, Intern) {
+  HideSetTable table;
+  Symbol a("a"), b("b"), c("c");
+  auto ab = table.Add(table.Add(HideSetTable::kEmpty, a), b);
+  EXPECT_EQ(table.Add(table.Add(HideSetTable::kEmpty, b), a), ab);
+  EXPECT_EQ(table.Add(ab, a), ab);
+  EXPECT_TRUE(table.Contains(ab, a));
+  EXPECT_FALSE(table.Contains(ab, c));
+
+  auto bc = table.Add(table.Add(HideSetTable::kEmpty, c), b);
+  auto abc = table.Union(ab, bc);
+  EXPECT_TRUE(table.Contains(abc, c));
+  EXPECT_EQ(table.Union(bc, ab), abc);
+  EXPECT_EQ(table.Intersect(ab, bc), table.Add(HideSetTable::kEmpty, b));
+  EXPECT_EQ(table.Intersect(ab, HideSetTable::kEmpty), HideSetTable::kEmpty);
+  // {}, {a}, {b}, {a, b}, {c}, {b, c} and {a, b, c}
+  EXPECT_EQ(table.Size(), 7);
+}
+
+class PreprocessorFiles : public testing::Test {
+ protected:
+  void SetUp() override {
+    directory_ = filesystem::temp_directory_path() / "preprocessor_test";
+    filesystem::create_directories(directory_ / "include" / "sys");
+    Write("guarded.h", "#ifndef GUARDED_H\n"
+                       "#define GUARDED_H\n"
+                       "guarded\n"
+                       "#endif\n");
+    Write("once.h", "#pragma once\n"
+                    "once\n");
+    Write("plain.h", "plain\n");
+    Write("include/sys/angled.h", "#include \"../../plain.h\"\n"
+                                  "angled\n");
+    Write("main.c", "#include \"guarded.h\"\n"
+                    "#include \"once.h\"\n"
+                    "#include \"plain.h\"\n"
+                    "#include <sys/angled.h>\n"
+                    "#include \"guarded.h\"\n"
+                    "#include \"once.h\"\n"
+                    "main\n");
+  }
+
+  void TearDown() override {
+    filesystem::remove_all(directory_);
+  }
+
+  void Write(const string &path, const string &text) {
+    ofstream file(directory_ / path, ios::binary);
+    file << text;
+  }
+
+  Preprocessor MakePreprocessor(HeaderCache &cache) {
+    auto path = (directory_ / "main.c").string();
+    return Preprocessor(SourceBuffer::Open(path), path,
+                        {(directory_ / "include").string()}, cache);
+  }
+
+  filesystem::path directory_;
+};
+
+TEST_F(PreprocessorFiles, Include) {
+  HeaderCache cache;
+  auto preprocessor = MakePreprocessor(cache);
+
+  EXPECT_EQ(Preprocess(preprocessor), "guarded once plain plain angled main");
+  EXPECT_EQ(preprocessor.SkippedIncludeCount(), 2);
+  EXPECT_TRUE(preprocessor.IsDefined(Symbol("GUARDED_H")));
+}
+
+TEST_F(PreprocessorFiles, MacroInclude) {
+  Write("main.c", "#define PLAIN \"plain.h\"\n"
+                  "#define ANGLED <sys/angled.h>\n"
+                  "#define STR(x) #x\n"
+                  "#define HEADER(name) STR(name)\n"
+                  "#include PLAIN\n"
+                  "#include ANGLED\n"
+                  "#include HEADER(once.h)\n"
+                  "main\n");
+  HeaderCache cache;
+  auto preprocessor = MakePreprocessor(cache);
+
+  EXPECT_EQ(Preprocess(preprocessor), "plain plain angled once main");
+}
+
+TEST_F(PreprocessorFiles, Cache) {
+  HeaderCache cache;
+  auto first = MakePreprocessor(cache);
+  auto first_tokens = Preprocess(first);
+  auto size = cache.Size();
+  auto guarded = cache.Get((directory_ / "guarded.h").string());
+  ASSERT_NE(guarded, nullptr);
+  EXPECT_EQ(guarded->GetGuard(), Symbol("GUARDED_H"));
+
+  // headers aren't read again, even if they are removed
+  filesystem::remove(directory_ / "plain.h");
+  auto second = MakePreprocessor(cache);
+  EXPECT_EQ(Preprocess(second), first_tokens);
+  EXPECT_EQ(cache.Size(), size);
+  EXPECT_EQ(cache.Get((directory_ / "guarded.h").string()), guarded);
+
+  // the missing file is remembered
+  EXPECT_EQ(cache.Get((directory_ / "missing.h").string()), nullptr);
+  Write("missing.h", "");
+  EXPECT_EQ(cache.Get((directory_ / "missing.h").string()), nullptr);
+  cache.Clear();
+  EXPECT_NE(cache.Get((directory_ / "missing.h").string()), nullptr);
+}